@@ -0,0 +1,209 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <immintrin.h>
+#include <iostream>
+
+// Porter-Duff "over" of a BGRA (CV_8UC4) source onto a BGR (CV_8UC3) destination
+// with per-pixel alpha, in 8-bit integer arithmetic:
+//   straight:      out = (s * a + d * (255 - a)) / 255
+//   premultiplied: out = saturate(s + d * (255 - a) / 255)
+// Divisions by 255 round to nearest; the SIMD kernels are byte-exact with the serial one.
+enum AlphaMode
+{
+    ALPHA_STRAIGHT,
+    ALPHA_PREMULTIPLIED
+};
+
+// round(x / 255) for 0 <= x <= 255 * 255, without a division
+inline int div255(int x)
+{
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+inline void compositeOverRow_Serial(const uchar *src, uchar *dst, int pixels, AlphaMode mode)
+{
+    for (int i = 0; i < pixels; ++i)
+    {
+        const uchar *s = src + 4 * i;
+        uchar *d = dst + 3 * i;
+        int a = s[3];
+        for (int c = 0; c < 3; ++c)
+        {
+            int out;
+            if (mode == ALPHA_STRAIGHT)
+                out = (s[c] * a + d[c] * (255 - a) + 127) / 255;
+            else
+                out = s[c] + (d[c] * (255 - a) + 127) / 255;
+            d[c] = static_cast<uchar>(out > 255 ? 255 : out);
+        }
+    }
+}
+
+// Serial reference, src and dst must have the same size
+inline void compositeOver_Serial(const cv::Mat &src, cv::Mat &dst, AlphaMode mode)
+{
+    if (src.size() != dst.size() || src.type() != CV_8UC4 || dst.type() != CV_8UC3)
+    {
+        std::cerr << "Source must be CV_8UC4 and destination CV_8UC3, with the same size." << std::endl;
+        return;
+    }
+    for (int row = 0; row < src.rows; ++row)
+        compositeOverRow_Serial(src.ptr<uchar>(row), dst.ptr<uchar>(row), src.cols, mode);
+}
+
+// Shuffle tables between 4 packed BGR pixels (12 bytes) and 4 BGRx pixels (16 bytes)
+alignas(16) static const int8_t BGR_TO_BGRX[16] = {0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1};
+alignas(16) static const int8_t BGRX_TO_BGR[16] = {0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1};
+
+// "over" on pixels widened to 16-bit words (B G R A per pixel); the A lane result is discarded
+__attribute__((target("ssse3"))) inline __m128i compositeWords_SSE(__m128i s, __m128i d, AlphaMode mode)
+{
+    __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, 0xFF), 0xFF); // broadcast each pixel's alpha
+    __m128i x = _mm_mullo_epi16(d, _mm_sub_epi16(_mm_set1_epi16(255), a));
+    if (mode == ALPHA_STRAIGHT)
+        x = _mm_add_epi16(x, _mm_mullo_epi16(s, a));
+
+    // div255: x += 128; x = (x + (x >> 8)) >> 8, all in unsigned 16-bit lanes
+    x = _mm_add_epi16(x, _mm_set1_epi16(128));
+    x = _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+    return mode == ALPHA_STRAIGHT ? x : _mm_add_epi16(x, s);
+}
+
+__attribute__((target("avx2"))) inline __m256i compositeWords_AVX2(__m256i s, __m256i d, AlphaMode mode)
+{
+    __m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s, 0xFF), 0xFF);
+    __m256i x = _mm256_mullo_epi16(d, _mm256_sub_epi16(_mm256_set1_epi16(255), a));
+    if (mode == ALPHA_STRAIGHT)
+        x = _mm256_add_epi16(x, _mm256_mullo_epi16(s, a));
+
+    x = _mm256_add_epi16(x, _mm256_set1_epi16(128));
+    x = _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+    return mode == ALPHA_STRAIGHT ? x : _mm256_add_epi16(x, s);
+}
+
+// 16 pixels per step: the 48 destination bytes are spread to BGRx with pshufb,
+// blended in 16-bit lanes against the BGRA source, then packed back to BGR.
+__attribute__((target("ssse3"))) inline void compositeOverRow_SSE(const uchar *src, uchar *dst, int pixels, AlphaMode mode)
+{
+    const __m128i expand = _mm_load_si128(reinterpret_cast<const __m128i *>(BGR_TO_BGRX));
+    const __m128i compress = _mm_load_si128(reinterpret_cast<const __m128i *>(BGRX_TO_BGR));
+    const __m128i zero = _mm_setzero_si128();
+
+    int i = 0;
+    for (; i + 16 <= pixels; i += 16)
+    {
+        __m128i c0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + 3 * i));
+        __m128i c1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + 3 * i + 16));
+        __m128i c2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + 3 * i + 32));
+
+        // Four groups of 4 BGR pixels, each starting at byte 0 of its register
+        __m128i d[4] = {c0, _mm_alignr_epi8(c1, c0, 12), _mm_alignr_epi8(c2, c1, 8), _mm_srli_si128(c2, 4)};
+        __m128i r[4];
+
+        for (int k = 0; k < 4; ++k)
+        {
+            __m128i dx = _mm_shuffle_epi8(d[k], expand);
+            __m128i sx = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 4 * (i + 4 * k)));
+
+            __m128i lo = compositeWords_SSE(_mm_unpacklo_epi8(sx, zero), _mm_unpacklo_epi8(dx, zero), mode);
+            __m128i hi = compositeWords_SSE(_mm_unpackhi_epi8(sx, zero), _mm_unpackhi_epi8(dx, zero), mode);
+            r[k] = _mm_shuffle_epi8(_mm_packus_epi16(lo, hi), compress);
+        }
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 3 * i), _mm_or_si128(r[0], _mm_slli_si128(r[1], 12)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 3 * i + 16), _mm_or_si128(_mm_srli_si128(r[1], 4), _mm_slli_si128(r[2], 8)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 3 * i + 32), _mm_or_si128(_mm_srli_si128(r[2], 8), _mm_slli_si128(r[3], 4)));
+    }
+
+    compositeOverRow_Serial(src + 4 * i, dst + 3 * i, pixels - i, mode);
+}
+
+// Same layout trick as the SSE kernel, with 8 pixels per 256-bit register
+__attribute__((target("avx2"))) inline void compositeOverRow_AVX2(const uchar *src, uchar *dst, int pixels, AlphaMode mode)
+{
+    const __m256i expand = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i *>(BGR_TO_BGRX)));
+    const __m256i compress = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i *>(BGRX_TO_BGR)));
+    const __m256i zero = _mm256_setzero_si256();
+
+    int i = 0;
+    for (; i + 16 <= pixels; i += 16)
+    {
+        __m128i c0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + 3 * i));
+        __m128i c1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + 3 * i + 16));
+        __m128i c2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + 3 * i + 32));
+
+        __m256i d[2] = {_mm256_set_m128i(_mm_alignr_epi8(c1, c0, 12), c0),
+                        _mm256_set_m128i(_mm_srli_si128(c2, 4), _mm_alignr_epi8(c2, c1, 8))};
+        __m128i r[4];
+
+        for (int k = 0; k < 2; ++k)
+        {
+            __m256i dx = _mm256_shuffle_epi8(d[k], expand);
+            __m256i sx = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + 4 * (i + 8 * k)));
+
+            __m256i lo = compositeWords_AVX2(_mm256_unpacklo_epi8(sx, zero), _mm256_unpacklo_epi8(dx, zero), mode);
+            __m256i hi = compositeWords_AVX2(_mm256_unpackhi_epi8(sx, zero), _mm256_unpackhi_epi8(dx, zero), mode);
+            __m256i packed = _mm256_shuffle_epi8(_mm256_packus_epi16(lo, hi), compress);
+            r[2 * k] = _mm256_castsi256_si128(packed);
+            r[2 * k + 1] = _mm256_extracti128_si256(packed, 1);
+        }
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 3 * i), _mm_or_si128(r[0], _mm_slli_si128(r[1], 12)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 3 * i + 16), _mm_or_si128(_mm_srli_si128(r[1], 4), _mm_slli_si128(r[2], 8)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 3 * i + 32), _mm_or_si128(_mm_srli_si128(r[2], 8), _mm_slli_si128(r[3], 4)));
+    }
+
+    compositeOverRow_Serial(src + 4 * i, dst + 3 * i, pixels - i, mode);
+}
+
+// SIMD "over", src and dst must have the same size; dst is updated in place
+inline void compositeOver_SIMD(const cv::Mat &src, cv::Mat &dst, AlphaMode mode)
+{
+    if (src.size() != dst.size() || src.type() != CV_8UC4 || dst.type() != CV_8UC3)
+    {
+        std::cerr << "Source must be CV_8UC4 and destination CV_8UC3, with the same size." << std::endl;
+        return;
+    }
+
+    static const bool useAVX2 = __builtin_cpu_supports("avx2");
+    for (int row = 0; row < src.rows; ++row)
+    {
+        if (useAVX2)
+            compositeOverRow_AVX2(src.ptr<uchar>(row), dst.ptr<uchar>(row), src.cols, mode);
+        else
+            compositeOverRow_SSE(src.ptr<uchar>(row), dst.ptr<uchar>(row), src.cols, mode);
+    }
+}
+
+// Convert straight BGRA to premultiplied BGRA: c = c * a / 255 (rounded)
+inline void premultiplyAlpha(const cv::Mat &src, cv::Mat &dst)
+{
+    dst.create(src.rows, src.cols, CV_8UC4);
+    for (int row = 0; row < src.rows; ++row)
+    {
+        const uchar *s = src.ptr<uchar>(row);
+        uchar *d = dst.ptr<uchar>(row);
+        for (int col = 0; col < src.cols * 4; col += 4)
+        {
+            int a = s[col + 3];
+            d[col] = static_cast<uchar>(div255(s[col] * a));
+            d[col + 1] = static_cast<uchar>(div255(s[col + 1] * a));
+            d[col + 2] = static_cast<uchar>(div255(s[col + 2] * a));
+            d[col + 3] = static_cast<uchar>(a);
+        }
+    }
+}
+
+// Composite a BGRA logo onto dst with its top-left corner at `position`, clipped to dst
+inline void compositeLogo(cv::Mat &dst, const cv::Mat &logo, cv::Point position, AlphaMode mode)
+{
+    cv::Rect placement(position.x, position.y, logo.cols, logo.rows);
+    cv::Rect roi = placement & cv::Rect(0, 0, dst.cols, dst.rows);
+    if (roi.empty())
+        return;
+
+    cv::Mat dstRoi = dst(roi);
+    compositeOver_SIMD(logo(cv::Rect(roi.x - placement.x, roi.y - placement.y, roi.width, roi.height)), dstRoi, mode);
+}
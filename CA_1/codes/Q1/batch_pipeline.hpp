@@ -0,0 +1,255 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "logo_overlay.hpp"
+
+// Blocking FIFO with a fixed capacity; push() waits while full, pop() waits
+// while empty. After close(), pop() drains what is left and then returns false.
+template <typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(size_t capacity) : capacity(capacity), closed(false) {}
+
+    void push(T item)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [this]
+                     { return items.size() < capacity; });
+        items.push_back(std::move(item));
+        notEmpty.notify_one();
+    }
+
+    bool pop(T &item)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [this]
+                      { return !items.empty() || closed; });
+        if (items.empty())
+            return false;
+        item = std::move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        notEmpty.notify_all();
+    }
+
+private:
+    size_t capacity;
+    bool closed;
+    std::deque<T> items;
+    std::mutex mutex;
+    std::condition_variable notEmpty, notFull;
+};
+
+// Fixed set of reusable image buffers. acquire() blocks when every buffer is
+// in flight, which bounds memory and throttles the decoders.
+class MatPool
+{
+public:
+    explicit MatPool(size_t size) : free(size)
+    {
+        for (size_t i = 0; i < size; ++i)
+            free.push(cv::Mat());
+    }
+
+    cv::Mat acquire()
+    {
+        cv::Mat m;
+        free.pop(m);
+        return m;
+    }
+
+    void release(cv::Mat m) { free.push(std::move(m)); }
+
+private:
+    BoundedQueue<cv::Mat> free;
+};
+
+struct BatchJob
+{
+    std::string inputPath;
+    std::string outputPath;
+    cv::Mat image;
+};
+
+struct BatchStats
+{
+    size_t images = 0;
+    size_t failed = 0;
+    double seconds = 0;
+    double decodeBusy = 0, blendBusy = 0, encodeBusy = 0; // summed over the stage's threads
+    int decoders = 0, blenders = 0, encoders = 0;
+};
+
+struct BatchOptions
+{
+    int decoders = 0; // 0 = half the cores
+    int blenders = 1;
+    int encoders = 0; // 0 = half the cores
+    int queueDepth = 8;
+    cv::Point logoPosition = cv::Point(0, 0);
+};
+
+inline bool isImageFile(const std::filesystem::path &p)
+{
+    std::string ext = p.extension().string();
+    for (char &ch : ext)
+        ch = static_cast<char>(tolower(ch));
+    return ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".bmp" || ext == ".tif" || ext == ".tiff" || ext == ".webp";
+}
+
+// Watermark every image of inputDir into outputDir with a three-stage pipeline:
+//   decode (parallel imdecode into pooled buffers) -> blend (SIMD ROI overlay,
+//   in place) -> encode (parallel imwrite, buffer returned to the pool).
+// Stages are connected by bounded queues so codec work overlaps the blend.
+inline BatchStats watermarkDirectory(const std::string &inputDir, const std::string &outputDir, const cv::Mat &logo, float alpha, BatchOptions opt = BatchOptions())
+{
+    namespace fs = std::filesystem;
+    using clock = std::chrono::steady_clock;
+
+    BatchStats stats;
+    int cores = std::max(1u, std::thread::hardware_concurrency());
+    stats.decoders = opt.decoders > 0 ? opt.decoders : std::max(1, cores / 2);
+    stats.encoders = opt.encoders > 0 ? opt.encoders : std::max(1, cores / 2);
+    stats.blenders = std::max(1, opt.blenders);
+
+    std::vector<std::string> files;
+    for (const auto &entry : fs::directory_iterator(inputDir))
+        if (entry.is_regular_file() && isImageFile(entry.path()))
+            files.push_back(entry.path().string());
+    std::sort(files.begin(), files.end());
+    fs::create_directories(outputDir);
+
+    // Every image in flight holds one pool buffer: queued for blend, queued for encode, or in a worker
+    MatPool pool(2 * opt.queueDepth + stats.decoders + stats.blenders + stats.encoders);
+    BoundedQueue<BatchJob> toBlend(opt.queueDepth), toEncode(opt.queueDepth);
+    std::atomic<size_t> nextFile(0), failed(0);
+    std::mutex statsMutex;
+
+    LogoOverlay overlay(logo, alpha);
+
+    auto busySince = [](clock::time_point t)
+    {
+        return std::chrono::duration<double>(clock::now() - t).count();
+    };
+
+    auto decodeWorker = [&]
+    {
+        double busy = 0;
+        std::vector<uchar> bytes;
+        size_t idx;
+        while ((idx = nextFile++) < files.size())
+        {
+            BatchJob job;
+            job.inputPath = files[idx];
+            job.outputPath = (fs::path(outputDir) / fs::path(files[idx]).filename()).string();
+            job.image = pool.acquire();
+
+            auto t = clock::now();
+            std::ifstream in(job.inputPath, std::ios::binary);
+            bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+            if (!bytes.empty())
+                cv::imdecode(bytes, cv::IMREAD_COLOR, &job.image); // reuses the pooled buffer when the size matches
+            busy += busySince(t);
+
+            if (bytes.empty() || job.image.empty())
+            {
+                ++failed;
+                pool.release(std::move(job.image));
+                continue;
+            }
+            toBlend.push(std::move(job));
+        }
+        std::lock_guard<std::mutex> lock(statsMutex);
+        stats.decodeBusy += busy;
+    };
+
+    auto blendWorker = [&]
+    {
+        double busy = 0;
+        BatchJob job;
+        while (toBlend.pop(job))
+        {
+            auto t = clock::now();
+            overlay.apply(job.image, opt.logoPosition);
+            busy += busySince(t);
+            toEncode.push(std::move(job));
+        }
+        std::lock_guard<std::mutex> lock(statsMutex);
+        stats.blendBusy += busy;
+    };
+
+    auto encodeWorker = [&]
+    {
+        double busy = 0;
+        BatchJob job;
+        while (toEncode.pop(job))
+        {
+            auto t = clock::now();
+            if (!cv::imwrite(job.outputPath, job.image))
+                ++failed;
+            busy += busySince(t);
+            pool.release(std::move(job.image));
+        }
+        std::lock_guard<std::mutex> lock(statsMutex);
+        stats.encodeBusy += busy;
+    };
+
+    auto start = clock::now();
+
+    std::vector<std::thread> decoders, blenders, encoders;
+    for (int i = 0; i < stats.decoders; ++i)
+        decoders.emplace_back(decodeWorker);
+    for (int i = 0; i < stats.blenders; ++i)
+        blenders.emplace_back(blendWorker);
+    for (int i = 0; i < stats.encoders; ++i)
+        encoders.emplace_back(encodeWorker);
+
+    // Close each queue once every producer of that stage has finished
+    for (auto &t : decoders)
+        t.join();
+    toBlend.close();
+    for (auto &t : blenders)
+        t.join();
+    toEncode.close();
+    for (auto &t : encoders)
+        t.join();
+
+    stats.seconds = std::chrono::duration<double>(clock::now() - start).count();
+    stats.failed = failed;
+    stats.images = files.size() - stats.failed;
+    return stats;
+}
+
+inline void printBatchStats(const BatchStats &s)
+{
+    auto utilisation = [&](double busy, int threads)
+    {
+        return s.seconds > 0 ? 100.0 * busy / (s.seconds * threads) : 0.0;
+    };
+
+    printf("\nWatermarked %zu images (%zu failed) in %f seconds\n", s.images, s.failed, s.seconds);
+    printf("\tThroughput = %f images/sec\n", s.seconds > 0 ? s.images / s.seconds : 0.0);
+    printf("\tDecode utilisation = %5.1f%% (%d threads)\n", utilisation(s.decodeBusy, s.decoders), s.decoders);
+    printf("\tBlend  utilisation = %5.1f%% (%d threads)\n", utilisation(s.blendBusy, s.blenders), s.blenders);
+    printf("\tEncode utilisation = %5.1f%% (%d threads)\n\n", utilisation(s.encodeBusy, s.encoders), s.encoders);
+}
@@ -0,0 +1,256 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <immintrin.h>
+#include <stdint.h>
+#include <algorithm>
+#include <iostream>
+#include "../../../common/perf_counters.hpp"
+
+// Fixed-point form of the per-channel blend weights (B, G, R).
+// (p * mul[c]) >> 16 equals (int)(p * alpha[c]) for every 8-bit p, so the
+// SIMD paths stay byte-exact with mergePhotosWeighted_Serial.
+struct BlendWeights
+{
+    uint16_t mul[3];
+    bool exact; // false when some alpha has no exact 16-bit multiplier (e.g. alpha >= 1)
+};
+
+// Find the smallest 16-bit multiplier m with (p * m) >> 16 == (int)(p * alpha) for p = 0..255
+inline bool fixedPointMultiplier(float alpha, uint16_t &mul)
+{
+    if (!(alpha >= 0.0f) || alpha >= 1.0f)
+        return false;
+
+    long lo = 0, hi = 65535;
+    for (int p = 1; p < 256; ++p)
+    {
+        long t = static_cast<int>(p * alpha);
+        // (p * m) >> 16 == t  <=>  t * 65536 <= p * m < (t + 1) * 65536
+        lo = std::max(lo, (t * 65536 + p - 1) / p);
+        hi = std::min(hi, ((t + 1) * 65536 - 1) / p);
+    }
+    if (lo > hi)
+        return false;
+
+    mul = static_cast<uint16_t>(lo);
+    return true;
+}
+
+inline BlendWeights makeBlendWeights(const float alpha[3])
+{
+    BlendWeights w;
+    w.exact = true;
+    for (int c = 0; c < 3; ++c)
+    {
+        w.mul[c] = 0;
+        w.exact = fixedPointMultiplier(alpha[c], w.mul[c]) && w.exact;
+    }
+    return w;
+}
+
+// Scalar blend of nBytes interleaved BGR bytes; `channel` is the channel of the first byte
+inline void blendRow_Scalar(const uchar *src1, const uchar *src2, uchar *dst, int nBytes, int channel, const BlendWeights &w)
+{
+    for (int i = 0; i < nBytes; ++i)
+    {
+        int merged = src1[i] + ((src2[i] * w.mul[channel]) >> 16);
+        dst[i] = static_cast<uchar>(merged > 255 ? 255 : merged);
+        channel = channel == 2 ? 0 : channel + 1;
+    }
+}
+
+// Shuffle tables that split 48 interleaved bytes (16 BGR pixels, loaded as
+// three 16-byte chunks) into B, G and R planes: plane = OR of pshufb(chunk[k], DEINTERLEAVE[plane][k])
+alignas(16) static const int8_t BGR_DEINTERLEAVE[3][3][16] = {
+    {{0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+     {-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1},
+     {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13}},
+    {{1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+     {-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1},
+     {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14}},
+    {{2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+     {-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1},
+     {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15}}};
+
+// Inverse tables: chunk[k] = OR of pshufb(plane[c], INTERLEAVE[k][c])
+alignas(16) static const int8_t BGR_INTERLEAVE[3][3][16] = {
+    {{0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1, 5},
+     {-1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1},
+     {-1, -1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1}},
+    {{-1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10, -1},
+     {5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10},
+     {-1, 5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1}},
+    {{-1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1, -1},
+     {-1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1},
+     {10, -1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15}}};
+
+// SSSE3 row kernel: deinterleave 16 pixels of src2 into planes, scale each
+// plane by its channel weight in 16-bit fixed point, re-interleave and add to src1
+__attribute__((target("ssse3"))) inline void blendRow_SSE(const uchar *src1, const uchar *src2, uchar *dst, int nBytes, const BlendWeights &w)
+{
+    __m128i deinterleave[3][3], interleave[3][3], mul[3];
+    for (int a = 0; a < 3; ++a)
+    {
+        for (int b = 0; b < 3; ++b)
+        {
+            deinterleave[a][b] = _mm_load_si128(reinterpret_cast<const __m128i *>(BGR_DEINTERLEAVE[a][b]));
+            interleave[a][b] = _mm_load_si128(reinterpret_cast<const __m128i *>(BGR_INTERLEAVE[a][b]));
+        }
+        mul[a] = _mm_set1_epi16(static_cast<short>(w.mul[a]));
+    }
+    const __m128i zero = _mm_setzero_si128();
+
+    int i = 0;
+    for (; i + 48 <= nBytes; i += 48)
+    {
+        __m128i chunk[3], plane[3];
+        for (int k = 0; k < 3; ++k)
+            chunk[k] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src2 + i + 16 * k));
+
+        for (int c = 0; c < 3; ++c)
+        {
+            __m128i p = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(chunk[0], deinterleave[c][0]),
+                                                  _mm_shuffle_epi8(chunk[1], deinterleave[c][1])),
+                                     _mm_shuffle_epi8(chunk[2], deinterleave[c][2]));
+
+            // Widen to 16 bits, (p * mul) >> 16, narrow back (results are <= 255, no saturation)
+            __m128i lo = _mm_mulhi_epu16(_mm_unpacklo_epi8(p, zero), mul[c]);
+            __m128i hi = _mm_mulhi_epu16(_mm_unpackhi_epi8(p, zero), mul[c]);
+            plane[c] = _mm_packus_epi16(lo, hi);
+        }
+
+        for (int k = 0; k < 3; ++k)
+        {
+            __m128i scaled = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(plane[0], interleave[k][0]),
+                                                       _mm_shuffle_epi8(plane[1], interleave[k][1])),
+                                          _mm_shuffle_epi8(plane[2], interleave[k][2]));
+            __m128i base = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src1 + i + 16 * k));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i + 16 * k), _mm_adds_epu8(base, scaled));
+        }
+    }
+
+    // 48 is a multiple of 3, so the tail always starts on a B byte
+    blendRow_Scalar(src1 + i, src2 + i, dst + i, nBytes - i, 0, w);
+}
+
+// AVX2 row kernel, 32 bytes per step. pshufb only shuffles inside 128-bit lanes,
+// so instead of deinterleaving, the even and odd bytes of each 16-bit lane are
+// scaled with per-byte weight vectors; the channel pattern repeats every 96 bytes (3 steps).
+__attribute__((target("avx2"))) inline void blendRow_AVX2(const uchar *src1, const uchar *src2, uchar *dst, int nBytes, const BlendWeights &w)
+{
+    __m256i mulEven[3], mulOdd[3];
+    for (int phase = 0; phase < 3; ++phase)
+    {
+        alignas(32) uint16_t even[16], odd[16];
+        for (int j = 0; j < 16; ++j)
+        {
+            even[j] = w.mul[(32 * phase + 2 * j) % 3];
+            odd[j] = w.mul[(32 * phase + 2 * j + 1) % 3];
+        }
+        mulEven[phase] = _mm256_load_si256(reinterpret_cast<const __m256i *>(even));
+        mulOdd[phase] = _mm256_load_si256(reinterpret_cast<const __m256i *>(odd));
+    }
+    const __m256i lowBytes = _mm256_set1_epi16(0x00FF);
+
+    int i = 0, phase = 0;
+    for (; i + 32 <= nBytes; i += 32)
+    {
+        __m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src2 + i));
+        __m256i base = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src1 + i));
+
+        __m256i even = _mm256_mulhi_epu16(_mm256_and_si256(p, lowBytes), mulEven[phase]);
+        __m256i odd = _mm256_mulhi_epu16(_mm256_srli_epi16(p, 8), mulOdd[phase]);
+        __m256i scaled = _mm256_or_si256(even, _mm256_slli_epi16(odd, 8));
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_adds_epu8(base, scaled));
+        phase = phase == 2 ? 0 : phase + 1;
+    }
+
+    blendRow_Scalar(src1 + i, src2 + i, dst + i, nBytes - i, i % 3, w);
+}
+
+enum BlendISA
+{
+    BLEND_SCALAR,
+    BLEND_SSE,
+    BLEND_AVX2
+};
+
+inline BlendISA detectBlendISA()
+{
+    if (__builtin_cpu_supports("avx2"))
+        return BLEND_AVX2;
+    if (__builtin_cpu_supports("ssse3"))
+        return BLEND_SSE;
+    return BLEND_SCALAR;
+}
+
+inline void blendRows(const cv::Mat &src1, const cv::Mat &src2, cv::Mat &dst, const BlendWeights &w, BlendISA isa, int rowBegin, int rowEnd)
+{
+    const int nBytes = src1.cols * 3;
+    // Per channel byte: two loads, one store; multiply, shift, saturating add
+    PERF_REGION("blendRows", 3.0 * nBytes * (rowEnd - rowBegin), 3.0 * nBytes * (rowEnd - rowBegin));
+    for (int row = rowBegin; row < rowEnd; ++row)
+    {
+        const uchar *ptrSrc1 = src1.ptr<uchar>(row);
+        const uchar *ptrSrc2 = src2.ptr<uchar>(row);
+        uchar *ptrDst = dst.ptr<uchar>(row);
+
+        if (isa == BLEND_AVX2)
+            blendRow_AVX2(ptrSrc1, ptrSrc2, ptrDst, nBytes, w);
+        else if (isa == BLEND_SSE)
+            blendRow_SSE(ptrSrc1, ptrSrc2, ptrDst, nBytes, w);
+        else
+            blendRow_Scalar(ptrSrc1, ptrSrc2, ptrDst, nBytes, 0, w);
+    }
+}
+
+// Blending engine: dst = saturate(src1 + (int)(src2 * alpha[c])) per channel,
+// byte-exact with mergePhotosWeighted_Serial. Rows are split across numThreads
+// threads (0 = OpenCV's thread count, 1 = calling thread only).
+inline void mergePhotosWeighted_Engine(const cv::Mat &src1, const cv::Mat &src2, cv::Mat &dst, const float alpha[3], int numThreads = 0, BlendISA isa = detectBlendISA())
+{
+    if (src1.size() != src2.size() || src1.type() != CV_8UC3 || src2.type() != CV_8UC3)
+    {
+        std::cerr << "Input matrices must have the same size and be of type CV_8UC3." << std::endl;
+        return;
+    }
+
+    dst.create(src1.rows, src1.cols, CV_8UC3);
+
+    BlendWeights w = makeBlendWeights(alpha);
+    if (!w.exact)
+    {
+        // Weights outside [0, 1) have no exact 16-bit form; keep the float semantics
+        for (int row = 0; row < src1.rows; ++row)
+        {
+            const uchar *ptrSrc1 = src1.ptr<uchar>(row);
+            const uchar *ptrSrc2 = src2.ptr<uchar>(row);
+            uchar *ptrDst = dst.ptr<uchar>(row);
+            for (int i = 0; i < src1.cols * 3; ++i)
+            {
+                int merged = ptrSrc1[i] + static_cast<int>(ptrSrc2[i] * alpha[i % 3]);
+                ptrDst[i] = static_cast<uchar>(merged > 255 ? 255 : merged);
+            }
+        }
+        return;
+    }
+
+    if (numThreads == 1 || src1.rows < 2)
+    {
+        blendRows(src1, src2, dst, w, isa, 0, src1.rows);
+        return;
+    }
+
+    int stripes = numThreads > 0 ? numThreads : cv::getNumThreads();
+    cv::parallel_for_(cv::Range(0, src1.rows), [&](const cv::Range &range)
+                      { blendRows(src1, src2, dst, w, isa, range.start, range.end); },
+                      stripes);
+}
+
+inline void mergePhotosWeighted_Engine(const cv::Mat &src1, const cv::Mat &src2, cv::Mat &dst, float alpha, int numThreads = 0)
+{
+    const float alpha3[3] = {alpha, alpha, alpha};
+    mergePhotosWeighted_Engine(src1, src2, dst, alpha3, numThreads);
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <immintrin.h>
+#include <iostream>
+#include "blend_engine.hpp"
+
+// dst[i] = saturate(dst[i] + add[i]) over n bytes
+__attribute__((target("avx2"))) inline void addSaturateRow_AVX2(uchar *dst, const uchar *add, int n)
+{
+    int i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(add + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_adds_epu8(a, b));
+    }
+    for (; i < n; ++i)
+    {
+        int merged = dst[i] + add[i];
+        dst[i] = static_cast<uchar>(merged > 255 ? 255 : merged);
+    }
+}
+
+inline void addSaturateRow_SSE(uchar *dst, const uchar *add, int n)
+{
+    int i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(add + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_adds_epu8(a, b));
+    }
+    for (; i < n; ++i)
+    {
+        int merged = dst[i] + add[i];
+        dst[i] = static_cast<uchar>(merged > 255 ? 255 : merged);
+    }
+}
+
+// Watermark overlay that only touches the pixels under the logo.
+// The logo is scaled by alpha once, when the overlay is built; every apply()
+// is then a saturating add of the cached premultiplied logo onto the
+// destination ROI, in place. Results match mergePhotosWeighted_Serial run on
+// a full-frame canvas holding the logo at the same position.
+class LogoOverlay
+{
+public:
+    LogoOverlay() : alpha(0.0f), useAVX2(__builtin_cpu_supports("avx2")) {}
+
+    LogoOverlay(const cv::Mat &logo, float alpha) : LogoOverlay()
+    {
+        prepare(logo, alpha);
+    }
+
+    // Rebuild the premultiplied logo; a no-op when logo and alpha are unchanged.
+    // Editing the logo pixels in place afterwards is not detected.
+    void prepare(const cv::Mat &logo, float newAlpha)
+    {
+        if (logo.type() != CV_8UC3)
+        {
+            std::cerr << "Logo must be of type CV_8UC3." << std::endl;
+            return;
+        }
+        if (logo.data == source.data && logo.size() == source.size() && newAlpha == alpha && !premultiplied.empty())
+            return;
+
+        source = logo;
+        alpha = newAlpha;
+
+        // premultiplied = 0 + (int)(logo * alpha), computed with the blending engine
+        const float alpha3[3] = {alpha, alpha, alpha};
+        cv::Mat black(logo.rows, logo.cols, CV_8UC3, cv::Scalar(0, 0, 0));
+        mergePhotosWeighted_Engine(black, logo, premultiplied, alpha3, 1);
+    }
+
+    // Blend the logo onto dst with its top-left corner at placement.x/y.
+    // placement.width/height crop the logo; the rect is clipped to dst.
+    void apply(cv::Mat &dst, cv::Rect placement) const
+    {
+        if (dst.type() != CV_8UC3 || premultiplied.empty())
+        {
+            std::cerr << "Destination must be of type CV_8UC3 and the overlay must be prepared." << std::endl;
+            return;
+        }
+
+        placement.width = std::min(placement.width, premultiplied.cols);
+        placement.height = std::min(placement.height, premultiplied.rows);
+        cv::Rect roi = placement & cv::Rect(0, 0, dst.cols, dst.rows);
+        if (roi.empty())
+            return;
+
+        // Offset into the logo when the placement starts outside dst
+        int logoX = roi.x - placement.x;
+        int logoY = roi.y - placement.y;
+        int nBytes = roi.width * 3;
+
+        for (int row = 0; row < roi.height; ++row)
+        {
+            uchar *ptrDst = dst.ptr<uchar>(roi.y + row) + roi.x * 3;
+            const uchar *ptrLogo = premultiplied.ptr<uchar>(logoY + row) + logoX * 3;
+
+            if (useAVX2)
+                addSaturateRow_AVX2(ptrDst, ptrLogo, nBytes);
+            else
+                addSaturateRow_SSE(ptrDst, ptrLogo, nBytes);
+        }
+    }
+
+    void apply(cv::Mat &dst, cv::Point position) const
+    {
+        apply(dst, cv::Rect(position.x, position.y, premultiplied.cols, premultiplied.rows));
+    }
+
+private:
+    cv::Mat source;        // logo the cache was built from (held so its buffer cannot be reused)
+    cv::Mat premultiplied; // (int)(source * alpha)
+    float alpha;
+    bool useAVX2;
+};
+
+// Convenience wrapper with a per-thread cache: repeated calls with the same
+// logo and alpha reuse the premultiplied logo
+inline void overlayLogo(cv::Mat &dst, const cv::Mat &logo, cv::Rect placement, float alpha)
+{
+    thread_local LogoOverlay cache;
+    cache.prepare(logo, alpha);
+    cache.apply(dst, placement);
+}
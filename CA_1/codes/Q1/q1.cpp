@@ -5,80 +5,28 @@
 #include <emmintrin.h>
 #include <x86intrin.h>
 #include <chrono> // Include chrono header for timing
+#include "blend_engine.hpp"
+#include "logo_overlay.hpp"
+#include "batch_pipeline.hpp"
+#include "alpha_composite.hpp"
+#include "../image_resampler.hpp"
 
 using namespace cv;
 using namespace std;
 
 
+// Single-threaded SIMD blend (AVX2 or SSSE3 shuffle-table path, picked at runtime)
 void mergePhotosWeighted_SIMD(Mat &src1, Mat &src2, Mat &dst, float alpha)
 {
-    // Ensure input matrices have the same size and are of type CV_8UC3
-    if (src1.size() != src2.size() || src1.type() != CV_8UC3 || src2.type() != CV_8UC3)
-    {
-        std::cerr << "Input matrices must have the same size and be of type CV_8UC3." << std::endl;
-        return;
-    }
-
-    dst.create(src1.rows, src1.cols, CV_8UC3);
-
-    __m128 alphaVec = _mm_set1_ps(alpha);  // Set the alpha value for scaling
+    mergePhotosWeighted_Engine(src1, src2, dst, alpha, 1);
+}
 
-    for (int row = 0; row < src1.rows; ++row)
-    {
-        const uchar *ptrSrc1 = src1.ptr<uchar>(row);
-        const uchar *ptrSrc2 = src2.ptr<uchar>(row);
-        uchar *ptrDst = dst.ptr<uchar>(row);
 
-        for (int col = 0; col < src1.cols; col += 4)
-        {
-            // Load 4 pixels (16 bytes, 3 channels each pixel) from the source images
-            __m128i xmm1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ptrSrc1 + col * 3));
-            __m128i xmm2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ptrSrc2 + col * 3));
-
-            // Separate the 16-byte values (4 pixels * 3 channels = 12 values)
-            __m128i src1_r = _mm_and_si128(xmm1, _mm_set1_epi32(0xFF));  // Red channel
-            __m128i src1_g = _mm_and_si128(_mm_srli_si128(xmm1, 1), _mm_set1_epi32(0xFF));  // Green channel
-            __m128i src1_b = _mm_and_si128(_mm_srli_si128(xmm1, 2), _mm_set1_epi32(0xFF));  // Blue channel
-
-            __m128i src2_r = _mm_and_si128(xmm2, _mm_set1_epi32(0xFF));  // Red channel
-            __m128i src2_g = _mm_and_si128(_mm_srli_si128(xmm2, 1), _mm_set1_epi32(0xFF));  // Green channel
-            __m128i src2_b = _mm_and_si128(_mm_srli_si128(xmm2, 2), _mm_set1_epi32(0xFF));  // Blue channel
-
-            // Convert to float and apply alpha scaling
-            __m128 src1_r_f = _mm_cvtepi32_ps(src1_r);
-            __m128 src1_g_f = _mm_cvtepi32_ps(src1_g);
-            __m128 src1_b_f = _mm_cvtepi32_ps(src1_b);
-
-            __m128 src2_r_f = _mm_cvtepi32_ps(src2_r);
-            __m128 src2_g_f = _mm_cvtepi32_ps(src2_g);
-            __m128 src2_b_f = _mm_cvtepi32_ps(src2_b);
-
-            src2_r_f = _mm_mul_ps(src2_r_f, alphaVec);
-            src2_g_f = _mm_mul_ps(src2_g_f, alphaVec);
-            src2_b_f = _mm_mul_ps(src2_b_f, alphaVec);
-
-            // Add the scaled values and convert back to int
-            __m128i result_r = _mm_cvtps_epi32(_mm_add_ps(src1_r_f, src2_r_f));
-            __m128i result_g = _mm_cvtps_epi32(_mm_add_ps(src1_g_f, src2_g_f));
-            __m128i result_b = _mm_cvtps_epi32(_mm_add_ps(src1_b_f, src2_b_f));
-
-            // Clamp the values to the 0-255 range using _mm_min_epu8
-            result_r = _mm_min_epu8(result_r, _mm_set1_epi32(255));
-            result_g = _mm_min_epu8(result_g, _mm_set1_epi32(255));
-            result_b = _mm_min_epu8(result_b, _mm_set1_epi32(255));
-
-            // Pack the results back into a single __m128i and store
-            __m128i merged = _mm_or_si128(
-                _mm_or_si128(
-                    _mm_slli_si128(result_b, 2),  // Shift blue to the right position
-                    _mm_slli_si128(result_g, 1)   // Shift green to the right position
-                ),
-                result_r                       // Red stays in the same position
-            );
-
-            _mm_storeu_si128(reinterpret_cast<__m128i *>(ptrDst + col * 3), merged);
-        }
-    }
+// Logo size on an image: a quarter of the image width, aspect kept, never larger than the image
+Size logoSizeFor(Size logo, Size image)
+{
+    double scale = std::min(image.width / 4.0 / logo.width, (double)image.height / logo.height);
+    return Size(std::max(1, cvRound(logo.width * scale)), std::max(1, cvRound(logo.height * scale)));
 }
 
 
@@ -123,10 +71,29 @@ void mergePhotosWeighted_Serial(const cv::Mat &src1, const cv::Mat &src2, cv::Ma
     }
 }
 
-int main()
+int main(int argc, char **argv)
 {
     using namespace std::chrono; // For time tracking
 
+    // Batch mode: q1 --batch <input_dir> <output_dir> <logo> [alpha] [decoders] [encoders]
+    if (argc >= 5 && string(argv[1]) == "--batch")
+    {
+        Mat logo = imread(argv[4], IMREAD_COLOR);
+        if (logo.empty())
+        {
+            std::cerr << "Could not read logo " << argv[4] << std::endl;
+            return 1;
+        }
+        BatchOptions options;
+        float batchAlpha = argc > 5 ? atof(argv[5]) : 0.625f;
+        options.decoders = argc > 6 ? atoi(argv[6]) : 0;
+        options.encoders = argc > 7 ? atoi(argv[7]) : 0;
+
+        BatchStats stats = watermarkDirectory(argv[2], argv[3], logo, batchAlpha, options);
+        printBatchStats(stats);
+        return stats.failed == 0 ? 0 : 1;
+    }
+
     // Load the two input images (color images)
     Mat image1 = imread("/home/atefeh/PP/PP-CA1-Fall03/assets/Q1/front.png", IMREAD_COLOR);
     Mat image2 = imread("/home/atefeh/PP/PP-CA1-Fall03/assets/Q1/logo.png", IMREAD_COLOR); // Ensure this path is correct
@@ -136,46 +103,123 @@ int main()
     // Create a new image 'c' with the same size as 'a'
     Mat image2_scaled(image1.rows, image1.cols, image1.type(), Scalar(0, 0, 0)); // Initialize with empty (black) pixels
 
-    // Copy the content of 'image2' into 'image2_scaled' at the appropriate position
-    image2.copyTo(image2_scaled(Rect(0, 0, image2.cols, image2.rows)));
+    // Scale the logo to the image (Lanczos-3), then copy it into 'image2_scaled' at the appropriate position
+    ImageResampler logoResampler(RESAMPLE_LANCZOS3);
+    Mat logoScaled;
+    logoResampler.apply(image2, logoScaled, logoSizeFor(image2.size(), image1.size()));
+    image2 = logoScaled;
+    Rect logoRect(0, 0, image2.cols, image2.rows);
+    image2.copyTo(image2_scaled(logoRect));
 
-    // Multiply the second image's pixel values by 0.625 (weighting factor)
+    // Weighting factor of the second image, applied once by each merge function
     float alpha = 0.625;
-    for (int row = 0; row < image2_scaled.rows; ++row)
-    {
-        uchar *ptr = image2_scaled.ptr<uchar>(row);
-        for (int col = 0; col < image2_scaled.cols; ++col)
-        {
-            for (int channel = 0; channel < 3; ++channel)
-            {
-                ptr[col * 3 + channel] = static_cast<uchar>(ptr[col * 3 + channel] * alpha);
-            }
-        }
-    }
 
-    // Start the timer for parallel execution
+    // Start the timer for SIMD execution
     auto start = high_resolution_clock::now();
     // Merge the two photos using SIMD instructions, with a weight of 0.625 for the second image
-    mergePhotosWeighted_SIMD(image1, image2_scaled, merged_par, 0.625); // Set alpha to 1 as the scaling is done already
-    // End the timer for parallel execution
+    mergePhotosWeighted_SIMD(image1, image2_scaled, merged_par, alpha);
+    // End the timer for SIMD execution
     auto end = high_resolution_clock::now();
     auto timeParallel = duration_cast<microseconds>(end - start).count();
 
+    // Start the timer for multithreaded SIMD execution (rows split across threads)
+    Mat merged_mt;
+    start = high_resolution_clock::now();
+    mergePhotosWeighted_Engine(image1, image2_scaled, merged_mt, alpha);
+    end = high_resolution_clock::now();
+    auto timeThreaded = duration_cast<microseconds>(end - start).count();
+
     // Start the timer for serial execution
     start = high_resolution_clock::now();
-    // Merge the two photos using serial code, with a weight of 1 for the second image
-    mergePhotosWeighted_Serial(image1, image2_scaled, merged_ser, 0.625); // Set alpha to 1 as the scaling is done already
+    // Merge the two photos using serial code, with a weight of 0.625 for the second image
+    mergePhotosWeighted_Serial(image1, image2_scaled, merged_ser, alpha);
     // End the timer for serial execution
     end = high_resolution_clock::now();
     auto timeSerial = duration_cast<microseconds>(end - start).count();
 
+    // Overlay only the logo region, in place; the premultiplied logo is built once and reused
+    LogoOverlay overlay(image2, alpha);
+    Mat merged_roi = image1.clone();
+    start = high_resolution_clock::now();
+    overlay.apply(merged_roi, logoRect);
+    end = high_resolution_clock::now();
+    auto timeOverlay = duration_cast<microseconds>(end - start).count();
+
+    // Per-pixel alpha compositing of a BGRA logo (opaque alpha when logo.png has none)
+    Mat logoBGRA = imread("/home/atefeh/PP/PP-CA1-Fall03/assets/Q1/logo.png", IMREAD_UNCHANGED);
+    if (logoBGRA.channels() == 3)
+        cvtColor(logoBGRA, logoBGRA, COLOR_BGR2BGRA);
+    Mat logoBGRAScaled;
+    logoResampler.apply(logoBGRA, logoBGRAScaled, logoRect.size());
+    logoBGRA = logoBGRAScaled;
+    Mat logoPremultiplied;
+    premultiplyAlpha(logoBGRA, logoPremultiplied);
+
+    Mat over_ser = image1.clone(), over_simd = image1.clone(), over_pre = image1.clone(), weighted;
+    Mat overRoi = over_ser(logoRect);
+    start = high_resolution_clock::now();
+    compositeOver_Serial(logoBGRA, overRoi, ALPHA_STRAIGHT);
+    end = high_resolution_clock::now();
+    auto timeOverSerial = duration_cast<microseconds>(end - start).count();
+
+    start = high_resolution_clock::now();
+    compositeLogo(over_simd, logoBGRA, logoRect.tl(), ALPHA_STRAIGHT);
+    end = high_resolution_clock::now();
+    auto timeOverSIMD = duration_cast<microseconds>(end - start).count();
+
+    start = high_resolution_clock::now();
+    compositeLogo(over_pre, logoPremultiplied, logoRect.tl(), ALPHA_PREMULTIPLIED);
+    end = high_resolution_clock::now();
+    auto timeOverPremultiplied = duration_cast<microseconds>(end - start).count();
+
+    // OpenCV reference for the same region, with a single global weight
+    start = high_resolution_clock::now();
+    addWeighted(image1(logoRect), 1.0, image2, alpha, 0.0, weighted);
+    end = high_resolution_clock::now();
+    auto timeAddWeighted = duration_cast<microseconds>(end - start).count();
+
+    long overMismatches = 0;
+    for (int row = 0; row < over_ser.rows; ++row)
+    {
+        const uchar *ser = over_ser.ptr<uchar>(row);
+        const uchar *simd = over_simd.ptr<uchar>(row);
+        for (int i = 0; i < over_ser.cols * 3; ++i)
+            overMismatches += ser[i] != simd[i];
+    }
+
+    // The SIMD engine must be byte-exact with the serial version
+    long mismatches = 0;
+    for (int row = 0; row < merged_ser.rows; ++row)
+    {
+        const uchar *ser = merged_ser.ptr<uchar>(row);
+        const uchar *par = merged_par.ptr<uchar>(row);
+        const uchar *mt = merged_mt.ptr<uchar>(row);
+        const uchar *roi = merged_roi.ptr<uchar>(row);
+        for (int i = 0; i < merged_ser.cols * 3; ++i)
+            mismatches += (ser[i] != par[i]) + (ser[i] != mt[i]) + (ser[i] != roi[i]);
+    }
+
     // Saving output images
     imwrite("out_par.png", merged_par);
     imwrite("out_ser.png", merged_ser);
+    imwrite("out_roi.png", merged_roi);
+    imwrite("out_over.png", over_simd);
 
     printf("\nSerial Run time = %ld microseconds\n", timeSerial);
     printf("\nParallel Run time = %ld microseconds\n", timeParallel);
-    printf("\tSpeedup = %f\n\n", (float)(timeSerial) / (float)(timeParallel));
+    printf("\tSpeedup = %f\n", (float)(timeSerial) / (float)(timeParallel));
+    printf("\nParallel Run time (%d threads) = %ld microseconds\n", getNumThreads(), timeThreaded);
+    printf("\tSpeedup = %f\n", (float)(timeSerial) / (float)(timeThreaded));
+    printf("\nROI overlay Run time = %ld microseconds\n", timeOverlay);
+    printf("\tSpeedup = %f\n", (float)(timeSerial) / (float)(timeOverlay));
+    printf("\nMismatched bytes vs serial = %ld\n", mismatches);
+
+    printf("\nAlpha compositing (%d x %d logo):\n", logoRect.width, logoRect.height);
+    printf("\tSerial over = %ld microseconds\n", timeOverSerial);
+    printf("\tSIMD over (straight) = %ld microseconds, speedup = %f\n", timeOverSIMD, (float)timeOverSerial / (float)timeOverSIMD);
+    printf("\tSIMD over (premultiplied) = %ld microseconds, speedup = %f\n", timeOverPremultiplied, (float)timeOverSerial / (float)timeOverPremultiplied);
+    printf("\tcv::addWeighted = %ld microseconds\n", timeAddWeighted);
+    printf("\tMismatched bytes vs serial = %ld\n\n", overMismatches);
 
     return 0;
 }
@@ -0,0 +1,437 @@
+#pragma once
+
+#include <math.h>
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <xmmintrin.h>
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "outliers.hpp"
+
+// Mean, standard deviation and z-score outliers of every column of a wide
+// float table.
+//
+// The table is stored column-major (structure of arrays): each column starts
+// on a 64-byte boundary and is padded with zeros to a multiple of 16 rows, so
+// row chunks of any column can be read with aligned SSE loads.
+//
+// columnOutliers_Parallel() picks one of two sweeps over the data:
+//   - Columns that fit in half of L2 are handed to the threads in blocks. Each
+//     column's statistics pass and its outlier pass run back to back, so the
+//     second pass reads the column from cache and memory is read once.
+//   - Taller columns are cut into (column block x row chunk) tiles. One
+//     parallel sweep collects per-tile shifted sums for all columns, then a
+//     second sweep counts outliers per tile.
+// Either way the statistics take one pass: sums of x - K and (x - K)^2, with
+// the shift K the column's first value, so the variance keeps its precision
+// when the mean is large compared with the spread.
+
+const size_t COLUMN_ALIGN_ROWS = 16; // 64 bytes of floats
+
+class ColumnTable
+{
+public:
+    ColumnTable() : data(nullptr, free) {}
+
+    // Zero-filled rows x cols table
+    ColumnTable(size_t rows, size_t cols) : nRows(rows), nCols(cols), data(nullptr, free)
+    {
+        nStride = (rows + COLUMN_ALIGN_ROWS - 1) / COLUMN_ALIGN_ROWS * COLUMN_ALIGN_ROWS;
+        size_t bytes = std::max<size_t>(64, nStride * cols * sizeof(float));
+        data.reset((float *)aligned_alloc(64, bytes));
+        // Zeroed column by column from the threads, which places the pages
+        // across the NUMA nodes the sweeps run on
+#pragma omp parallel for schedule(static)
+        for (long c = 0; c < (long)cols; ++c)
+            memset(data.get() + c * nStride, 0, nStride * sizeof(float));
+        for (size_t c = 0; c < cols; ++c)
+            names.push_back("c" + std::to_string(c));
+    }
+
+    size_t rows() const { return nRows; }
+    size_t cols() const { return nCols; }
+    size_t stride() const { return nStride; } // floats from one column to the next
+
+    float *column(size_t c) { return data.get() + c * nStride; }
+    const float *column(size_t c) const { return data.get() + c * nStride; }
+
+    std::vector<std::string> names;
+
+private:
+    size_t nRows = 0, nCols = 0, nStride = 0;
+    std::unique_ptr<float, decltype(&free)> data;
+};
+
+struct ColumnStats
+{
+    float mean = 0;
+    float stddev = 0;
+    long outliers = 0;
+};
+
+// Rows in flight between parsing and the transpose into columns
+const size_t LOAD_BLOCK_ROWS = 256;
+
+// Scatters `count` row-major rows starting at `firstRow` into the columns.
+// Column by column, so each column's writes are one sequential run.
+inline void transposeRows(ColumnTable &table, size_t firstRow, const float *rowMajor, size_t count)
+{
+    size_t cols = table.cols();
+    for (size_t c = 0; c < cols; ++c)
+    {
+        float *dst = table.column(c) + firstRow;
+        for (size_t r = 0; r < count; ++r)
+            dst[r] = rowMajor[r * cols + c];
+    }
+}
+
+inline bool readWholeFile(const std::string &path, std::string &content)
+{
+    FILE *file = fopen(path.c_str(), "rb");
+    if (!file)
+    {
+        fprintf(stderr, "Error opening file %s\n", path.c_str());
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    content.resize(size > 0 ? size : 0);
+    bool ok = size >= 0 && fread(&content[0], 1, content.size(), file) == content.size();
+    fclose(file);
+    if (!ok)
+        fprintf(stderr, "Error reading file %s\n", path.c_str());
+    return ok;
+}
+
+// Splits `line` at commas into floats; false if a field is not a number
+inline bool parseCsvFields(const char *line, const char *end, float *out, size_t expected, size_t &found)
+{
+    found = 0;
+    const char *p = line;
+    while (p <= end)
+    {
+        const char *comma = (const char *)memchr(p, ',', end - p);
+        const char *fieldEnd = comma ? comma : end;
+        char *parsed;
+        float v = strtof(p, &parsed);
+        while (parsed < fieldEnd && (*parsed == ' ' || *parsed == '\r' || *parsed == '\t'))
+            ++parsed;
+        if (parsed == p || parsed != fieldEnd)
+            return false;
+        if (found < expected)
+            out[found] = v;
+        ++found;
+        if (!comma)
+            break;
+        p = comma + 1;
+    }
+    return found == expected;
+}
+
+// Comma-separated numbers, one row per line. A first line that is not all
+// numbers is taken as the column names. Rows are parsed in parallel.
+inline bool loadCsvTable(const std::string &path, ColumnTable &table)
+{
+    std::string text;
+    if (!readWholeFile(path, text))
+        return false;
+
+    std::vector<size_t> lineStarts;
+    for (size_t pos = 0; pos < text.size();)
+    {
+        size_t eol = text.find('\n', pos);
+        if (eol == std::string::npos)
+            eol = text.size();
+        if (text.find_first_not_of(" \r\t", pos) < eol)
+            lineStarts.push_back(pos);
+        pos = eol + 1;
+    }
+    if (lineStarts.empty())
+    {
+        fprintf(stderr, "%s: no rows\n", path.c_str());
+        return false;
+    }
+    auto lineEnd = [&](size_t start)
+    {
+        size_t eol = text.find('\n', start);
+        return text.data() + (eol == std::string::npos ? text.size() : eol);
+    };
+
+    size_t cols = std::count(text.data() + lineStarts[0], lineEnd(lineStarts[0]), ',') + 1;
+    std::vector<float> probe(cols);
+    size_t found;
+    bool header = !parseCsvFields(text.data() + lineStarts[0], lineEnd(lineStarts[0]), probe.data(), cols, found);
+    size_t first = header ? 1 : 0, rows = lineStarts.size() - first;
+
+    table = ColumnTable(rows, cols);
+    if (header)
+    {
+        const char *p = text.data() + lineStarts[0], *end = lineEnd(lineStarts[0]);
+        for (size_t c = 0; c < cols; ++c)
+        {
+            const char *comma = (const char *)memchr(p, ',', end - p);
+            std::string name(p, comma ? comma : end);
+            name.erase(name.find_last_not_of(" \r\t") + 1);
+            name.erase(0, std::min(name.size(), name.find_first_not_of(" \t")));
+            table.names[c] = name;
+            p = comma ? comma + 1 : end;
+        }
+    }
+
+    long badLine = -1;
+    long blocks = (long)((rows + LOAD_BLOCK_ROWS - 1) / LOAD_BLOCK_ROWS);
+#pragma omp parallel
+    {
+        std::vector<float> staging(LOAD_BLOCK_ROWS * cols);
+        size_t fields;
+#pragma omp for schedule(dynamic)
+        for (long b = 0; b < blocks; ++b)
+        {
+            size_t r0 = b * LOAD_BLOCK_ROWS, count = std::min(LOAD_BLOCK_ROWS, rows - r0);
+            bool ok = true;
+            for (size_t r = 0; r < count && ok; ++r)
+            {
+                size_t start = lineStarts[first + r0 + r];
+                if (!parseCsvFields(text.data() + start, lineEnd(start), &staging[r * cols], cols, fields))
+                {
+                    ok = false;
+#pragma omp critical(csvBadLine)
+                    if (badLine < 0 || (long)(first + r0 + r) < badLine)
+                        badLine = (long)(first + r0 + r);
+                }
+            }
+            if (ok)
+                transposeRows(table, r0, staging.data(), count);
+        }
+    }
+    if (badLine >= 0)
+    {
+        fprintf(stderr, "%s: row %ld (of the non-empty lines): expected %zu numbers\n", path.c_str(), badLine + 1, cols);
+        return false;
+    }
+    return true;
+}
+
+// Headerless row-major float32 (native byte order) with `cols` values per row
+inline bool loadBinaryTable(const std::string &path, size_t cols, ColumnTable &table)
+{
+    std::string bytes;
+    if (!readWholeFile(path, bytes))
+        return false;
+    size_t rowBytes = cols * sizeof(float);
+    if (cols == 0 || bytes.size() % rowBytes != 0)
+    {
+        fprintf(stderr, "%s: %zu bytes is not a whole number of %zu-column float rows\n", path.c_str(), bytes.size(), cols);
+        return false;
+    }
+    size_t rows = bytes.size() / rowBytes;
+    table = ColumnTable(rows, cols);
+    const float *values = (const float *)bytes.data();
+    long blocks = (long)((rows + LOAD_BLOCK_ROWS - 1) / LOAD_BLOCK_ROWS);
+#pragma omp parallel for schedule(dynamic)
+    for (long b = 0; b < blocks; ++b)
+    {
+        size_t r0 = b * LOAD_BLOCK_ROWS;
+        transposeRows(table, r0, values + r0 * cols, std::min(LOAD_BLOCK_ROWS, rows - r0));
+    }
+    return true;
+}
+
+// Normal columns with per-column mean and spread, plus a few spikes
+inline ColumnTable randomTable(size_t rows, size_t cols, unsigned seed)
+{
+    ColumnTable table(rows, cols);
+#pragma omp parallel for schedule(dynamic)
+    for (long c = 0; c < (long)cols; ++c)
+    {
+        std::mt19937 gen(seed + (unsigned)c);
+        std::normal_distribution<float> dist(1000.0f * (c % 7), 1.0f + c % 13);
+        std::uniform_real_distribution<float> spike(0.0f, 1.0f);
+        float *col = table.column(c);
+        for (size_t r = 0; r < rows; ++r)
+            col[r] = spike(gen) < 0.01f ? dist(gen) * 10 : dist(gen);
+    }
+    return table;
+}
+
+// Shifted sums of x - shift and (x - shift)^2 over rows [begin, end) of a column
+inline void shiftedSums_SSE(const float *col, size_t begin, size_t end, float shift, double &sum, double &squares)
+{
+    __m128 k = _mm_set1_ps(shift);
+    __m128 s0 = _mm_setzero_ps(), s1 = _mm_setzero_ps(), q0 = _mm_setzero_ps(), q1 = _mm_setzero_ps();
+    size_t i = begin;
+    for (; i + 8 <= end; i += 8)
+    {
+        __m128 a = _mm_sub_ps(_mm_load_ps(col + i), k);
+        __m128 b = _mm_sub_ps(_mm_load_ps(col + i + 4), k);
+        s0 = _mm_add_ps(s0, a);
+        s1 = _mm_add_ps(s1, b);
+        q0 = _mm_add_ps(q0, _mm_mul_ps(a, a));
+        q1 = _mm_add_ps(q1, _mm_mul_ps(b, b));
+    }
+    float s[4], q[4];
+    _mm_storeu_ps(s, _mm_add_ps(s0, s1));
+    _mm_storeu_ps(q, _mm_add_ps(q0, q1));
+    sum = (double)s[0] + s[1] + s[2] + s[3];
+    squares = (double)q[0] + q[1] + q[2] + q[3];
+    for (; i < end; ++i)
+    {
+        double d = col[i] - shift;
+        sum += d;
+        squares += d * d;
+    }
+}
+
+// Rows of [begin, end) with |x - mean| > threshold * stddev; the same test as
+// |z| > threshold without a division per element
+inline long countOutliers_SSE(const float *col, size_t begin, size_t end, float mean, float limit)
+{
+    __m128 m = _mm_set1_ps(mean), lim = _mm_set1_ps(limit), signMask = _mm_set1_ps(-0.0f);
+    long outliers = 0;
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4)
+    {
+        __m128 dev = _mm_andnot_ps(signMask, _mm_sub_ps(_mm_load_ps(col + i), m));
+        outliers += __builtin_popcount(_mm_movemask_ps(_mm_cmpgt_ps(dev, lim)));
+    }
+    for (; i < end; ++i)
+        outliers += fabsf(col[i] - mean) > limit;
+    return outliers;
+}
+
+inline void finishStats(double sum, double squares, size_t rows, float shift, ColumnStats &stats)
+{
+    double meanShifted = sum / rows;
+    double variance = std::max(0.0, squares / rows - meanShifted * meanShifted);
+    stats.mean = (float)(shift + meanShifted);
+    stats.stddev = (float)sqrt(variance);
+}
+
+inline size_t columnCacheBudget()
+{
+    long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    return (l2 > 0 ? (size_t)l2 : 256 * 1024) / 2;
+}
+
+struct ColumnarOptions
+{
+    size_t chunkRows = 0;    // rows per tile in the tiled sweep; 0 = from the cache budget
+    size_t cacheBytes = 0;   // column data a task may keep in cache; 0 = half of L2
+    bool forceTiled = false; // use the two-sweep tiled path even for short columns
+};
+
+// Statistics and outlier counts of every column. thresholds[c] is the |z|
+// limit for column c (THRESHOLD where the vector is shorter).
+inline std::vector<ColumnStats> columnOutliers_Parallel(const ColumnTable &table, const std::vector<float> &thresholds, const ColumnarOptions &opt = ColumnarOptions())
+{
+    size_t rows = table.rows(), cols = table.cols();
+    std::vector<ColumnStats> stats(cols);
+    if (rows == 0 || cols == 0)
+        return stats;
+    PERF_REGION("columnOutliers_Parallel", 1.0 * rows * cols * sizeof(float), 5.0 * rows * cols);
+
+    auto limitOf = [&](size_t c, float stddev)
+    { return (c < thresholds.size() ? thresholds[c] : (float)THRESHOLD) * stddev; };
+    size_t budget = opt.cacheBytes ? opt.cacheBytes : columnCacheBudget();
+    int threads = omp_get_max_threads();
+
+    if (!opt.forceTiled && rows * sizeof(float) <= budget)
+    {
+        // Fused: statistics then outliers per column while it is in cache.
+        // Blocks of columns fill the budget, but leave each thread several blocks.
+        size_t blockCols = std::max<size_t>(1, std::min(budget / (rows * sizeof(float)), cols / (4 * threads)));
+        long blocks = (long)((cols + blockCols - 1) / blockCols);
+#pragma omp parallel for schedule(dynamic)
+        for (long b = 0; b < blocks; ++b)
+        {
+            for (size_t c = b * blockCols; c < std::min(cols, (b + 1) * blockCols); ++c)
+            {
+                const float *col = table.column(c);
+                double sum, squares;
+                shiftedSums_SSE(col, 0, rows, col[0], sum, squares);
+                finishStats(sum, squares, rows, col[0], stats[c]);
+                stats[c].outliers = countOutliers_SSE(col, 0, rows, stats[c].mean, limitOf(c, stats[c].stddev));
+            }
+        }
+        return stats;
+    }
+
+    // Tiled: a tile is blockCols columns of chunkRows rows (a multiple of 16,
+    // so every tile starts aligned) and about one cache budget of data
+    size_t chunkRows = opt.chunkRows ? opt.chunkRows : budget / sizeof(float) / 4;
+    chunkRows = std::max(COLUMN_ALIGN_ROWS, chunkRows / COLUMN_ALIGN_ROWS * COLUMN_ALIGN_ROWS);
+    size_t blockCols = std::max<size_t>(1, budget / (chunkRows * sizeof(float)));
+    long chunks = (long)((rows + chunkRows - 1) / chunkRows);
+    long blocks = (long)((cols + blockCols - 1) / blockCols);
+
+    // Per-tile partial results, [chunk][column]
+    std::vector<double> sums(chunks * cols), squares(chunks * cols);
+    std::vector<long> counts(chunks * cols);
+
+#pragma omp parallel
+    {
+#pragma omp for collapse(2) schedule(dynamic)
+        for (long b = 0; b < blocks; ++b)
+            for (long k = 0; k < chunks; ++k)
+                for (size_t c = b * blockCols; c < std::min(cols, (b + 1) * blockCols); ++c)
+                {
+                    const float *col = table.column(c);
+                    shiftedSums_SSE(col, k * chunkRows, std::min(rows, (k + 1) * chunkRows), col[0], sums[k * cols + c], squares[k * cols + c]);
+                }
+
+#pragma omp for schedule(static)
+        for (long c = 0; c < (long)cols; ++c)
+        {
+            double sum = 0, sq = 0;
+            for (long k = 0; k < chunks; ++k)
+            {
+                sum += sums[k * cols + c];
+                sq += squares[k * cols + c];
+            }
+            finishStats(sum, sq, rows, table.column(c)[0], stats[c]);
+        }
+
+#pragma omp for collapse(2) schedule(dynamic)
+        for (long b = 0; b < blocks; ++b)
+            for (long k = 0; k < chunks; ++k)
+                for (size_t c = b * blockCols; c < std::min(cols, (b + 1) * blockCols); ++c)
+                    counts[k * cols + c] = countOutliers_SSE(table.column(c), k * chunkRows, std::min(rows, (k + 1) * chunkRows),
+                                                             stats[c].mean, limitOf(c, stats[c].stddev));
+
+#pragma omp for schedule(static)
+        for (long c = 0; c < (long)cols; ++c)
+            for (long k = 0; k < chunks; ++k)
+                stats[c].outliers += counts[k * cols + c];
+    }
+    return stats;
+}
+
+// Reference: two passes per column in double precision, then the z-score
+// test of countOutliers_Serial() with the column's threshold
+inline std::vector<ColumnStats> columnOutliers_Serial(const ColumnTable &table, const std::vector<float> &thresholds)
+{
+    std::vector<ColumnStats> stats(table.cols());
+    for (size_t c = 0; c < table.cols(); ++c)
+    {
+        const float *col = table.column(c);
+        double sum = 0;
+        for (size_t r = 0; r < table.rows(); ++r)
+            sum += col[r];
+        double mean = sum / table.rows(), squares = 0;
+        for (size_t r = 0; r < table.rows(); ++r)
+            squares += (col[r] - mean) * (col[r] - mean);
+        stats[c].mean = (float)mean;
+        stats[c].stddev = (float)sqrt(squares / table.rows());
+        float threshold = c < thresholds.size() ? thresholds[c] : (float)THRESHOLD;
+        for (size_t r = 0; r < table.rows(); ++r)
+            stats[c].outliers += fabsf((col[r] - stats[c].mean) / stats[c].stddev) > threshold;
+    }
+    return stats;
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <math.h>
+#include <emmintrin.h>
+#include <immintrin.h>
+#include <xmmintrin.h>
+#include "../../../common/perf_counters.hpp"
+
+#define THRESHOLD 1.5
+
+// Serial implementation to calculate mean and standard deviation
+inline void meanAndSTD_Serial(float *array, int size, float *mean, float *STDev)
+{
+    PERF_REGION("meanAndSTD_Serial", 2.0 * size * sizeof(float), 4.0 * size);
+    float temp, temp_mean, square, subb;
+    temp = 0.0f;
+    for (int i = 0; i < size; i++)
+        temp += array[i];
+
+    temp_mean = temp / size;
+    *mean = temp_mean;
+    temp = 0.0f;
+
+    for (int i = 0; i < size; i++)
+    {
+        subb = array[i] - temp_mean;
+        square = subb * subb;
+        temp += square;
+    }
+
+    *STDev = sqrt(temp / size);
+}
+
+// Serial implementation to count outliers based on Z-Score
+inline int countOutliers_Serial(float *array, int size, float mean, float stddev)
+{
+    PERF_REGION("countOutliers_Serial", 1.0 * size * sizeof(float), 3.0 * size);
+    int outliers = 0;
+    for (int i = 0; i < size; i++)
+    {
+        float zScore = fabs((array[i] - mean) / stddev);
+        if (zScore > THRESHOLD)
+        {
+            outliers++;
+        }
+    }
+    return outliers;
+}
+// Parallel implementation to calculate mean and standard deviation using SSE
+inline void meanAndSTD_Parallel(float *array, int size, float *mean, float *STDev)
+{
+    // Two passes over the array: sum, then sum of squared deviations
+    PERF_REGION("meanAndSTD_Parallel", 2.0 * size * sizeof(float), 4.0 * size);
+    __m128 temp_mean;
+    __m128 vec, A, B;
+    __m128 temp = _mm_set1_ps(0.0f);
+    int i = 0;
+    for (; i + 3 < size; i += 4)
+    {
+        vec = _mm_loadu_ps(&array[i]);
+        temp = _mm_add_ps(temp, vec);
+    }
+    temp = _mm_hadd_ps(temp, temp);
+    temp = _mm_hadd_ps(temp, temp);
+    float sum = _mm_cvtss_f32(temp);
+    // Tail of fewer than 4 elements
+    for (int j = i; j < size; j++)
+        sum += array[j];
+    *mean = sum / size;
+    temp_mean = _mm_set1_ps(*mean);
+
+    temp = _mm_set1_ps(0.0f);
+    for (i = 0; i + 3 < size; i += 4)
+    {
+        vec = _mm_loadu_ps(&array[i]);
+        A = _mm_sub_ps(vec, temp_mean);
+        B = _mm_mul_ps(A, A);
+        temp = _mm_add_ps(temp, B);
+    }
+    temp = _mm_hadd_ps(temp, temp);
+    temp = _mm_hadd_ps(temp, temp);
+    float squares = _mm_cvtss_f32(temp);
+    for (int j = i; j < size; j++)
+    {
+        float subb = array[j] - *mean;
+        squares += subb * subb;
+    }
+    *STDev = sqrt(squares / size);
+}
+
+// Custom function for absolute value (SSE)
+// Corrected custom function for absolute value (SSE)
+inline __m128 _mm_abs_ps_custom(__m128 x)
+{
+    __m128 signMask = _mm_set1_ps(-0.0f); // Set a mask to isolate the sign bit
+    return _mm_andnot_ps(signMask, x);    // Mask out the sign bit
+}
+
+// Parallel implementation to count outliers based on Z-Score using SSE
+inline int countOutliers_Parallel(float *array, int size, float mean, float stddev)
+{
+    PERF_REGION("countOutliers_Parallel", 1.0 * size * sizeof(float), 3.0 * size);
+    __m128 meanVec = _mm_set1_ps(mean);     // Set mean value for all elements
+    __m128 stddevVec = _mm_set1_ps(stddev); // Set stddev value for all elements
+    int outliers = 0;
+    int i = 0;
+
+    // Process 4 elements at a time using SSE
+    for (; i + 3 < size; i += 4)
+    {
+        __m128 data = _mm_loadu_ps(&array[i]); // Load 4 values from the array
+
+        // Subtract mean and divide by stddev (Z-Score)
+        __m128 zScores = _mm_sub_ps(data, meanVec);
+        zScores = _mm_div_ps(zScores, stddevVec);
+
+        // Use custom absolute value function
+        __m128 absZScores = _mm_abs_ps_custom(zScores);
+
+        // Compare Z-Score with THRESHOLD and count outliers
+        __m128 threshold = _mm_set1_ps(THRESHOLD);
+        __m128 cmp = _mm_cmpgt_ps(absZScores, threshold); // Compare abs(Z) > THRESHOLD
+
+        // Count outliers by summing the results
+        int mask = _mm_movemask_ps(cmp);
+        outliers += __builtin_popcount(mask); // Count the number of 1's in the mask
+    }
+
+    // Handle the remaining elements (less than 4 elements)
+    for (; i < size; ++i)
+    {
+        float zScore = fabs((array[i] - mean) / stddev);
+        if (zScore > THRESHOLD)
+        {
+            ++outliers;
+        }
+    }
+
+    return outliers;
+}
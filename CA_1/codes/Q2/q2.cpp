@@ -6,132 +6,113 @@
 #include <immintrin.h>
 #include <xmmintrin.h>
 #include <chrono> // Include chrono for timing
+#include <string>
+#include <vector>
+#include "outliers.hpp"
+#include "columnar.hpp"
 
 #define ARRAY_SIZE (1 << 20) // 2^20 (1,048,576) elements
-#define THRESHOLD 1.5
 
-// Serial implementation to calculate mean and standard deviation
-void meanAndSTD_Serial(float *array, int size, float *mean, float *STDev)
+// Every column of a table at once (columnar.hpp):
+//   --table file.csv                    [--threshold t] [--threshold column=t]...
+//   --table file.f32 cols               row-major float32
+//   --table random rows cols            synthetic normal columns with spikes
+static int runTableMode(int argc, char **argv)
 {
-    float temp, temp_mean, square, subb;
-    temp = 0.0f;
-    for (int i = 0; i < size; i++)
-        temp += array[i];
+    using namespace std::chrono;
 
-    temp_mean = temp / size;
-    *mean = temp_mean;
-    temp = 0.0f;
-
-    for (int i = 0; i < size; i++)
-    {
-        subb = array[i] - temp_mean;
-        square = subb * subb;
-        temp += square;
-    }
-
-    *STDev = sqrt(temp / size);
-}
-
-// Serial implementation to count outliers based on Z-Score
-int countOutliers_Serial(float *array, int size, float mean, float stddev)
-{
-    int outliers = 0;
-    for (int i = 0; i < size; i++)
+    std::vector<std::string> positional;
+    std::vector<std::pair<std::string, float>> columnThresholds;
+    float defaultThreshold = THRESHOLD;
+    for (int i = 2; i < argc; i++)
     {
-        float zScore = fabs((array[i] - mean) / stddev);
-        if (zScore > THRESHOLD)
+        std::string arg = argv[i];
+        if (arg == "--threshold" && i + 1 < argc)
         {
-            outliers++;
+            std::string value = argv[++i];
+            size_t eq = value.rfind('=');
+            if (eq == std::string::npos)
+                defaultThreshold = atof(value.c_str());
+            else
+                columnThresholds.push_back({value.substr(0, eq), (float)atof(value.c_str() + eq + 1)});
         }
+        else
+            positional.push_back(arg);
     }
-    return outliers;
-}
-// Parallel implementation to calculate mean and standard deviation using SSE
-void meanAndSTD_Parallel(float *array, int size, float *mean, float *STDev)
-{
-    __m128 temp_mean;
-    __m128 vec, A, B;
-    __m128 temp = _mm_set1_ps(0.0f);
-    for (int i = 0; i < size; i += 4)
+
+    ColumnTable table;
+    auto start = high_resolution_clock::now();
+    bool loaded;
+    if (positional.size() >= 3 && positional[0] == "random")
     {
-        vec = _mm_loadu_ps(&array[i]);
-        temp = _mm_add_ps(temp, vec);
+        table = randomTable(atol(positional[1].c_str()), atol(positional[2].c_str()), 42);
+        loaded = table.rows() > 0 && table.cols() > 0;
     }
-    temp = _mm_hadd_ps(temp, temp);
-    temp = _mm_hadd_ps(temp, temp);
-    *mean = _mm_cvtss_f32(temp) / size;
-    temp_mean = _mm_set1_ps(*mean);
-
-    temp = _mm_set1_ps(0.0f);
-    for (int i = 0; i < size; i += 4)
+    else if (positional.size() >= 2)
+        loaded = loadBinaryTable(positional[0], atol(positional[1].c_str()), table);
+    else if (positional.size() == 1)
+        loaded = loadCsvTable(positional[0], table);
+    else
     {
-        vec = _mm_loadu_ps(&array[i]);
-        A = _mm_sub_ps(vec, temp_mean);
-        B = _mm_mul_ps(A, A);
-        temp = _mm_add_ps(temp, B);
+        fprintf(stderr, "Usage: %s --table file.csv | file.f32 cols | random rows cols [--threshold [column=]t]...\n", argv[0]);
+        return 1;
     }
-    temp = _mm_hadd_ps(temp, temp);
-    temp = _mm_hadd_ps(temp, temp);
-    *STDev = sqrt(_mm_cvtss_f32(temp) / size);
-}
-
-// Custom function for absolute value (SSE)
-// Corrected custom function for absolute value (SSE)
-__m128 _mm_abs_ps_custom(__m128 x)
-{
-    __m128 signMask = _mm_set1_ps(-0.0f); // Set a mask to isolate the sign bit
-    return _mm_andnot_ps(signMask, x);    // Mask out the sign bit
-}
+    if (!loaded)
+        return 1;
+    double loadSeconds = duration<double>(high_resolution_clock::now() - start).count();
 
-// Parallel implementation to count outliers based on Z-Score using SSE
-int countOutliers_Parallel(float *array, int size, float mean, float stddev)
-{
-    __m128 meanVec = _mm_set1_ps(mean);     // Set mean value for all elements
-    __m128 stddevVec = _mm_set1_ps(stddev); // Set stddev value for all elements
-    int outliers = 0;
-    int i = 0;
-
-    // Process 4 elements at a time using SSE
-    for (i; i + 3 < size; i += 4)
+    std::vector<float> thresholds(table.cols(), defaultThreshold);
+    for (const auto &ct : columnThresholds)
     {
-        __m128 data = _mm_loadu_ps(&array[i]); // Load 4 values from the array
-
-        // Subtract mean and divide by stddev (Z-Score)
-        __m128 zScores = _mm_sub_ps(data, meanVec);
-        zScores = _mm_div_ps(zScores, stddevVec);
-
-        // Use custom absolute value function
-        __m128 absZScores = _mm_abs_ps_custom(zScores);
-
-        // Debugging: Print Z-scores
-        float temp[4];
-        _mm_storeu_ps(temp, absZScores);
-        // printf("Z-Scores: %f %f %f %f\n", temp[0], temp[1], temp[2], temp[3]);
+        auto it = std::find(table.names.begin(), table.names.end(), ct.first);
+        if (it == table.names.end())
+        {
+            fprintf(stderr, "No column named %s\n", ct.first.c_str());
+            return 1;
+        }
+        thresholds[it - table.names.begin()] = ct.second;
+    }
 
-        // Compare Z-Score with 2.5 and count outliers
-        __m128 threshold = _mm_set1_ps(THRESHOLD);
-        __m128 cmp = _mm_cmpgt_ps(absZScores, threshold); // Compare abs(Z) > 2.5
+    start = high_resolution_clock::now();
+    std::vector<ColumnStats> serial = columnOutliers_Serial(table, thresholds);
+    double serialSeconds = duration<double>(high_resolution_clock::now() - start).count();
 
-        // Count outliers by summing the results
-        int mask = _mm_movemask_ps(cmp);
-        outliers += __builtin_popcount(mask); // Count the number of 1's in the mask
-    }
+    // One untimed run, so page faults and thread start-up stay out of the timing
+    columnOutliers_Parallel(table, thresholds);
+    start = high_resolution_clock::now();
+    std::vector<ColumnStats> parallel = columnOutliers_Parallel(table, thresholds);
+    double parallelSeconds = duration<double>(high_resolution_clock::now() - start).count();
 
-    // Handle the remaining elements (less than 4 elements)
-    for (; i < size; ++i)
+    long totalOutliers = 0, countMismatches = 0;
+    double worstMean = 0;
+    for (size_t c = 0; c < table.cols(); c++)
     {
-        float zScore = fabs((array[i] - mean) / stddev);
-        if (zScore > 2.5)
-        {
-            ++outliers;
-        }
+        totalOutliers += parallel[c].outliers;
+        countMismatches += parallel[c].outliers != serial[c].outliers;
+        worstMean = std::max(worstMean, (double)fabsf(parallel[c].mean - serial[c].mean) / std::max(1e-6f, serial[c].stddev));
     }
 
-    return outliers;
+    printf("\nTable: %zu rows x %zu columns (loaded in %f s)\n", table.rows(), table.cols(), loadSeconds);
+    for (size_t c = 0; c < table.cols() && c < 8; c++)
+        printf("    %-12s mean = %f  sigma = %f  outliers (|z| > %.2f) = %ld\n", table.names[c].c_str(), parallel[c].mean,
+               parallel[c].stddev, thresholds[c], parallel[c].outliers);
+    if (table.cols() > 8)
+        printf("    ... %zu more columns\n", table.cols() - 8);
+    printf("Outliers, all columns: %ld\n", totalOutliers);
+    printf("Columns whose count differs from serial: %ld (largest mean difference %g sigma)\n", countMismatches, worstMean);
+
+    double cells = (double)table.rows() * table.cols();
+    printf("\nSerial Run time = %f s (%.1f M rows x columns/s)\n", serialSeconds, cells / serialSeconds / 1e6);
+    printf("Parallel Run time = %f s (%.1f M rows x columns/s, %d threads)\n", parallelSeconds, cells / parallelSeconds / 1e6, omp_get_max_threads());
+    printf("\tSpeedup = %f\n\n", serialSeconds / parallelSeconds);
+    return 0;
 }
 
-int main(void)
+int main(int argc, char **argv)
 {
+    if (argc >= 2 && std::string(argv[1]) == "--table")
+        return runTableMode(argc, argv);
+
     using namespace std::chrono; // Use std::chrono for time measurements
 
     float mean_ser, sigma_ser;
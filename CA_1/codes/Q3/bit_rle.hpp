@@ -0,0 +1,273 @@
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <emmintrin.h>  // For SSE2 intrinsics
+
+// Bit-level RLE for binary masks (segmentation / motion maps).
+//
+// A mask of n pixels is packed to 1 bpp, bit i of word i / 64 being pixel i
+// (nonzero = 1). The encoded form is a byte string of LEB128 varints:
+//
+//   n, run_0, run_1, run_2, ...
+//
+// where the runs alternate 0-pixels, 1-pixels, 0-pixels, ... and add up to n
+// (run_0 is 0 when the mask starts with a 1). Encoding looks at 64 pixels per
+// step: w ^ (w << 1 | carry) has a bit set exactly where a run starts, and
+// tzcnt walks those bits; words without a transition are skipped whole.
+// AND / OR work run by run on two encoded masks, never expanding them.
+
+// ---- Varints -----------------------------------------------------------------
+
+// Bytes of the LEB128 encoding of v: 7 payload bits per byte, from lzcnt
+inline int varint_size(uint64_t v) {
+    return (64 - __builtin_clzll(v | 1) + 6) / 7;
+}
+
+inline void put_varint(std::string& out, uint64_t v) {
+    while (v >= 0x80) {
+        out += (char)(v | 0x80);
+        v >>= 7;
+    }
+    out += (char)v;
+}
+
+// False at the end of the input or on a truncated varint
+inline bool get_varint(const std::string& in, size_t& pos, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; pos < in.size() && shift < 64; shift += 7) {
+        unsigned char byte = (unsigned char)in[pos++];
+        v |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+// ---- Packing -------------------------------------------------------------------
+
+// 1 bpp, little-endian bit order; bits past n are zero
+inline std::vector<uint64_t> pack_mask_serial(const unsigned char* mask, size_t n) {
+    std::vector<uint64_t> bits((n + 63) / 64, 0);
+    for (size_t i = 0; i < n; i++)
+        if (mask[i])
+            bits[i / 64] |= (uint64_t)1 << (i % 64);
+    return bits;
+}
+
+// 16 pixels per compare + movemask, four of them per word
+inline std::vector<uint64_t> pack_mask_simd(const unsigned char* mask, size_t n) {
+    std::vector<uint64_t> bits((n + 63) / 64, 0);
+    const __m128i zero = _mm_setzero_si128();
+    size_t w = 0;
+    for (; (w + 1) * 64 <= n; w++) {
+        uint64_t word = 0;
+        for (int k = 0; k < 4; k++) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mask + w * 64 + k * 16));
+            uint64_t zeros = (uint64_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero));
+            word |= (~zeros & 0xFFFF) << (k * 16);
+        }
+        bits[w] = word;
+    }
+    for (size_t i = w * 64; i < n; i++)
+        if (mask[i])
+            bits[i / 64] |= (uint64_t)1 << (i % 64);
+    return bits;
+}
+
+// ---- Encoding --------------------------------------------------------------------
+
+// Reference: one pixel at a time from the byte mask
+inline std::string bitrle_encode_serial(const unsigned char* mask, size_t n) {
+    std::string out;
+    put_varint(out, n);
+    bool value = false;
+    uint64_t run = 0;
+    for (size_t i = 0; i < n; i++) {
+        if ((mask[i] != 0) != value) {
+            put_varint(out, run);
+            value = !value;
+            run = 0;
+        }
+        run++;
+    }
+    put_varint(out, run);
+    return out;
+}
+
+// From a packed mask, 64 pixels per step
+inline std::string bitrle_encode(const std::vector<uint64_t>& bits, size_t n) {
+    std::string out;
+    out.reserve(16);
+    put_varint(out, n);
+    uint64_t run_start = 0;  // first pixel of the open run
+    uint64_t carry = 0;      // last pixel of the previous word; the mask starts in a 0-run
+    size_t words = (n + 63) / 64;
+    for (size_t w = 0; w < words; w++) {
+        uint64_t word = bits[w];
+        // Bit j set: pixel 64w + j differs from the one before it
+        uint64_t starts = word ^ (word << 1 | carry);
+        if (w + 1 == words && n % 64)
+            starts &= ((uint64_t)1 << (n % 64)) - 1;
+        carry = word >> 63;
+        while (starts) {
+            uint64_t pos = w * 64 + __builtin_ctzll(starts);
+            put_varint(out, pos - run_start);
+            run_start = pos;
+            starts &= starts - 1;  // clear the lowest set bit
+        }
+    }
+    put_varint(out, n - run_start);
+    return out;
+}
+
+// Size in bytes of the encoding, without building it
+inline size_t bitrle_encoded_size(const std::vector<uint64_t>& bits, size_t n) {
+    size_t size = varint_size(n);
+    uint64_t run_start = 0, carry = 0;
+    size_t words = (n + 63) / 64;
+    for (size_t w = 0; w < words; w++) {
+        uint64_t starts = bits[w] ^ (bits[w] << 1 | carry);
+        if (w + 1 == words && n % 64)
+            starts &= ((uint64_t)1 << (n % 64)) - 1;
+        carry = bits[w] >> 63;
+        while (starts) {
+            uint64_t pos = w * 64 + __builtin_ctzll(starts);
+            size += varint_size(pos - run_start);
+            run_start = pos;
+            starts &= starts - 1;
+        }
+    }
+    return size + varint_size(n - run_start);
+}
+
+// ---- Reading runs ------------------------------------------------------------------
+
+// Walks the runs of an encoded mask. Past the last run it reports one
+// endless 0-run, so masks of different lengths combine as if zero-padded.
+struct bitrle_reader {
+    const std::string& in;
+    size_t pos = 0;
+    uint64_t pixels = 0;
+    bool value = true;  // toggled before the first run, which is a 0-run
+    uint64_t left = 0;  // pixels left in the current run
+
+    explicit bitrle_reader(const std::string& encoded) : in(encoded) {
+        if (!get_varint(in, pos, pixels))
+            pixels = 0;
+    }
+
+    // Moves to the next non-empty run
+    void advance() {
+        uint64_t run;
+        do {
+            if (!get_varint(in, pos, run)) {
+                value = false;
+                left = UINT64_MAX;
+                return;
+            }
+            value = !value;
+        } while (run == 0);
+        left = run;
+    }
+};
+
+// Appends runs, merging neighbours of the same value
+struct bitrle_writer {
+    std::string out;
+    bool value = false;
+    uint64_t pending = 0;
+
+    explicit bitrle_writer(uint64_t pixels) { put_varint(out, pixels); }
+
+    void add(bool v, uint64_t run) {
+        if (run == 0)
+            return;
+        if (v != value) {
+            put_varint(out, pending);
+            value = v;
+            pending = 0;
+        }
+        pending += run;
+    }
+
+    std::string finish() {
+        put_varint(out, pending);
+        return out;
+    }
+};
+
+inline uint64_t bitrle_pixels(const std::string& encoded) {
+    size_t pos = 0;
+    uint64_t n = 0;
+    return get_varint(encoded, pos, n) ? n : 0;
+}
+
+// Pixels set, summed over the 1-runs
+inline uint64_t bitrle_count(const std::string& encoded) {
+    bitrle_reader r(encoded);
+    uint64_t count = 0, seen = 0;
+    while (seen < r.pixels) {
+        r.advance();
+        uint64_t run = std::min(r.left, r.pixels - seen);
+        if (r.value)
+            count += run;
+        seen += run;
+    }
+    return count;
+}
+
+// ---- Set operations on runs ------------------------------------------------------------
+
+// op(a, b) over max(n_a, n_b) pixels, in time linear in the number of runs
+template <class Op>
+inline std::string bitrle_combine(const std::string& a, const std::string& b, Op op) {
+    bitrle_reader ra(a), rb(b);
+    uint64_t n = std::max(ra.pixels, rb.pixels);
+    bitrle_writer out(n);
+    for (uint64_t done = 0; done < n;) {
+        if (ra.left == 0)
+            ra.advance();
+        if (rb.left == 0)
+            rb.advance();
+        uint64_t step = std::min(std::min(ra.left, rb.left), n - done);
+        out.add(op(ra.value, rb.value), step);
+        ra.left -= step;
+        rb.left -= step;
+        done += step;
+    }
+    return out.finish();
+}
+
+inline std::string bitrle_and(const std::string& a, const std::string& b) {
+    return bitrle_combine(a, b, [](bool x, bool y) { return x && y; });
+}
+
+inline std::string bitrle_or(const std::string& a, const std::string& b) {
+    return bitrle_combine(a, b, [](bool x, bool y) { return x || y; });
+}
+
+// ---- Decoding ---------------------------------------------------------------------------
+
+// Back to 1 bpp; 1-runs are filled a word at a time
+inline std::vector<uint64_t> bitrle_decode(const std::string& encoded, size_t& n) {
+    bitrle_reader r(encoded);
+    n = r.pixels;
+    std::vector<uint64_t> bits((n + 63) / 64, 0);
+    for (uint64_t pos = 0; pos < n;) {
+        r.advance();
+        uint64_t end = std::min<uint64_t>(n, r.left == UINT64_MAX ? n : pos + r.left);
+        if (r.value) {
+            for (uint64_t p = pos; p < end;) {
+                uint64_t bit = p % 64, take = std::min<uint64_t>(64 - bit, end - p);
+                uint64_t ones = take == 64 ? ~(uint64_t)0 : (((uint64_t)1 << take) - 1) << bit;
+                bits[p / 64] |= ones;
+                p += take;
+            }
+        }
+        pos = end;
+    }
+    return bits;
+}
@@ -3,87 +3,121 @@
 #include <smmintrin.h>  // For SSE4.1
 #include <emmintrin.h>  // For SSE2 intrinsics
 #include <chrono>        // For chrono
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "rle.hpp"
+#include "bit_rle.hpp"
 
 using namespace std;
 
-
-// Serial RLE Compression
-string rle_compress_serial(const string& input) {
-    string result = "";
-    int n = input.length();
-    for (int i = 0; i < n; i++) {
-        int count = 1;
-        while (i + 1 < n && input[i] == input[i + 1]) { // Avoid out-of-bounds
-            count++;
-            i++;
-        }
-        result += input[i];
-        result += to_string(count);  // Concatenate count properly as a string
+// Binary PGM (P5, 8 bit); any nonzero pixel is set
+static bool read_pgm_mask(const string& path, vector<unsigned char>& mask, int& width, int& height) {
+    FILE* file = fopen(path.c_str(), "rb");
+    int maxval;
+    if (!file || fscanf(file, "P5 %d %d %d", &width, &height, &maxval) != 3 || maxval > 255 || fgetc(file) == EOF) {
+        cerr << "Error reading " << path << " (expected a binary 8-bit PGM)\n";
+        if (file)
+            fclose(file);
+        return false;
     }
-    return result;
+    mask.resize((size_t)width * height);
+    bool ok = fread(mask.data(), 1, mask.size(), file) == mask.size();
+    fclose(file);
+    if (!ok)
+        cerr << "Error reading " << path << ": file is truncated\n";
+    return ok;
 }
 
-string rle_compress_simd(const string& input) {
-    string result = "";
-    int n = input.length();
-    int i = 0;
-
-    // Process input in chunks of 16 characters (128-bit blocks)
-    for (i; i <= n - 16; i += 16) {
-        // Load 16 bytes (characters) into an SSE register
-        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input.c_str() + i));
-
-        // Compare each byte with the previous byte
-        __m128i cmp = _mm_cmpeq_epi8(chunk, _mm_srli_si128(chunk, 1)); // Compare each byte with the one next to it
-
-        int count = 1;  // count is the length of the current run
-        char last_char = input[i];  // the character being counted
-        
-        for (int j = 1; j < 16; j++) {
-            // Extract the comparison result into a bitmask
-            int mask = _mm_movemask_epi8(cmp);
-            
-            // Check the specific bit corresponding to the current position
-            if ((mask & (1 << j)) == 0) {
-                // A new character or different run, record the previous run
-                result += last_char;
-                result += to_string(count);  // Use to_string for count
-                
-                // Start counting the new run
-                last_char = input[i + j];
-                count = 1;
-            } else {
-                count++;
-            }
-        }
-
-        // After finishing the loop, add the last run (16th character)
-        result += last_char;
-        result += to_string(count);
+// Random filled ellipses, like a segmentation or motion map
+static vector<unsigned char> random_blob_mask(int width, int height, int blobs, unsigned seed) {
+    vector<unsigned char> mask((size_t)width * height, 0);
+    mt19937 gen(seed);
+    for (int b = 0; b < blobs; b++) {
+        float cx = gen() % width, cy = gen() % height;
+        float rx = 1 + gen() % max(1, width / 8), ry = 1 + gen() % max(1, height / 8);
+        for (int y = max(0, (int)(cy - ry)); y < min(height, (int)(cy + ry) + 1); y++)
+            for (int x = max(0, (int)(cx - rx)); x < min(width, (int)(cx + rx) + 1); x++)
+                if ((x - cx) * (x - cx) / (rx * rx) + (y - cy) * (y - cy) / (ry * ry) <= 1)
+                    mask[(size_t)y * width + x] = 255;
     }
+    return mask;
+}
 
-    // Handle remaining characters (less than 16 characters left)
-    for (; i < n; i++) {
-        int count = 1;
-        while (i + 1 < n && input[i] == input[i + 1]) {  // Avoid out-of-bounds
-            count++;
-            i++;
+template <class F>
+static double seconds_of(F f) {
+    auto start = chrono::high_resolution_clock::now();
+    f();
+    return chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+}
+
+// --mask a.pgm b.pgm | --mask random width height: bit-level RLE of two masks
+// and AND / OR on their encoded forms
+static int run_mask_mode(int argc, char** argv) {
+    vector<unsigned char> a, b;
+    int width = 0, height = 0, width_b = 0, height_b = 0;
+    if (argc >= 5 && string(argv[2]) == "random") {
+        width = width_b = atoi(argv[3]);
+        height = height_b = atoi(argv[4]);
+        if (width <= 0 || height <= 0) {
+            cerr << "Mask size must be positive\n";
+            return 1;
         }
-        result += input[i];
-        result += to_string(count);  // Properly append the count as a string
+        a = random_blob_mask(width, height, 40, 1);
+        b = random_blob_mask(width, height, 40, 2);
+    } else if (argc >= 4) {
+        if (!read_pgm_mask(argv[2], a, width, height) || !read_pgm_mask(argv[3], b, width_b, height_b))
+            return 1;
+    } else {
+        cerr << "Usage: " << argv[0] << " --mask a.pgm b.pgm | --mask random width height\n";
+        return 1;
     }
-
-    return result;
+    size_t n = a.size();
+
+    vector<uint64_t> packed_a, packed_b;
+    string serial_a, rle_a, rle_b, rle_and, rle_or;
+    double t_pack = seconds_of([&] { packed_a = pack_mask_simd(a.data(), a.size()); packed_b = pack_mask_simd(b.data(), b.size()); });
+    double t_serial = seconds_of([&] { serial_a = bitrle_encode_serial(a.data(), a.size()); });
+    double t_encode = seconds_of([&] { rle_a = bitrle_encode(packed_a, a.size()); });
+    rle_b = bitrle_encode(packed_b, b.size());
+    double t_and = seconds_of([&] { rle_and = bitrle_and(rle_a, rle_b); });
+    double t_or = seconds_of([&] { rle_or = bitrle_or(rle_a, rle_b); });
+
+    // The same operations on the 1 bpp words, for comparison and as the check
+    size_t words = max(packed_a.size(), packed_b.size());
+    packed_a.resize(words, 0);
+    packed_b.resize(words, 0);
+    vector<uint64_t> word_and(words), word_or(words);
+    double t_words = seconds_of([&] {
+        for (size_t w = 0; w < words; w++) {
+            word_and[w] = packed_a[w] & packed_b[w];
+            word_or[w] = packed_a[w] | packed_b[w];
+        }
+    });
+    size_t n_max = max(a.size(), b.size());
+    bool ok = rle_a == serial_a && rle_and == bitrle_encode(word_and, n_max) && rle_or == bitrle_encode(word_or, n_max);
+    size_t n_decoded;
+    ok = ok && bitrle_decode(rle_a, n_decoded) == vector<uint64_t>(packed_a.begin(), packed_a.begin() + (n + 63) / 64);
+
+    cout << "Masks: " << width << "x" << height << " and " << width_b << "x" << height_b << "\n";
+    cout << "Mask A: " << n << " bytes at 8 bpp, " << (n + 7) / 8 << " at 1 bpp, " << rle_a.size()
+         << " run-length encoded (" << bitrle_count(rle_a) << " pixels set)\n";
+    cout << "Compression ratio (8 bpp / RLE): " << (double)n / rle_a.size() << "\n";
+    cout << "Pack to 1 bpp (both masks): " << t_pack << " seconds\n";
+    cout << "Encode, pixel by pixel: " << t_serial << " seconds\n";
+    cout << "Encode, 64 pixels per step: " << t_encode << " seconds (speedup " << t_serial / t_encode << ")\n";
+    cout << "AND on runs: " << t_and << " seconds (" << bitrle_count(rle_and) << " pixels, " << rle_and.size() << " bytes)\n";
+    cout << "OR on runs: " << t_or << " seconds (" << bitrle_count(rle_or) << " pixels, " << rle_or.size() << " bytes)\n";
+    cout << "AND + OR on 1 bpp words: " << t_words << " seconds\n";
+    cout << (ok ? "All encodings match the pixel-by-pixel reference\n" : "MISMATCH against the pixel-by-pixel reference\n");
+    return ok ? 0 : 1;
 }
 
-// Calculate compression ratio
-double calculate_compression_ratio(const string& original, const string& compressed) {
-    double original_size = original.size();
-    double compressed_size = compressed.size();
-    return original_size / compressed_size;
-}
+int main(int argc, char** argv) {
+    if (argc >= 2 && string(argv[1]) == "--mask")
+        return run_mask_mode(argc, argv);
 
-int main() {
     string input;
     cout << "Enter the string to compress: ";
     cin >> input;
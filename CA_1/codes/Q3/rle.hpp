@@ -0,0 +1,66 @@
+#pragma once
+
+#include <string>
+#include <smmintrin.h>  // For SSE4.1
+#include <emmintrin.h>  // For SSE2 intrinsics
+
+// Serial RLE Compression
+inline std::string rle_compress_serial(const std::string& input) {
+    std::string result = "";
+    int n = input.length();
+    for (int i = 0; i < n; i++) {
+        int count = 1;
+        while (i + 1 < n && input[i] == input[i + 1]) { // Avoid out-of-bounds
+            count++;
+            i++;
+        }
+        result += input[i];
+        result += std::to_string(count);  // Concatenate count properly as a string
+    }
+    return result;
+}
+
+// SIMD RLE: runs may span 16-byte blocks, so the open run is carried from one
+// block to the next and only emitted where the character actually changes
+inline std::string rle_compress_simd(const std::string& input) {
+    std::string result = "";
+    int n = input.length();
+    const char* data = input.data();
+    int run_start = 0;  // first index of the run that is still open
+    int i = 0;
+
+    // Process input in chunks of 16 characters (128-bit blocks); the load at
+    // i + 1 needs one more byte, so the last block is left to the scalar loop
+    for (; i + 17 <= n; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 1));
+
+        // Bit j set: input[i + j] != input[i + j + 1], i.e. a run ends at i + j
+        unsigned ends = ~_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, next)) & 0xFFFF;
+        while (ends) {
+            int end = i + __builtin_ctz(ends);
+            result += data[end];
+            result += std::to_string(end - run_start + 1);
+            run_start = end + 1;
+            ends &= ends - 1;  // clear the lowest set bit
+        }
+    }
+
+    // Handle remaining characters, continuing the open run
+    for (; i < n; i++) {
+        if (i + 1 == n || data[i] != data[i + 1]) {
+            result += data[i];
+            result += std::to_string(i - run_start + 1);
+            run_start = i + 1;
+        }
+    }
+
+    return result;
+}
+
+// Calculate compression ratio
+inline double calculate_compression_ratio(const std::string& original, const std::string& compressed) {
+    double original_size = original.size();
+    double compressed_size = compressed.size();
+    return original_size / compressed_size;
+}
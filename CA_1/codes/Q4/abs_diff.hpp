@@ -0,0 +1,65 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include <emmintrin.h>
+#include <x86intrin.h>
+#include "../../../common/perf_counters.hpp"
+
+// SSE-based absolute difference: |a - b| = (a -sat b) | (b -sat a) on unsigned bytes
+inline void absDiff_SIMD(const cv::Mat &src1, const cv::Mat &src2, cv::Mat &dst)
+{
+    if (src1.size() != src2.size() || src1.type() != CV_8U || src2.type() != CV_8U)
+    {
+        std::cerr << "Input matrices must have the same size and be of type CV_8U." << std::endl;
+        return;
+    }
+    dst.create(src1.rows, src1.cols, CV_8U);
+    PERF_REGION("absDiff_SIMD", 3.0 * src1.total(), 1.0 * src1.total());
+
+    for (int row = 0; row < src1.rows; ++row)
+    {
+        const uchar *ptrSrc1 = src1.ptr<uchar>(row);
+        const uchar *ptrSrc2 = src2.ptr<uchar>(row);
+        uchar *ptrDst = dst.ptr<uchar>(row);
+
+        int col = 0;
+        for (; col + 16 <= src1.cols; col += 16)
+        {
+            __m128i xmm1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ptrSrc1 + col));
+            __m128i xmm2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ptrSrc2 + col));
+            __m128i xmmDiff = _mm_or_si128(_mm_subs_epu8(xmm1, xmm2), _mm_subs_epu8(xmm2, xmm1));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(ptrDst + col), xmmDiff);
+        }
+
+        // Tail of a row that is not a multiple of 16 bytes
+        for (; col < src1.cols; ++col)
+            ptrDst[col] = static_cast<uchar>(std::abs(static_cast<int>(ptrSrc1[col]) - static_cast<int>(ptrSrc2[col])));
+    }
+}
+
+// Serial absolute difference for comparison
+inline void absDiff_Serial(const cv::Mat &src1, const cv::Mat &src2, cv::Mat &dst)
+{
+    if (src1.size() != src2.size() || src1.type() != CV_8U || src2.type() != CV_8U)
+    {
+        std::cerr << "Input matrices must have the same size and be of type CV_8U." << std::endl;
+        return;
+    }
+    dst.create(src1.rows, src1.cols, CV_8U);
+    PERF_REGION("absDiff_Serial", 3.0 * src1.total(), 1.0 * src1.total());
+
+    for (int row = 0; row < src1.rows; ++row)
+    {
+        const uchar *ptrSrc1 = src1.ptr<uchar>(row);
+        const uchar *ptrSrc2 = src2.ptr<uchar>(row);
+        uchar *ptrDst = dst.ptr<uchar>(row);
+
+        for (int col = 0; col < src1.cols; ++col)
+        {
+            uchar pixel1 = ptrSrc1[col];
+            uchar pixel2 = ptrSrc2[col];
+            ptrDst[col] = std::abs(static_cast<int>(pixel1) - static_cast<int>(pixel2));
+        }
+    }
+}
@@ -0,0 +1,271 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <immintrin.h>
+#include <stdint.h>
+#include <iostream>
+#include "../../../common/perf_counters.hpp"
+
+// Adaptive background subtraction on gray frames, one pass per frame.
+// Per pixel the model keeps the background mean as 8.8 fixed point (2 bytes)
+// and, in Gaussian mode, the variance in gray levels^2 (2 more bytes):
+//   mean' = mean * (1 - a) + p * a,   var' = var * (1 - a) + d^2 * a,   d = |p - mean|
+// with a = learning rate in 0.16 fixed point. A pixel is foreground when
+//   running average: d > threshold
+//   Gaussian:        d^2 / 16 > max(var * k^2 / 16, minVariance / 16)
+// The SIMD kernels are bit-exact with the scalar one.
+enum BackgroundMode
+{
+    BG_RUNNING_AVERAGE,
+    BG_GAUSSIAN
+};
+
+struct BackgroundParams
+{
+    BackgroundMode mode = BG_RUNNING_AVERAGE;
+    float learningRate = 0.02f;  // a, fraction of the new frame blended in per update
+    int threshold = 25;          // running average: |p - mean| threshold
+    float k = 2.5f;              // Gaussian: foreground beyond k standard deviations (k < 4)
+    int minVariance = 64;        // Gaussian: variance floor, in gray levels^2
+    int initialVariance = 225;   // Gaussian: variance of a freshly seeded pixel
+};
+
+// Fixed-point constants shared by all kernels
+struct BackgroundCoeffs
+{
+    uint16_t alpha, keep;  // a and 1 - a in 0.16
+    uint16_t threshold;    // running average threshold
+    uint16_t k2;           // k^2 in 4.12
+    uint16_t minThreshold; // minVariance / 16
+};
+
+inline uint16_t backgroundUpdate(uint16_t value, uint16_t sample, const BackgroundCoeffs &c)
+{
+    return static_cast<uint16_t>(((uint32_t)value * c.keep >> 16) + ((uint32_t)sample * c.alpha >> 16));
+}
+
+inline void backgroundRow_Scalar(const uchar *src, uint16_t *mean, uint16_t *var, uchar *mask, int cols, BackgroundMode mode, const BackgroundCoeffs &c)
+{
+    for (int i = 0; i < cols; ++i)
+    {
+        int d = std::abs(src[i] - (mean[i] >> 8));
+        bool foreground;
+        if (mode == BG_GAUSSIAN)
+        {
+            uint16_t d2 = static_cast<uint16_t>(d * d);
+            uint16_t limit = std::max<uint16_t>((uint32_t)var[i] * c.k2 >> 16, c.minThreshold);
+            foreground = (d2 >> 4) > limit;
+            var[i] = backgroundUpdate(var[i], d2, c);
+        }
+        else
+            foreground = d > c.threshold;
+
+        mask[i] = foreground ? 255 : 0;
+        mean[i] = backgroundUpdate(mean[i], static_cast<uint16_t>(src[i] << 8), c);
+    }
+}
+
+// 8 pixels in 16-bit lanes; returns 0xFFFF lanes for foreground
+inline __m128i backgroundWords_SSE(__m128i p, __m128i &mean, __m128i &var, BackgroundMode mode, const BackgroundCoeffs &c)
+{
+    const __m128i keep = _mm_set1_epi16(static_cast<short>(c.keep));
+    const __m128i alpha = _mm_set1_epi16(static_cast<short>(c.alpha));
+
+    __m128i m8 = _mm_srli_epi16(mean, 8);
+    __m128i d = _mm_or_si128(_mm_subs_epu16(p, m8), _mm_subs_epu16(m8, p));
+    __m128i over;
+    if (mode == BG_GAUSSIAN)
+    {
+        __m128i d2 = _mm_mullo_epi16(d, d);
+        __m128i limit = _mm_mulhi_epu16(var, _mm_set1_epi16(static_cast<short>(c.k2)));
+        __m128i minLimit = _mm_set1_epi16(static_cast<short>(c.minThreshold));
+        limit = _mm_add_epi16(_mm_subs_epu16(limit, minLimit), minLimit); // unsigned max
+        over = _mm_subs_epu16(_mm_srli_epi16(d2, 4), limit);
+        var = _mm_add_epi16(_mm_mulhi_epu16(var, keep), _mm_mulhi_epu16(d2, alpha));
+    }
+    else
+        over = _mm_subs_epu16(d, _mm_set1_epi16(static_cast<short>(c.threshold)));
+
+    mean = _mm_add_epi16(_mm_mulhi_epu16(mean, keep), _mm_mulhi_epu16(_mm_slli_epi16(p, 8), alpha));
+    return _mm_xor_si128(_mm_cmpeq_epi16(over, _mm_setzero_si128()), _mm_set1_epi16(-1));
+}
+
+inline void backgroundRow_SSE(const uchar *src, uint16_t *mean, uint16_t *var, uchar *mask, int cols, BackgroundMode mode, const BackgroundCoeffs &c)
+{
+    const __m128i zero = _mm_setzero_si128();
+
+    int i = 0;
+    for (; i + 16 <= cols; i += 16)
+    {
+        __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        __m128i fg[2];
+        for (int h = 0; h < 2; ++h)
+        {
+            __m128i *meanPtr = reinterpret_cast<__m128i *>(mean + i + 8 * h);
+            __m128i *varPtr = reinterpret_cast<__m128i *>(var + i + 8 * h);
+            __m128i m = _mm_loadu_si128(meanPtr);
+            __m128i v = mode == BG_GAUSSIAN ? _mm_loadu_si128(varPtr) : zero;
+
+            fg[h] = backgroundWords_SSE(h ? _mm_unpackhi_epi8(p, zero) : _mm_unpacklo_epi8(p, zero), m, v, mode, c);
+
+            _mm_storeu_si128(meanPtr, m);
+            if (mode == BG_GAUSSIAN)
+                _mm_storeu_si128(varPtr, v);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(mask + i), _mm_packs_epi16(fg[0], fg[1]));
+    }
+
+    backgroundRow_Scalar(src + i, mean + i, var ? var + i : nullptr, mask + i, cols - i, mode, c);
+}
+
+__attribute__((target("avx2"))) inline __m256i backgroundWords_AVX2(__m256i p, __m256i &mean, __m256i &var, BackgroundMode mode, const BackgroundCoeffs &c)
+{
+    const __m256i keep = _mm256_set1_epi16(static_cast<short>(c.keep));
+    const __m256i alpha = _mm256_set1_epi16(static_cast<short>(c.alpha));
+
+    __m256i m8 = _mm256_srli_epi16(mean, 8);
+    __m256i d = _mm256_or_si256(_mm256_subs_epu16(p, m8), _mm256_subs_epu16(m8, p));
+    __m256i over;
+    if (mode == BG_GAUSSIAN)
+    {
+        __m256i d2 = _mm256_mullo_epi16(d, d);
+        __m256i limit = _mm256_max_epu16(_mm256_mulhi_epu16(var, _mm256_set1_epi16(static_cast<short>(c.k2))),
+                                         _mm256_set1_epi16(static_cast<short>(c.minThreshold)));
+        over = _mm256_subs_epu16(_mm256_srli_epi16(d2, 4), limit);
+        var = _mm256_add_epi16(_mm256_mulhi_epu16(var, keep), _mm256_mulhi_epu16(d2, alpha));
+    }
+    else
+        over = _mm256_subs_epu16(d, _mm256_set1_epi16(static_cast<short>(c.threshold)));
+
+    mean = _mm256_add_epi16(_mm256_mulhi_epu16(mean, keep), _mm256_mulhi_epu16(_mm256_slli_epi16(p, 8), alpha));
+    return _mm256_xor_si256(_mm256_cmpeq_epi16(over, _mm256_setzero_si256()), _mm256_set1_epi16(-1));
+}
+
+// 32 pixels per step; the in-lane unpack/pack pair keeps pixel order intact
+__attribute__((target("avx2"))) inline void backgroundRow_AVX2(const uchar *src, uint16_t *mean, uint16_t *var, uchar *mask, int cols, BackgroundMode mode, const BackgroundCoeffs &c)
+{
+    const __m256i zero = _mm256_setzero_si256();
+
+    int i = 0;
+    for (; i + 32 <= cols; i += 32)
+    {
+        __m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        // unpacklo covers pixels 0-7 and 16-23, unpackhi 8-15 and 24-31
+        __m256i words[2] = {_mm256_unpacklo_epi8(p, zero), _mm256_unpackhi_epi8(p, zero)};
+        __m256i fg[2];
+        for (int h = 0; h < 2; ++h)
+        {
+            // Gather the matching 16-bit state: lanes hold pixels (8h..8h+7) and (16+8h..16+8h+7)
+            __m128i *meanLo = reinterpret_cast<__m128i *>(mean + i + 8 * h);
+            __m128i *meanHi = reinterpret_cast<__m128i *>(mean + i + 16 + 8 * h);
+            __m256i m = _mm256_set_m128i(_mm_loadu_si128(meanHi), _mm_loadu_si128(meanLo));
+            __m256i v = zero;
+            __m128i *varLo = nullptr, *varHi = nullptr;
+            if (mode == BG_GAUSSIAN)
+            {
+                varLo = reinterpret_cast<__m128i *>(var + i + 8 * h);
+                varHi = reinterpret_cast<__m128i *>(var + i + 16 + 8 * h);
+                v = _mm256_set_m128i(_mm_loadu_si128(varHi), _mm_loadu_si128(varLo));
+            }
+
+            fg[h] = backgroundWords_AVX2(words[h], m, v, mode, c);
+
+            _mm_storeu_si128(meanLo, _mm256_castsi256_si128(m));
+            _mm_storeu_si128(meanHi, _mm256_extracti128_si256(m, 1));
+            if (mode == BG_GAUSSIAN)
+            {
+                _mm_storeu_si128(varLo, _mm256_castsi256_si128(v));
+                _mm_storeu_si128(varHi, _mm256_extracti128_si256(v, 1));
+            }
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(mask + i), _mm256_packs_epi16(fg[0], fg[1]));
+    }
+
+    backgroundRow_SSE(src + i, mean + i, var ? var + i : nullptr, mask + i, cols - i, mode, c);
+}
+
+class BackgroundModel
+{
+public:
+    explicit BackgroundModel(const BackgroundParams &params = BackgroundParams()) : params(params)
+    {
+        float a = std::min(std::max(params.learningRate, 0.0f), 1.0f);
+        // alpha + keep = 65536 keeps the blended state within 16 bits
+        coeffs.alpha = static_cast<uint16_t>(std::min(65535.0f, std::max(1.0f, a * 65536.0f + 0.5f)));
+        coeffs.keep = static_cast<uint16_t>(65536 - coeffs.alpha);
+        coeffs.threshold = static_cast<uint16_t>(params.threshold);
+        coeffs.k2 = static_cast<uint16_t>(std::min(65535.0f, params.k * params.k * 4096.0f));
+        coeffs.minThreshold = static_cast<uint16_t>(params.minVariance / 16);
+    }
+
+    // Update the model with a gray frame and write the foreground mask (0/255).
+    // The first frame (or a size change) seeds the model and yields an empty mask.
+    void apply(const cv::Mat &gray, cv::Mat &foreground, int isa = -1)
+    {
+        if (gray.type() != CV_8U)
+        {
+            std::cerr << "Input frame must be of type CV_8U." << std::endl;
+            return;
+        }
+        foreground.create(gray.rows, gray.cols, CV_8U);
+
+        if (mean.size() != gray.size())
+        {
+            mean.create(gray.rows, gray.cols, CV_16UC1);
+            if (params.mode == BG_GAUSSIAN)
+                variance.create(gray.rows, gray.cols, CV_16UC1);
+            for (int row = 0; row < gray.rows; ++row)
+            {
+                for (int col = 0; col < gray.cols; ++col)
+                {
+                    mean.ptr<uint16_t>(row)[col] = static_cast<uint16_t>(gray.ptr<uchar>(row)[col] << 8);
+                    if (params.mode == BG_GAUSSIAN)
+                        variance.ptr<uint16_t>(row)[col] = static_cast<uint16_t>(params.initialVariance);
+                }
+                std::fill(foreground.ptr<uchar>(row), foreground.ptr<uchar>(row) + gray.cols, 0);
+            }
+            return;
+        }
+
+        static const int detected = __builtin_cpu_supports("avx2") ? 2 : 1;
+        if (isa < 0)
+            isa = detected;
+
+        // Row bands are independent: each pixel only reads and writes its own state
+        cv::parallel_for_(cv::Range(0, gray.rows), [&](const cv::Range &range)
+                          {
+            // Per pixel: frame and mask bytes plus mean (and variance) read and written
+            double pixels = (double)(range.end - range.start) * gray.cols;
+            bool gaussian = params.mode == BG_GAUSSIAN;
+            PERF_REGION("BackgroundModel", pixels * (gaussian ? 10 : 6), pixels * (gaussian ? 16 : 8));
+            for (int row = range.start; row < range.end; ++row)
+            {
+                const uchar *src = gray.ptr<uchar>(row);
+                uint16_t *meanRow = mean.ptr<uint16_t>(row);
+                uint16_t *varRow = params.mode == BG_GAUSSIAN ? variance.ptr<uint16_t>(row) : nullptr;
+                uchar *maskRow = foreground.ptr<uchar>(row);
+
+                if (isa == 2)
+                    backgroundRow_AVX2(src, meanRow, varRow, maskRow, gray.cols, params.mode, coeffs);
+                else if (isa == 1)
+                    backgroundRow_SSE(src, meanRow, varRow, maskRow, gray.cols, params.mode, coeffs);
+                else
+                    backgroundRow_Scalar(src, meanRow, varRow, maskRow, gray.cols, params.mode, coeffs);
+            } });
+    }
+
+    // Current background estimate as an 8-bit image
+    void background(cv::Mat &dst) const
+    {
+        dst.create(mean.rows, mean.cols, CV_8U);
+        for (int row = 0; row < mean.rows; ++row)
+            for (int col = 0; col < mean.cols; ++col)
+                dst.ptr<uchar>(row)[col] = static_cast<uchar>(mean.ptr<uint16_t>(row)[col] >> 8);
+    }
+
+private:
+    BackgroundParams params;
+    BackgroundCoeffs coeffs;
+    cv::Mat mean;     // CV_16U, 8.8 fixed point
+    cv::Mat variance; // CV_16U, Gaussian mode only
+};
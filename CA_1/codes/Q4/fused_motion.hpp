@@ -0,0 +1,176 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <immintrin.h>
+#include <iostream>
+#include <vector>
+#include "../../../common/perf_counters.hpp"
+
+// BT.601 luma in 14-bit fixed point, the same coefficients cv::cvtColor uses for BGR2GRAY
+const int LUMA_B = 1868, LUMA_G = 9617, LUMA_R = 4899, LUMA_SHIFT = 14;
+
+inline uchar lumaBGR(const uchar *p)
+{
+    return static_cast<uchar>((p[0] * LUMA_B + p[1] * LUMA_G + p[2] * LUMA_R + (1 << (LUMA_SHIFT - 1))) >> LUMA_SHIFT);
+}
+
+// pshufb tables splitting 48 BGR bytes (three 16-byte chunks) into B, G and R planes
+alignas(16) static const int8_t LUMA_DEINTERLEAVE[3][3][16] = {
+    {{0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+     {-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1},
+     {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13}},
+    {{1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+     {-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1},
+     {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14}},
+    {{2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+     {-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1},
+     {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15}}};
+
+// Luma of 4 pixels: pairs (B,G) and (R,1) multiplied-and-added in 32 bits
+__attribute__((target("ssse3"))) inline __m128i luma4_SSE(__m128i b, __m128i g, __m128i r)
+{
+    const __m128i bgCoeff = _mm_set1_epi32((LUMA_G << 16) | LUMA_B);
+    const __m128i rCoeff = _mm_set1_epi32(((1 << (LUMA_SHIFT - 1)) << 16) | LUMA_R);
+    __m128i bg = _mm_madd_epi16(_mm_unpacklo_epi16(b, g), bgCoeff);
+    __m128i r1 = _mm_madd_epi16(_mm_unpacklo_epi16(r, _mm_set1_epi16(1)), rCoeff);
+    return _mm_srli_epi32(_mm_add_epi32(bg, r1), LUMA_SHIFT);
+}
+
+// One row of the fused kernel, 16 pixels per step:
+//   luma = Y(bgr); diff = |luma - prevLuma|; counts[col / 16] += #(diff > threshold)
+// Returns through `luma` and `diff`; `counts` has one entry per 16-pixel column group.
+__attribute__((target("ssse3"))) inline void fusedMotionRow_SSE(const uchar *bgr, const uchar *prevLuma, uchar *luma, uchar *diff, int cols, uchar threshold, int *counts)
+{
+    __m128i table[3][3];
+    for (int c = 0; c < 3; ++c)
+        for (int k = 0; k < 3; ++k)
+            table[c][k] = _mm_load_si128(reinterpret_cast<const __m128i *>(LUMA_DEINTERLEAVE[c][k]));
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i thresh = _mm_set1_epi8(static_cast<char>(threshold));
+
+    int col = 0;
+    for (; col + 16 <= cols; col += 16)
+    {
+        __m128i chunk[3], plane[3];
+        for (int k = 0; k < 3; ++k)
+            chunk[k] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bgr + 3 * col + 16 * k));
+        for (int c = 0; c < 3; ++c)
+            plane[c] = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(chunk[0], table[c][0]),
+                                                 _mm_shuffle_epi8(chunk[1], table[c][1])),
+                                    _mm_shuffle_epi8(chunk[2], table[c][2]));
+
+        // Widen the planes to 16 bits and compute 4 x 4 luma values
+        __m128i y[4];
+        for (int h = 0; h < 2; ++h)
+        {
+            __m128i b16 = h ? _mm_unpackhi_epi8(plane[0], zero) : _mm_unpacklo_epi8(plane[0], zero);
+            __m128i g16 = h ? _mm_unpackhi_epi8(plane[1], zero) : _mm_unpacklo_epi8(plane[1], zero);
+            __m128i r16 = h ? _mm_unpackhi_epi8(plane[2], zero) : _mm_unpacklo_epi8(plane[2], zero);
+            y[2 * h] = luma4_SSE(b16, g16, r16);
+            y[2 * h + 1] = luma4_SSE(_mm_srli_si128(b16, 8), _mm_srli_si128(g16, 8), _mm_srli_si128(r16, 8));
+        }
+        __m128i cur = _mm_packus_epi16(_mm_packs_epi32(y[0], y[1]), _mm_packs_epi32(y[2], y[3]));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(luma + col), cur);
+
+        // Unsigned |a - b| = (a -sat b) | (b -sat a)
+        __m128i prev = _mm_loadu_si128(reinterpret_cast<const __m128i *>(prevLuma + col));
+        __m128i d = _mm_or_si128(_mm_subs_epu8(cur, prev), _mm_subs_epu8(prev, cur));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(diff + col), d);
+
+        // diff > threshold  <=>  (diff -sat threshold) != 0
+        __m128i still = _mm_cmpeq_epi8(_mm_subs_epu8(d, thresh), zero);
+        counts[col >> 4] += 16 - __builtin_popcount(_mm_movemask_epi8(still));
+    }
+
+    for (; col < cols; ++col)
+    {
+        luma[col] = lumaBGR(bgr + 3 * col);
+        diff[col] = static_cast<uchar>(std::abs(luma[col] - prevLuma[col]));
+        counts[col >> 4] += diff[col] > threshold;
+    }
+}
+
+// Single-pass motion detector: BGR -> luma -> |luma - previous luma| -> threshold,
+// with double-buffered luma planes (swapped, never copied) and a per-block
+// motion bitmap (CV_8U, 255 where a block has more than minPixels moving pixels).
+class FusedMotionDetector
+{
+public:
+    explicit FusedMotionDetector(uchar threshold = 25, int blockSize = 16, int minPixels = 4)
+        : threshold(threshold), blockSize(std::max(16, blockSize / 16 * 16)), minPixels(minPixels), current(0), hasPrevious(false) {}
+
+    // Returns false for the first frame (only its luma is stored)
+    bool process(const cv::Mat &frame, cv::Mat &diff, cv::Mat &blockMask)
+    {
+        if (frame.type() != CV_8UC3)
+        {
+            std::cerr << "Input frame must be of type CV_8UC3." << std::endl;
+            return false;
+        }
+        if (luma[0].size() != frame.size())
+        {
+            luma[0].create(frame.rows, frame.cols, CV_8U);
+            luma[1].create(frame.rows, frame.cols, CV_8U);
+            hasPrevious = false;
+        }
+
+        cv::Mat &cur = luma[current];
+        cv::Mat &prev = luma[current ^ 1];
+        bool detected = hasPrevious;
+
+        if (!hasPrevious)
+        {
+            // Seed the previous plane with this frame so the first diff is all zero
+            for (int row = 0; row < frame.rows; ++row)
+                for (int col = 0; col < frame.cols; ++col)
+                    prev.ptr<uchar>(row)[col] = lumaBGR(frame.ptr<uchar>(row) + 3 * col);
+        }
+
+        int blockRows = (frame.rows + blockSize - 1) / blockSize;
+        int blockCols = (frame.cols + blockSize - 1) / blockSize;
+        int groups = (frame.cols + 15) / 16;
+        diff.create(frame.rows, frame.cols, CV_8U);
+        blockMask.create(blockRows, blockCols, CV_8U);
+
+        // Block rows are independent, so split them across threads
+        cv::parallel_for_(cv::Range(0, blockRows), [&](const cv::Range &range)
+                          {
+            std::vector<int> counts(groups);
+            // Per pixel: 3 bytes in, luma and diff out, previous luma in; ~8 ops for luma, diff and threshold
+            int bandRows = std::min(frame.rows, range.end * blockSize) - range.start * blockSize;
+            PERF_REGION("FusedMotionDetector", 6.0 * bandRows * frame.cols, 8.0 * bandRows * frame.cols);
+            for (int by = range.start; by < range.end; ++by)
+            {
+                std::fill(counts.begin(), counts.end(), 0);
+                int rowEnd = std::min(frame.rows, (by + 1) * blockSize);
+                for (int row = by * blockSize; row < rowEnd; ++row)
+                    fusedMotionRow_SSE(frame.ptr<uchar>(row), prev.ptr<uchar>(row), cur.ptr<uchar>(row),
+                                       diff.ptr<uchar>(row), frame.cols, threshold, counts.data());
+
+                uchar *maskRow = blockMask.ptr<uchar>(by);
+                int groupsPerBlock = blockSize / 16;
+                for (int bx = 0; bx < blockCols; ++bx)
+                {
+                    int moving = 0;
+                    for (int g = bx * groupsPerBlock; g < std::min(groups, (bx + 1) * groupsPerBlock); ++g)
+                        moving += counts[g];
+                    maskRow[bx] = moving > minPixels ? 255 : 0;
+                }
+            } });
+
+        current ^= 1;
+        hasPrevious = true;
+        return detected;
+    }
+
+    // Luma of the last processed frame
+    const cv::Mat &lastLuma() const { return luma[current ^ 1]; }
+
+private:
+    uchar threshold;
+    int blockSize;
+    int minPixels;
+    cv::Mat luma[2];
+    int current;
+    bool hasPrevious;
+};
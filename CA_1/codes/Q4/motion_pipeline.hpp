@@ -0,0 +1,296 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <thread>
+#include <vector>
+
+// Bounded lock-free multi-producer/multi-consumer queue (Vyukov's ring of
+// sequence-numbered cells). push()/pop() never block; they return false when
+// the queue is full/empty and callers decide how to wait.
+template <typename T>
+class MpmcQueue
+{
+public:
+    explicit MpmcQueue(size_t capacity)
+    {
+        size_t size = 2;
+        while (size < capacity)
+            size <<= 1;
+        cells = std::vector<Cell>(size);
+        mask = size - 1;
+        for (size_t i = 0; i < size; ++i)
+            cells[i].seq.store(i, std::memory_order_relaxed);
+        head.store(0, std::memory_order_relaxed);
+        tail.store(0, std::memory_order_relaxed);
+    }
+
+    bool push(const T &item)
+    {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Cell &cell = cells[pos & mask];
+            size_t seq = cell.seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0)
+            {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    cell.data = item;
+                    cell.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+                return false; // full
+            else
+                pos = tail.load(std::memory_order_relaxed);
+        }
+    }
+
+    bool pop(T &item)
+    {
+        size_t pos = head.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Cell &cell = cells[pos & mask];
+            size_t seq = cell.seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (diff == 0)
+            {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    item = cell.data;
+                    cell.seq.store(pos + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+                return false; // empty
+            else
+                pos = head.load(std::memory_order_relaxed);
+        }
+    }
+
+    // Spin (with yield) until there is room
+    void pushWait(const T &item)
+    {
+        while (!push(item))
+            std::this_thread::yield();
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> seq;
+        T data;
+        Cell() : seq(0), data() {}
+        Cell(const Cell &) : seq(0), data() {}
+    };
+
+    std::vector<Cell> cells;
+    size_t mask;
+    alignas(64) std::atomic<size_t> head;
+    alignas(64) std::atomic<size_t> tail;
+};
+
+// One preallocated frame buffer set; buffers keep their allocation across frames
+struct FrameSlot
+{
+    cv::Mat frame;  // decoded BGR frame
+    cv::Mat gray;   // luma of `frame`
+    cv::Mat motion; // processed output
+    long index = -1;
+    std::chrono::steady_clock::time_point captured;
+    std::atomic<bool> grayReady{false};
+    std::atomic<int> refs{0}; // released after it is encoded and the next frame has read `gray`
+};
+
+struct StreamStats
+{
+    long frames = 0;
+    double seconds = 0;
+    std::vector<double> latenciesMs; // capture -> encoded, per frame
+
+    double fps() const { return seconds > 0 ? frames / seconds : 0.0; }
+
+    double percentile(double p) const
+    {
+        if (latenciesMs.empty())
+            return 0.0;
+        std::vector<double> sorted(latenciesMs);
+        std::sort(sorted.begin(), sorted.end());
+        size_t k = std::min(sorted.size() - 1, (size_t)(p / 100.0 * sorted.size()));
+        return sorted[k];
+    }
+};
+
+inline void printStreamStats(const char *name, const StreamStats &s)
+{
+    printf("%s: %ld frames in %f seconds = %f fps\n", name, s.frames, s.seconds, s.fps());
+    printf("\tlatency p50 = %.2f ms, p90 = %.2f ms, p99 = %.2f ms, max = %.2f ms\n",
+           s.percentile(50), s.percentile(90), s.percentile(99), s.percentile(100));
+}
+
+struct MotionPipelineOptions
+{
+    int workers = 0;  // processing threads, 0 = cores - 2 (at least 1)
+    int poolSize = 0; // frame slots, 0 = 2 * workers + 4
+};
+
+// Per-frame processing: gray = luma(frame), motion = f(gray, prevGray)
+struct MotionStages
+{
+    std::function<void(const cv::Mat &frame, cv::Mat &gray)> toGray;
+    std::function<void(const cv::Mat &gray, const cv::Mat &prevGray, cv::Mat &motion)> detect;
+};
+
+// Headless motion detection with decoupled stages:
+//   decoder thread -> worker pool -> encoder thread
+// connected by lock-free queues of frame-slot indices. Frames are decoded into
+// a fixed pool of slots (no per-frame allocation once warmed up); workers may
+// finish out of order and the encoder restores frame order before writing.
+// `writer` may be null to measure processing only.
+inline StreamStats runMotionPipeline(cv::VideoCapture &cap, cv::VideoWriter *writer, const MotionStages &stages, MotionPipelineOptions opt = MotionPipelineOptions())
+{
+    using clock = std::chrono::steady_clock;
+
+    int cores = std::max(1u, std::thread::hardware_concurrency());
+    int workers = opt.workers > 0 ? opt.workers : std::max(1, cores - 2);
+    int poolSize = opt.poolSize > 0 ? opt.poolSize : 2 * workers + 4;
+
+    std::vector<FrameSlot> slots(poolSize);
+    MpmcQueue<int> freeSlots(poolSize), decoded(poolSize), processed(poolSize);
+    for (int i = 0; i < poolSize; ++i)
+        freeSlots.push(i);
+
+    std::atomic<bool> decodeDone(false);
+    std::atomic<int> workersLeft(workers);
+    // Previous slot of every frame index, written by the decoder before the frame is queued
+    std::vector<int> prevSlotOf(poolSize, -1);
+
+    StreamStats stats;
+    auto start = clock::now();
+
+    auto release = [&](int s)
+    {
+        if (slots[s].refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            freeSlots.pushWait(s);
+    };
+
+    std::thread decoder([&]
+                        {
+        long index = 0;
+        int prevSlot = -1;
+        for (;;)
+        {
+            int s;
+            while (!freeSlots.pop(s))
+                std::this_thread::yield();
+
+            FrameSlot &slot = slots[s];
+            if (!cap.read(slot.frame) || slot.frame.empty())
+            {
+                freeSlots.pushWait(s);
+                break;
+            }
+            slot.captured = clock::now();
+            slot.index = index++;
+            slot.grayReady.store(false, std::memory_order_relaxed);
+            slot.refs.store(2, std::memory_order_relaxed);
+            prevSlotOf[s] = prevSlot;
+            prevSlot = s;
+            decoded.pushWait(s);
+        }
+        // The last frame has no successor to read its gray plane
+        if (prevSlot >= 0)
+            release(prevSlot);
+        decodeDone.store(true, std::memory_order_release); });
+
+    auto worker = [&]
+    {
+        for (;;)
+        {
+            int s;
+            if (!decoded.pop(s))
+            {
+                if (!decodeDone.load(std::memory_order_acquire))
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+                if (!decoded.pop(s))
+                    break;
+            }
+
+            FrameSlot &slot = slots[s];
+            stages.toGray(slot.frame, slot.gray);
+            slot.grayReady.store(true, std::memory_order_release);
+
+            int p = prevSlotOf[s];
+            if (p >= 0)
+            {
+                // The predecessor was dequeued earlier, so its worker is already converting it
+                while (!slots[p].grayReady.load(std::memory_order_acquire))
+                    std::this_thread::yield();
+                stages.detect(slot.gray, slots[p].gray, slot.motion);
+                release(p);
+            }
+            else
+                slot.motion.release(); // first frame: nothing to diff against
+
+            processed.pushWait(s);
+        }
+        workersLeft.fetch_sub(1, std::memory_order_release);
+    };
+
+    std::thread encoder([&]
+                        {
+        std::map<long, int> pending; // reorder buffer: frame index -> slot
+        long next = 0;
+        for (;;)
+        {
+            int s;
+            if (!processed.pop(s))
+            {
+                if (workersLeft.load(std::memory_order_acquire) > 0)
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+                if (!processed.pop(s))
+                    break;
+            }
+            pending[slots[s].index] = s;
+
+            while (!pending.empty() && pending.begin()->first == next)
+            {
+                int ready = pending.begin()->second;
+                pending.erase(pending.begin());
+                FrameSlot &slot = slots[ready];
+                if (writer && !slot.motion.empty())
+                    writer->write(slot.motion);
+                stats.latenciesMs.push_back(std::chrono::duration<double, std::milli>(clock::now() - slot.captured).count());
+                ++next;
+                release(ready);
+            }
+        }
+        stats.frames = next; });
+
+    std::vector<std::thread> pool;
+    for (int i = 0; i < workers; ++i)
+        pool.emplace_back(worker);
+
+    decoder.join();
+    for (auto &t : pool)
+        t.join();
+    encoder.join();
+
+    stats.seconds = std::chrono::duration<double>(clock::now() - start).count();
+    return stats;
+}
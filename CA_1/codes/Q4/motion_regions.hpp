@@ -0,0 +1,229 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <immintrin.h>
+#include <iostream>
+#include <vector>
+
+const int MOTION_BLOCK = 16;
+
+struct MotionRegion
+{
+    cv::Rect box;   // in pixels
+    int blocks = 0; // moving 16x16 blocks in the region
+    long sad = 0;   // summed absolute difference over those blocks
+};
+
+struct MotionAnalysis
+{
+    std::vector<MotionRegion> regions;
+    int movingBlocks = 0;
+    double score = 0;        // fraction of blocks that moved
+    double meanAbsDiff = 0;  // over the whole frame
+};
+
+// Sum of absolute differences of 16-byte groups, accumulated into sad[col / 16]
+inline void blockSADRow_SSE(const uchar *cur, const uchar *prev, int cols, int *sad)
+{
+    int col = 0;
+    for (; col + 16 <= cols; col += 16)
+    {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(cur + col));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(prev + col));
+        __m128i s = _mm_sad_epu8(a, b); // two 64-bit partial sums
+        sad[col >> 4] += _mm_cvtsi128_si32(s) + _mm_extract_epi16(s, 4);
+    }
+    for (; col < cols; ++col)
+        sad[col >> 4] += std::abs(cur[col] - prev[col]);
+}
+
+// Two blocks per step: vpsadbw gives one partial sum per 8 bytes
+__attribute__((target("avx2"))) inline void blockSADRow_AVX2(const uchar *cur, const uchar *prev, int cols, int *sad)
+{
+    int col = 0;
+    for (; col + 32 <= cols; col += 32)
+    {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(cur + col));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(prev + col));
+        __m256i s = _mm256_sad_epu8(a, b);
+        sad[col >> 4] += _mm256_extract_epi32(s, 0) + _mm256_extract_epi32(s, 2);
+        sad[(col >> 4) + 1] += _mm256_extract_epi32(s, 4) + _mm256_extract_epi32(s, 6);
+    }
+    blockSADRow_SSE(cur + col, prev + col, cols - col, sad + (col >> 4));
+}
+
+// sad(by, bx) = sum of |cur - prev| over each 16x16 block (CV_32S, partial edge blocks included)
+inline void blockSAD_SIMD(const cv::Mat &cur, const cv::Mat &prev, cv::Mat &sad)
+{
+    if (cur.size() != prev.size() || cur.type() != CV_8U || prev.type() != CV_8U)
+    {
+        std::cerr << "Input matrices must have the same size and be of type CV_8U." << std::endl;
+        return;
+    }
+
+    int blockRows = (cur.rows + MOTION_BLOCK - 1) / MOTION_BLOCK;
+    int blockCols = (cur.cols + MOTION_BLOCK - 1) / MOTION_BLOCK;
+    sad.create(blockRows, blockCols, CV_32SC1);
+    static const bool useAVX2 = __builtin_cpu_supports("avx2");
+
+    cv::parallel_for_(cv::Range(0, blockRows), [&](const cv::Range &range)
+                      {
+        for (int by = range.start; by < range.end; ++by)
+        {
+            int *sadRow = sad.ptr<int>(by);
+            std::fill(sadRow, sadRow + blockCols, 0);
+            int rowEnd = std::min(cur.rows, (by + 1) * MOTION_BLOCK);
+            for (int row = by * MOTION_BLOCK; row < rowEnd; ++row)
+            {
+                if (useAVX2)
+                    blockSADRow_AVX2(cur.ptr<uchar>(row), prev.ptr<uchar>(row), cur.cols, sadRow);
+                else
+                    blockSADRow_SSE(cur.ptr<uchar>(row), prev.ptr<uchar>(row), cur.cols, sadRow);
+            }
+        } });
+}
+
+// Union-find with path halving; the smaller index becomes the root so labels are deterministic
+inline int findRoot(std::vector<int> &parent, int x)
+{
+    while (parent[x] != x)
+    {
+        parent[x] = parent[parent[x]];
+        x = parent[x];
+    }
+    return x;
+}
+
+inline void unite(std::vector<int> &parent, int a, int b)
+{
+    a = findRoot(parent, a);
+    b = findRoot(parent, b);
+    if (a < b)
+        parent[b] = a;
+    else if (b < a)
+        parent[a] = b;
+}
+
+// Pixels of block (by, bx): 16x16, less on the right and bottom edges of
+// frames whose size is not a multiple of 16
+inline int motionBlockArea(cv::Size frameSize, int by, int bx)
+{
+    int h = std::min(MOTION_BLOCK, frameSize.height - by * MOTION_BLOCK);
+    int w = std::min(MOTION_BLOCK, frameSize.width - bx * MOTION_BLOCK);
+    return std::max(0, h) * std::max(0, w);
+}
+
+// SAD above which a block moves: its mean difference exceeds pixelThreshold
+inline long motionBlockThreshold(double pixelThreshold, cv::Size frameSize, int by, int bx)
+{
+    return static_cast<long>(pixelThreshold * motionBlockArea(frameSize, by, bx));
+}
+
+// Threshold the block SADs (mean per-pixel difference > pixelThreshold) and
+// group 8-connected moving blocks into regions. Bands of block rows are
+// labelled in parallel, then the seams between bands are merged.
+inline MotionAnalysis analyzeMotionBlocks(const cv::Mat &sad, cv::Size frameSize, double pixelThreshold)
+{
+    MotionAnalysis result;
+    int rows = sad.rows, cols = sad.cols;
+
+    std::vector<int> parent(rows * cols);
+    std::vector<uchar> moving(rows * cols);
+    for (int by = 0; by < rows; ++by)
+        for (int bx = 0; bx < cols; ++bx)
+        {
+            int i = by * cols + bx;
+            parent[i] = i;
+            moving[i] = sad.at<int>(by, bx) > motionBlockThreshold(pixelThreshold, frameSize, by, bx);
+        }
+
+    auto linkUp = [&](int by, int bx)
+    {
+        // Neighbours in the previous row: up-left, up, up-right
+        int i = by * cols + bx;
+        for (int dx = -1; dx <= 1; ++dx)
+        {
+            int x = bx + dx;
+            if (x >= 0 && x < cols && moving[i - cols + dx])
+                unite(parent, i, i - cols + dx);
+        }
+    };
+
+    int bands = std::max(1, std::min(rows, cv::getNumThreads()));
+    std::vector<int> bandStart(bands + 1);
+    for (int b = 0; b <= bands; ++b)
+        bandStart[b] = rows * b / bands;
+
+    // Each band only touches its own blocks, so bands can be labelled concurrently
+    cv::parallel_for_(cv::Range(0, bands), [&](const cv::Range &range)
+                      {
+        for (int b = range.start; b < range.end; ++b)
+            for (int by = bandStart[b]; by < bandStart[b + 1]; ++by)
+                for (int bx = 0; bx < cols; ++bx)
+                {
+                    int i = by * cols + bx;
+                    if (!moving[i])
+                        continue;
+                    if (bx > 0 && moving[i - 1])
+                        unite(parent, i, i - 1);
+                    if (by > bandStart[b])
+                        linkUp(by, bx);
+                }
+        },
+                      bands);
+
+    // Seams: first row of every band against the last row of the band above
+    for (int b = 1; b < bands; ++b)
+    {
+        int by = bandStart[b];
+        for (int bx = 0; bx < cols && by < rows; ++bx)
+            if (moving[by * cols + bx])
+                linkUp(by, bx);
+    }
+
+    // One region per root
+    std::vector<int> regionOf(rows * cols, -1);
+    long totalSad = 0;
+    for (int by = 0; by < rows; ++by)
+        for (int bx = 0; bx < cols; ++bx)
+        {
+            int i = by * cols + bx;
+            totalSad += sad.at<int>(by, bx);
+            if (!moving[i])
+                continue;
+
+            int root = findRoot(parent, i);
+            if (regionOf[root] < 0)
+            {
+                regionOf[root] = static_cast<int>(result.regions.size());
+                result.regions.push_back(MotionRegion());
+                result.regions.back().box = cv::Rect(bx, by, 1, 1);
+            }
+            MotionRegion &region = result.regions[regionOf[root]];
+            cv::Rect &box = region.box; // in blocks until converted below
+            int x2 = std::max(box.x + box.width, bx + 1), y2 = std::max(box.y + box.height, by + 1);
+            box.x = std::min(box.x, bx);
+            box.y = std::min(box.y, by);
+            box.width = x2 - box.x;
+            box.height = y2 - box.y;
+            region.blocks++;
+            region.sad += sad.at<int>(by, bx);
+            result.movingBlocks++;
+        }
+
+    for (MotionRegion &region : result.regions)
+    {
+        cv::Rect &box = region.box;
+        box = cv::Rect(box.x * MOTION_BLOCK, box.y * MOTION_BLOCK, box.width * MOTION_BLOCK, box.height * MOTION_BLOCK) & cv::Rect(0, 0, frameSize.width, frameSize.height);
+    }
+
+    result.score = rows * cols > 0 ? (double)result.movingBlocks / (rows * cols) : 0.0;
+    result.meanAbsDiff = frameSize.area() > 0 ? (double)totalSad / frameSize.area() : 0.0;
+    return result;
+}
+
+inline MotionAnalysis analyzeMotion(const cv::Mat &cur, const cv::Mat &prev, double pixelThreshold, cv::Mat &sad)
+{
+    blockSAD_SIMD(cur, prev, sad);
+    return analyzeMotionBlocks(sad, cur.size(), pixelThreshold);
+}
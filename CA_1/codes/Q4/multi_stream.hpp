@@ -0,0 +1,239 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <sys/resource.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "motion_pipeline.hpp"
+#include "fused_motion.hpp"
+
+struct MultiStreamOptions
+{
+    int workers = 0;       // shared processing threads, 0 = all cores
+    int queueDepth = 4;    // decoded frames buffered per stream
+    bool realtime = false; // pace readers at the stream's fps and drop frames when the queue is full
+};
+
+struct StreamResult
+{
+    std::string name;
+    long processed = 0;
+    long dropped = 0;
+    long movingBlocks = 0;
+    double seconds = 0;
+};
+
+struct MultiStreamResult
+{
+    std::vector<StreamResult> streams;
+    double seconds = 0;
+    double cpuSeconds = 0; // user + system time of the process
+    int workers = 0;
+};
+
+// Per-stream state. Only one worker at a time owns a stream (`busy`), so its
+// frames are processed in order against the detector's previous luma.
+struct StreamState
+{
+    cv::VideoCapture cap;
+    std::vector<cv::Mat> slots;
+    MpmcQueue<int> freeSlots, ready;
+    FusedMotionDetector detector;
+    cv::Mat diff, blockMask;
+    std::atomic<bool> busy{false};
+    StreamResult result;
+
+    StreamState(const std::string &path, int depth) : cap(path), slots(depth), freeSlots(depth), ready(depth)
+    {
+        result.name = path;
+        for (int i = 0; i < depth; ++i)
+            freeSlots.push(i);
+    }
+};
+
+// Expand directories into the video files they contain
+inline std::vector<std::string> collectStreamInputs(const std::vector<std::string> &inputs)
+{
+    namespace fs = std::filesystem;
+    std::vector<std::string> paths;
+    for (const std::string &input : inputs)
+    {
+        if (fs::is_directory(input))
+        {
+            std::vector<std::string> files;
+            for (const auto &entry : fs::directory_iterator(input))
+            {
+                std::string ext = entry.path().extension().string();
+                if (entry.is_regular_file() && (ext == ".mp4" || ext == ".avi" || ext == ".mkv" || ext == ".mov"))
+                    files.push_back(entry.path().string());
+            }
+            std::sort(files.begin(), files.end());
+            paths.insert(paths.end(), files.begin(), files.end());
+        }
+        else
+            paths.push_back(input);
+    }
+    return paths;
+}
+
+inline double processCpuSeconds()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec * 1e-6 + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec * 1e-6;
+}
+
+// Motion detection over many streams at once: one reader thread per stream
+// decodes into that stream's bounded slot pool, and a single shared worker
+// pool serves the streams round-robin. A reader that gets ahead of the
+// workers either waits (files) or drops frames (realtime), so one busy stream
+// cannot starve the others or grow memory.
+inline MultiStreamResult runMultiStream(const std::vector<std::string> &paths, MultiStreamOptions opt = MultiStreamOptions())
+{
+    using clock = std::chrono::steady_clock;
+
+    MultiStreamResult result;
+    result.workers = opt.workers > 0 ? opt.workers : std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<std::unique_ptr<StreamState>> streams;
+    for (const std::string &path : paths)
+    {
+        streams.emplace_back(new StreamState(path, opt.queueDepth));
+        if (!streams.back()->cap.isOpened())
+        {
+            std::cerr << "Error opening video file " << path << std::endl;
+            streams.pop_back();
+        }
+    }
+    if (streams.empty())
+        return result;
+
+    // OpenCV's own threads would compete with the shared pool
+    int previousThreads = cv::getNumThreads();
+    cv::setNumThreads(1);
+
+    double cpuStart = processCpuSeconds();
+    auto start = clock::now();
+    std::atomic<int> streamsLeft(static_cast<int>(streams.size()));
+
+    std::vector<std::thread> readers;
+    for (auto &stream : streams)
+    {
+        StreamState *st = stream.get();
+        readers.emplace_back([st, &opt, &streamsLeft, start]
+                             {
+            double fps = st->cap.get(cv::CAP_PROP_FPS);
+            auto period = std::chrono::duration<double>(fps > 0 ? 1.0 / fps : 0.0);
+            cv::Mat scratch;
+            for (long n = 0;; ++n)
+            {
+                if (opt.realtime)
+                    std::this_thread::sleep_until(start + std::chrono::duration_cast<clock::duration>(period * n));
+
+                int s;
+                bool haveSlot = st->freeSlots.pop(s);
+                while (!haveSlot && !opt.realtime)
+                {
+                    std::this_thread::yield(); // back-pressure: wait for a worker to free a slot
+                    haveSlot = st->freeSlots.pop(s);
+                }
+
+                // A live source keeps producing; without a free slot the frame is lost
+                cv::Mat &target = haveSlot ? st->slots[s] : scratch;
+                if (!st->cap.read(target) || target.empty())
+                {
+                    if (haveSlot)
+                        st->freeSlots.pushWait(s);
+                    break;
+                }
+                if (haveSlot)
+                    st->ready.pushWait(s);
+                else
+                    st->result.dropped++;
+            }
+            streamsLeft.fetch_sub(1); });
+    }
+
+    auto worker = [&]
+    {
+        size_t cursor = 0;
+        for (;;)
+        {
+            bool didWork = false;
+            bool allDone = streamsLeft.load() == 0;
+
+            // One frame per stream per round keeps the streams fair
+            for (size_t k = 0; k < streams.size(); ++k)
+            {
+                StreamState &st = *streams[(cursor + k) % streams.size()];
+                if (st.busy.exchange(true, std::memory_order_acquire))
+                    continue;
+
+                int s;
+                if (st.ready.pop(s))
+                {
+                    if (st.detector.process(st.slots[s], st.diff, st.blockMask))
+                        for (int row = 0; row < st.blockMask.rows; ++row)
+                            for (int col = 0; col < st.blockMask.cols; ++col)
+                                st.result.movingBlocks += st.blockMask.at<uchar>(row, col) != 0;
+                    st.result.processed++;
+                    st.result.seconds = std::chrono::duration<double>(clock::now() - start).count();
+                    st.freeSlots.pushWait(s);
+                    didWork = true;
+                }
+                st.busy.store(false, std::memory_order_release);
+            }
+            cursor++;
+
+            // Exit once every reader has finished and a full round found nothing
+            if (!didWork)
+            {
+                if (allDone)
+                    break;
+                // Idle workers sleep briefly so spinning does not show up as CPU usage
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int i = 0; i < result.workers; ++i)
+        pool.emplace_back(worker);
+    for (auto &t : readers)
+        t.join();
+    for (auto &t : pool)
+        t.join();
+
+    result.seconds = std::chrono::duration<double>(clock::now() - start).count();
+    result.cpuSeconds = processCpuSeconds() - cpuStart;
+    for (auto &stream : streams)
+        result.streams.push_back(stream->result);
+
+    cv::setNumThreads(previousThreads);
+    return result;
+}
+
+inline void printMultiStreamResult(const MultiStreamResult &r)
+{
+    long processed = 0, dropped = 0;
+    for (const StreamResult &s : r.streams)
+    {
+        processed += s.processed;
+        dropped += s.dropped;
+    }
+
+    int cores = std::max(1u, std::thread::hardware_concurrency());
+    printf("\n%zu streams, %d workers: %ld frames in %f seconds = %f fps aggregate, %ld dropped\n",
+           r.streams.size(), r.workers, processed, r.seconds, r.seconds > 0 ? processed / r.seconds : 0.0, dropped);
+    printf("\tCPU usage = %.1f%% of %d cores (%.2f cores busy)\n",
+           r.seconds > 0 ? 100.0 * r.cpuSeconds / (r.seconds * cores) : 0.0, cores, r.seconds > 0 ? r.cpuSeconds / r.seconds : 0.0);
+    for (const StreamResult &s : r.streams)
+        printf("\t%s: %ld frames, %.2f fps, %ld dropped, %ld moving blocks\n",
+               s.name.c_str(), s.processed, s.seconds > 0 ? s.processed / s.seconds : 0.0, s.dropped, s.movingBlocks);
+}
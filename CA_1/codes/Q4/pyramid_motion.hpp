@@ -0,0 +1,327 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <tmmintrin.h>
+#include <iostream>
+#include <vector>
+#include "motion_regions.hpp"
+#include "../../../common/perf_counters.hpp"
+
+// Coarse-to-fine motion detection for high-resolution streams.
+//
+// Each gray frame gets a pyramid of 2x2 averages (level 1 = half size, level 2
+// = quarter size; the detector only keeps the top level and builds a 3-level
+// one in one pass). Frames are differenced at the top level first,
+// in tiles of 8x8 coarse pixels; only tiles whose mean difference passes a
+// lowered threshold, plus a one-block halo around them, are compared again at
+// full resolution as 16x16 blocks. The result is the same block SAD matrix as
+// blockSAD_SIMD, exact on every refined block, so analyzeMotionBlocks turns it
+// into regions unchanged.
+//
+// Averaging can only shrink a difference (|mean a - mean b| <= mean |a - b|),
+// so the coarse threshold is scaled down by the blocks a tile covers and by
+// coarseScale. Static scenes then cost one pass over the new frame (its
+// coarse level; the previous frame's is kept from the last call when the
+// caller numbers its frames) instead of a pass over both frames.
+
+const int PYRAMID_TILE = 8; // coarse pixels per tile side
+
+// dst[x] = rounded mean of the 2x2 block at (2x, 2x + 1) of rows r0 and r1; an
+// odd last column is paired with itself (r1 == r0 for an odd last row)
+inline void pyrDownRow_Serial(const uchar *r0, const uchar *r1, uchar *dst, int srcCols)
+{
+    int dstCols = (srcCols + 1) / 2;
+    for (int x = 0; x < dstCols; ++x)
+    {
+        int a = 2 * x, b = std::min(2 * x + 1, srcCols - 1);
+        dst[x] = static_cast<uchar>((r0[a] + r0[b] + r1[a] + r1[b] + 2) >> 2);
+    }
+}
+
+// 16 outputs per step: pmaddubsw with ones adds horizontal pairs, then the two rows
+__attribute__((target("ssse3"))) inline void pyrDownRow_SSE(const uchar *r0, const uchar *r1, uchar *dst, int srcCols)
+{
+    const __m128i ones = _mm_set1_epi8(1), two = _mm_set1_epi16(2);
+    int x = 0;
+    for (; 2 * (x + 16) <= srcCols; x += 16)
+    {
+        const uchar *a = r0 + 2 * x, *b = r1 + 2 * x;
+        __m128i lo = _mm_add_epi16(_mm_maddubs_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a)), ones),
+                                   _mm_maddubs_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(b)), ones));
+        __m128i hi = _mm_add_epi16(_mm_maddubs_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + 16)), ones),
+                                   _mm_maddubs_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(b + 16)), ones));
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, two), 2);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, two), 2);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x), _mm_packus_epi16(lo, hi));
+    }
+    pyrDownRow_Serial(r0 + 2 * x, r1 + 2 * x, dst + x, srcCols - 2 * x);
+}
+
+// Half-size image of 2x2 means, rounded up for odd sizes
+inline void pyrDown2x2_SIMD(const cv::Mat &src, cv::Mat &dst)
+{
+    if (src.type() != CV_8U || src.empty())
+    {
+        std::cerr << "Input matrix must be a non-empty CV_8U image." << std::endl;
+        return;
+    }
+    dst.create((src.rows + 1) / 2, (src.cols + 1) / 2, CV_8U);
+    cv::parallel_for_(cv::Range(0, dst.rows), [&](const cv::Range &range)
+                      {
+        for (int y = range.start; y < range.end; ++y)
+            pyrDownRow_SSE(src.ptr<uchar>(2 * y), src.ptr<uchar>(std::min(2 * y + 1, src.rows - 1)), dst.ptr<uchar>(y), src.cols); });
+}
+
+// Quarter-size row from source rows r[0..3]: the rows are averaged in pairs and
+// the pairs again, rounding up each time like pavgb, then 4 columns are
+// averaged; columns past the end repeat the last one. Within 1 of the exact
+// 4x4 mean, and the same bias lands on both frames being compared.
+inline uchar pavg(int a, int b) { return static_cast<uchar>((a + b + 1) >> 1); }
+
+inline void pyrDown4x4Row_Serial(const uchar *const *r, uchar *dst, int srcCols)
+{
+    int dstCols = (srcCols + 3) / 4;
+    for (int x = 0; x < dstCols; ++x)
+    {
+        int sum = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            int col = std::min(4 * x + i, srcCols - 1);
+            sum += pavg(pavg(r[0][col], r[1][col]), pavg(r[2][col], r[3][col]));
+        }
+        dst[x] = static_cast<uchar>((sum + 2) >> 2);
+    }
+}
+
+// Four int32 sums of 4 columns of the four rows' pavgb mean, from 16 columns at
+// offset (a function rather than a lambda: lambdas do not inherit the target)
+__attribute__((target("ssse3"))) inline __m128i pyrDown4x4Sums_SSE(const uchar *const *r, int offset)
+{
+    __m128i a = _mm_avg_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(r[0] + offset)), _mm_loadu_si128(reinterpret_cast<const __m128i *>(r[1] + offset)));
+    __m128i b = _mm_avg_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(r[2] + offset)), _mm_loadu_si128(reinterpret_cast<const __m128i *>(r[3] + offset)));
+    return _mm_madd_epi16(_mm_maddubs_epi16(_mm_avg_epu8(a, b), _mm_set1_epi8(1)), _mm_set1_epi16(1));
+}
+
+// 8 outputs per step: three pavgb per 16 columns, then pmaddubsw and pmaddwd
+// add the columns in fours
+__attribute__((target("ssse3"))) inline void pyrDown4x4Row_SSE(const uchar *const *r, uchar *dst, int srcCols)
+{
+    const __m128i two = _mm_set1_epi16(2);
+    int x = 0;
+    for (; 4 * (x + 8) <= srcCols; x += 8)
+    {
+        __m128i sums = _mm_packs_epi32(pyrDown4x4Sums_SSE(r, 4 * x), pyrDown4x4Sums_SSE(r, 4 * x + 16));
+        sums = _mm_srli_epi16(_mm_add_epi16(sums, two), 2);
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + x), _mm_packus_epi16(sums, sums));
+    }
+    const uchar *tail[4] = {r[0] + 4 * x, r[1] + 4 * x, r[2] + 4 * x, r[3] + 4 * x};
+    pyrDown4x4Row_Serial(tail, dst + x, srcCols - 4 * x);
+}
+
+// Quarter-size image (the top of a 3-level pyramid) in one pass over the
+// frame, rounded up for sizes that are not multiples of 4
+inline void pyrDown4x4_SIMD(const cv::Mat &src, cv::Mat &dst)
+{
+    if (src.type() != CV_8U || src.empty())
+    {
+        std::cerr << "Input matrix must be a non-empty CV_8U image." << std::endl;
+        return;
+    }
+    dst.create((src.rows + 3) / 4, (src.cols + 3) / 4, CV_8U);
+    cv::parallel_for_(cv::Range(0, dst.rows), [&](const cv::Range &range)
+                      {
+        for (int y = range.start; y < range.end; ++y)
+        {
+            const uchar *rows[4];
+            for (int k = 0; k < 4; ++k)
+                rows[k] = src.ptr<uchar>(std::min(4 * y + k, src.rows - 1));
+            pyrDown4x4Row_SSE(rows, dst.ptr<uchar>(y), src.cols);
+        } });
+}
+
+// SAD of 8-byte groups, accumulated into sad[col / 8] (psadbw's two halves)
+inline void tileSADRow_SSE(const uchar *cur, const uchar *prev, int cols, int *sad)
+{
+    int col = 0;
+    for (; col + 16 <= cols; col += 16)
+    {
+        __m128i s = _mm_sad_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(cur + col)),
+                                 _mm_loadu_si128(reinterpret_cast<const __m128i *>(prev + col)));
+        sad[col >> 3] += _mm_cvtsi128_si32(s);
+        sad[(col >> 3) + 1] += _mm_extract_epi16(s, 4);
+    }
+    for (; col < cols; ++col)
+        sad[col >> 3] += std::abs(cur[col] - prev[col]);
+}
+
+struct PyramidMotionOptions
+{
+    int levels = 3;            // including full resolution: 2 (half) or 3 (quarter)
+    double coarseScale = 0.25; // extra margin on the lowered coarse threshold
+};
+
+struct PyramidMotionStats
+{
+    long tiles = 0, candidateTiles = 0; // coarse tiles / past the coarse threshold
+    long blocks = 0, refinedBlocks = 0; // 16x16 blocks / compared at full resolution
+    double pixelsRead = 0;              // pyramid build, coarse and refined differences
+    double fullPixelsRead = 0;          // what blockSAD_SIMD reads: both whole frames
+
+    double refinedFraction() const { return blocks ? (double)refinedBlocks / blocks : 0; }
+    double workFraction() const { return fullPixelsRead > 0 ? pixelsRead / fullPixelsRead : 0; }
+};
+
+class PyramidMotionDetector
+{
+public:
+    explicit PyramidMotionDetector(PyramidMotionOptions options = PyramidMotionOptions()) : opt(options)
+    {
+        opt.levels = std::min(3, std::max(2, opt.levels));
+    }
+
+    // cur and prev are consecutive CV_8U frames; `frame` is cur's position in
+    // the stream. The pyramid of prev is reused only when the caller numbers
+    // its frames and `frame` follows the previous call's (prev is then the
+    // frame passed as cur last time); with frame < 0 both are rebuilt. `sad`
+    // is blockSAD_SIMD's matrix: exact on refined blocks, a coarse estimate
+    // below the threshold elsewhere.
+    MotionAnalysis detect(const cv::Mat &cur, const cv::Mat &prev, double pixelThreshold, cv::Mat &sad, long frame = -1)
+    {
+        if (cur.size() != prev.size() || cur.type() != CV_8U || prev.type() != CV_8U)
+        {
+            std::cerr << "Input matrices must have the same size and be of type CV_8U." << std::endl;
+            return MotionAnalysis();
+        }
+        PyramidMotionStats frameStats;
+        frameStats.fullPixelsRead = 2.0 * cur.total();
+
+        int top = opt.levels - 1;
+        bool reuse = frame > 0 && frame == lastFrame + 1 && prev.size() == lastSize && !coarse[current].empty();
+        current = 1 - current; // this frame's level goes where the frame before last's was
+        buildCoarse(cur, coarse[current]);
+        frameStats.pixelsRead += cur.total();
+        if (!reuse)
+        {
+            buildCoarse(prev, coarse[1 - current]);
+            frameStats.pixelsRead += prev.total();
+        }
+        lastFrame = frame;
+        lastSize = cur.size();
+        const cv::Mat &coarseCur = coarse[current], &coarsePrev = coarse[1 - current];
+
+        // Coarse tile SADs
+        int tileRows = (coarseCur.rows + PYRAMID_TILE - 1) / PYRAMID_TILE, tileCols = (coarseCur.cols + PYRAMID_TILE - 1) / PYRAMID_TILE;
+        tileSad.create(tileRows, tileCols, CV_32SC1);
+        cv::parallel_for_(cv::Range(0, tileRows), [&](const cv::Range &range)
+                          {
+            for (int ty = range.start; ty < range.end; ++ty)
+            {
+                int *row = tileSad.ptr<int>(ty);
+                std::fill(row, row + tileCols, 0);
+                int rowEnd = std::min(coarseCur.rows, (ty + 1) * PYRAMID_TILE);
+                for (int y = ty * PYRAMID_TILE; y < rowEnd; ++y)
+                    tileSADRow_SSE(coarseCur.ptr<uchar>(y), coarsePrev.ptr<uchar>(y), coarseCur.cols, row);
+            } });
+        frameStats.pixelsRead += 2.0 * coarseCur.total();
+
+        // Full-resolution blocks under the candidate tiles, then a one-block halo
+        int blockRows = (cur.rows + MOTION_BLOCK - 1) / MOTION_BLOCK, blockCols = (cur.cols + MOTION_BLOCK - 1) / MOTION_BLOCK;
+        int tileSide = (PYRAMID_TILE << top) / MOTION_BLOCK; // blocks per tile side
+        double coarseThreshold = pixelThreshold * opt.coarseScale / (tileSide * tileSide);
+        candidate.assign((size_t)blockRows * blockCols, 0);
+        tileEstimate.resize((size_t)tileRows * tileCols);
+        for (int ty = 0; ty < tileRows; ++ty)
+            for (int tx = 0; tx < tileCols; ++tx)
+            {
+                int h = std::min(PYRAMID_TILE, coarseCur.rows - ty * PYRAMID_TILE), w = std::min(PYRAMID_TILE, coarseCur.cols - tx * PYRAMID_TILE);
+                double meanDiff = (double)tileSad.at<int>(ty, tx) / (w * h);
+                tileEstimate[(size_t)ty * tileCols + tx] = static_cast<int>(meanDiff * MOTION_BLOCK * MOTION_BLOCK);
+                if (meanDiff <= coarseThreshold)
+                    continue;
+                frameStats.candidateTiles++;
+                for (int by = ty * tileSide; by < std::min(blockRows, (ty + 1) * tileSide); ++by)
+                    for (int bx = tx * tileSide; bx < std::min(blockCols, (tx + 1) * tileSide); ++bx)
+                        candidate[(size_t)by * blockCols + bx] = 1;
+            }
+        refine.assign(candidate.size(), 0);
+        for (int by = 0; by < blockRows; ++by)
+            for (int bx = 0; bx < blockCols; ++bx)
+                if (candidate[(size_t)by * blockCols + bx])
+                    for (int y = std::max(0, by - 1); y <= std::min(blockRows - 1, by + 1); ++y)
+                        for (int x = std::max(0, bx - 1); x <= std::min(blockCols - 1, bx + 1); ++x)
+                            refine[(size_t)y * blockCols + x] = 1;
+
+        // Exact SADs of refined blocks, one call per run of them along a block row;
+        // the others get the coarse tile's mean difference
+        sad.create(blockRows, blockCols, CV_32SC1);
+        static const bool useAVX2 = __builtin_cpu_supports("avx2");
+        std::vector<long> refinedPerRow(blockRows, 0);
+        cv::parallel_for_(cv::Range(0, blockRows), [&](const cv::Range &range)
+                          {
+            for (int by = range.start; by < range.end; ++by)
+            {
+                int *sadRow = sad.ptr<int>(by);
+                const uchar *mark = &refine[(size_t)by * blockCols];
+                const int *estimate = &tileEstimate[(size_t)(by / tileSide) * tileCols];
+                int rowEnd = std::min(cur.rows, (by + 1) * MOTION_BLOCK);
+                // Estimates are per full block; edge blocks cover fewer pixels
+                for (int bx = 0; bx < blockCols; ++bx)
+                    sadRow[bx] = mark[bx] ? 0 : (int)((long)estimate[bx / tileSide] * motionBlockArea(cur.size(), by, bx) / (MOTION_BLOCK * MOTION_BLOCK));
+                for (int bx = 0; bx < blockCols;)
+                {
+                    if (!mark[bx])
+                    {
+                        ++bx;
+                        continue;
+                    }
+                    int end = bx;
+                    while (end < blockCols && mark[end])
+                        ++end;
+                    int col = bx * MOTION_BLOCK, cols = std::min(cur.cols, end * MOTION_BLOCK) - col;
+                    for (int row = by * MOTION_BLOCK; row < rowEnd; ++row)
+                    {
+                        if (useAVX2)
+                            blockSADRow_AVX2(cur.ptr<uchar>(row) + col, prev.ptr<uchar>(row) + col, cols, sadRow + bx);
+                        else
+                            blockSADRow_SSE(cur.ptr<uchar>(row) + col, prev.ptr<uchar>(row) + col, cols, sadRow + bx);
+                    }
+                    refinedPerRow[by] += end - bx;
+                    bx = end;
+                }
+            } });
+
+        frameStats.tiles = (long)tileRows * tileCols;
+        frameStats.blocks = (long)blockRows * blockCols;
+        for (long n : refinedPerRow)
+            frameStats.refinedBlocks += n;
+        frameStats.pixelsRead += 2.0 * frameStats.refinedBlocks * MOTION_BLOCK * MOTION_BLOCK;
+        PERF_REGION("PyramidMotionDetector", frameStats.pixelsRead, frameStats.pixelsRead);
+        lastStats = frameStats;
+        return analyzeMotionBlocks(sad, cur.size(), pixelThreshold);
+    }
+
+    // Forget the kept pyramid, e.g. after a seek
+    void reset() { lastFrame = -1; }
+
+    const PyramidMotionStats &stats() const { return lastStats; }
+
+private:
+    // Top level of the pyramid; the detector never looks at the ones in between
+    void buildCoarse(const cv::Mat &frame, cv::Mat &level) const
+    {
+        if (opt.levels == 3)
+            pyrDown4x4_SIMD(frame, level);
+        else
+            pyrDown2x2_SIMD(frame, level);
+    }
+
+    PyramidMotionOptions opt;
+    cv::Mat coarse[2]; // top pyramid level of the last two frames
+    int current = 0;
+    long lastFrame = -1; // stream position of the kept pyramid
+    cv::Size lastSize;
+    cv::Mat tileSad;
+    std::vector<int> tileEstimate; // block SAD implied by each tile's mean difference
+    std::vector<uchar> candidate, refine;
+    PyramidMotionStats lastStats;
+};
@@ -5,74 +5,345 @@
 #include <emmintrin.h>
 #include <x86intrin.h>
 #include <chrono>
+#include <string>
+#include "abs_diff.hpp"
+#include "motion_pipeline.hpp"
+#include "fused_motion.hpp"
+#include "motion_regions.hpp"
+#include "multi_stream.hpp"
+#include "background_model.hpp"
+#include "pyramid_motion.hpp"
+#include "../image_resampler.hpp"
+
+// Headless pipelined mode: decoder thread -> SIMD worker pool -> encoder thread
+int runPipelineMode(const std::string &path, int workers, const std::string &outputPath)
+{
+    cv::VideoCapture cap(path);
+    if (!cap.isOpened())
+    {
+        std::cerr << "Error opening video file" << std::endl;
+        return -1;
+    }
+
+    int fourcc = cv::VideoWriter::fourcc('a', 'v', 'c', '1');
+    cv::VideoWriter writer;
+    if (!outputPath.empty())
+        writer.open(outputPath, fourcc, cap.get(cv::CAP_PROP_FPS), cv::Size(640, 480), false);
+
+    MotionStages stages;
+    stages.toGray = [](const cv::Mat &frame, cv::Mat &gray)
+    { cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY); };
+    stages.detect = [](const cv::Mat &gray, const cv::Mat &prevGray, cv::Mat &motion)
+    {
+        // Full-size diff buffer per worker thread; resample into the slot's reused output buffer
+        thread_local cv::Mat diff;
+        thread_local ImageResampler resampler(RESAMPLE_BILINEAR);
+        absDiff_SIMD(gray, prevGray, diff);
+        resampler.apply(diff, motion, cv::Size(640, 480));
+    };
+
+    MotionPipelineOptions options;
+    options.workers = workers;
+    StreamStats stats = runMotionPipeline(cap, outputPath.empty() ? nullptr : &writer, stages, options);
+    printStreamStats("Stream 0", stats);
+    return 0;
+}
+
+// Headless comparison of the per-frame work: cvtColor + absDiff_SIMD + copyTo
+// versus the fused single-pass kernel (decode time excluded from both)
+int runFusedMode(const std::string &path, int threshold)
+{
+    cv::VideoCapture cap(path);
+    if (!cap.isOpened())
+    {
+        std::cerr << "Error opening video file" << std::endl;
+        return -1;
+    }
+
+    cv::Mat frame, grayFrame, prevGrayFrame, motionFrame, blockMask;
+    FusedMotionDetector detector(static_cast<uchar>(threshold));
+    std::chrono::duration<double> durationSeparate(0), durationFused(0);
+    long frames = 0, movingBlocks = 0;
+
+    while (cap.read(frame) && !frame.empty())
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        cv::cvtColor(frame, grayFrame, cv::COLOR_BGR2GRAY);
+        if (!prevGrayFrame.empty())
+            absDiff_SIMD(grayFrame, prevGrayFrame, motionFrame);
+        grayFrame.copyTo(prevGrayFrame);
+        auto mid = std::chrono::high_resolution_clock::now();
+        bool detected = detector.process(frame, motionFrame, blockMask);
+        auto end = std::chrono::high_resolution_clock::now();
+
+        durationSeparate += mid - start;
+        durationFused += end - mid;
+        ++frames;
+        if (detected)
+            for (int row = 0; row < blockMask.rows; ++row)
+                for (int col = 0; col < blockMask.cols; ++col)
+                    movingBlocks += blockMask.at<uchar>(row, col) != 0;
+    }
+
+    std::cout << "Frames: " << frames << ", moving 16x16 blocks: " << movingBlocks << std::endl;
+    std::cout << "Time for cvtColor + absDiff_SIMD + copy: " << durationSeparate.count() << " seconds" << std::endl;
+    std::cout << "Time for fused kernel: " << durationFused.count() << " seconds" << std::endl;
+    std::cout << "Speedup (separate / fused): " << durationSeparate.count() / durationFused.count() << "x" << std::endl;
+    return 0;
+}
 
-// SSE-based absolute difference
-void absDiff_SIMD(const cv::Mat &src1, const cv::Mat &src2, cv::Mat &dst)
+// Per-block motion statistics and connected motion regions for every frame
+int runRegionsMode(const std::string &path, double pixelThreshold)
 {
-    if (src1.size() != src2.size() || src1.type() != CV_8U || src2.type() != CV_8U)
+    cv::VideoCapture cap(path);
+    if (!cap.isOpened())
     {
-        std::cerr << "Input matrices must have the same size and be of type CV_8U." << std::endl;
-        return;
+        std::cerr << "Error opening video file" << std::endl;
+        return -1;
     }
-    dst.create(src1.rows, src1.cols, CV_8U);
 
-    for (int row = 0; row < src1.rows; ++row)
+    cv::Mat frame, grayFrame, prevGrayFrame, sad;
+    std::chrono::duration<double> durationAnalysis(0);
+    long frames = 0;
+
+    while (cap.read(frame) && !frame.empty())
     {
-        const uchar *ptrSrc1 = src1.ptr<uchar>(row);
-        const uchar *ptrSrc2 = src2.ptr<uchar>(row);
-        uchar *ptrDst = dst.ptr<uchar>(row);
+        cv::cvtColor(frame, grayFrame, cv::COLOR_BGR2GRAY);
+        if (!prevGrayFrame.empty())
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            MotionAnalysis motion = analyzeMotion(grayFrame, prevGrayFrame, pixelThreshold, sad);
+            durationAnalysis += std::chrono::high_resolution_clock::now() - start;
+
+            printf("frame %ld: score = %.3f, mean |diff| = %.2f, %zu regions", frames, motion.score, motion.meanAbsDiff, motion.regions.size());
+            for (const MotionRegion &region : motion.regions)
+                printf(" [%d,%d %dx%d]", region.box.x, region.box.y, region.box.width, region.box.height);
+            printf("\n");
+        }
+        // Swap instead of copying; cvtColor reallocates nothing once sizes match
+        std::swap(grayFrame, prevGrayFrame);
+        ++frames;
+    }
+
+    std::cout << "Time for block SAD + region labelling: " << durationAnalysis.count() << " seconds ("
+              << durationAnalysis.count() / std::max(1L, frames - 1) * 1e3 << " ms/frame)" << std::endl;
+    return 0;
+}
+
+// Coarse-to-fine detection against the full-resolution block SAD (and the plain
+// absDiff_SIMD pass): time per frame, pixels read and blocks the pyramid missed
+int runPyramidMode(const std::string &path, double pixelThreshold, int levels)
+{
+    cv::VideoCapture cap(path);
+    if (!cap.isOpened())
+    {
+        std::cerr << "Error opening video file" << std::endl;
+        return -1;
+    }
 
-        for (int col = 0; col < src1.cols; col += 16)
+    cv::Mat frame, grayFrame, prevGrayFrame, motionFrame, sadFull, sadPyramid;
+    PyramidMotionOptions options;
+    options.levels = levels;
+    PyramidMotionDetector detector(options);
+    std::chrono::duration<double> durationDiff(0), durationFull(0), durationPyramid(0);
+    long frames = 0, pairs = 0, movingBlocks = 0, missedBlocks = 0;
+    double refined = 0, work = 0;
+
+    while (cap.read(frame) && !frame.empty())
+    {
+        cv::cvtColor(frame, grayFrame, cv::COLOR_BGR2GRAY);
+        if (!prevGrayFrame.empty())
         {
-            __m128i xmm1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ptrSrc1));
-            __m128i xmm2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ptrSrc2));
-            __m128i xmmDiff = _mm_sub_epi8(xmm1, xmm2);
-            xmmDiff = _mm_abs_epi8(xmmDiff);
-            _mm_storeu_si128(reinterpret_cast<__m128i *>(ptrDst), xmmDiff);
-
-            ptrSrc1 += 16;
-            ptrSrc2 += 16;
-            ptrDst += 16;
+            // Alternate which detector runs first, so neither always finds the frames in cache
+            auto runFull = [&]
+            {
+                auto start = std::chrono::high_resolution_clock::now();
+                analyzeMotion(grayFrame, prevGrayFrame, pixelThreshold, sadFull);
+                durationFull += std::chrono::high_resolution_clock::now() - start;
+            };
+            auto runPyramid = [&]
+            {
+                auto start = std::chrono::high_resolution_clock::now();
+                detector.detect(grayFrame, prevGrayFrame, pixelThreshold, sadPyramid, frames);
+                durationPyramid += std::chrono::high_resolution_clock::now() - start;
+            };
+            if (pairs % 2)
+                runFull(), runPyramid();
+            else
+                runPyramid(), runFull();
+
+            auto start = std::chrono::high_resolution_clock::now();
+            absDiff_SIMD(grayFrame, prevGrayFrame, motionFrame);
+            durationDiff += std::chrono::high_resolution_clock::now() - start;
+
+            for (int by = 0; by < sadFull.rows; ++by)
+                for (int bx = 0; bx < sadFull.cols; ++bx)
+                {
+                    long blockThreshold = motionBlockThreshold(pixelThreshold, grayFrame.size(), by, bx);
+                    bool moving = sadFull.at<int>(by, bx) > blockThreshold;
+                    movingBlocks += moving;
+                    missedBlocks += moving && sadPyramid.at<int>(by, bx) <= blockThreshold;
+                }
+            refined += detector.stats().refinedFraction();
+            work += detector.stats().workFraction();
+            ++pairs;
         }
+        // Swap instead of copying; the frame number tells the detector prev is the last cur
+        std::swap(grayFrame, prevGrayFrame);
+        ++frames;
     }
+
+    pairs = std::max(1L, pairs);
+    std::cout << "Frames: " << frames << ", moving 16x16 blocks: " << movingBlocks << ", missed by the pyramid: " << missedBlocks << std::endl;
+    std::cout << "Blocks refined at full resolution: " << 100.0 * refined / pairs << "%, pixels read: "
+              << 100.0 * work / pairs << "% of the full block SAD" << std::endl;
+    std::cout << "Time for absDiff_SIMD: " << durationDiff.count() / pairs * 1e3 << " ms/frame" << std::endl;
+    std::cout << "Time for full block SAD + regions: " << durationFull.count() / pairs * 1e3 << " ms/frame" << std::endl;
+    std::cout << "Time for pyramid (" << levels << " levels) + regions: " << durationPyramid.count() / pairs * 1e3 << " ms/frame" << std::endl;
+    std::cout << "Speedup (full / pyramid): " << durationFull.count() / durationPyramid.count() << "x" << std::endl;
+    return 0;
 }
 
-// Serial absolute difference for comparison
-void absDiff_Serial(const cv::Mat &src1, const cv::Mat &src2, cv::Mat &dst)
+// Background subtraction against an adaptive model, compared with plain frame differencing
+int runBackgroundMode(const std::string &path, bool gaussian, const std::string &outputPath)
 {
-    if (src1.size() != src2.size() || src1.type() != CV_8U || src2.type() != CV_8U)
+    cv::VideoCapture cap(path);
+    if (!cap.isOpened())
     {
-        std::cerr << "Input matrices must have the same size and be of type CV_8U." << std::endl;
-        return;
+        std::cerr << "Error opening video file" << std::endl;
+        return -1;
     }
-    dst.create(src1.rows, src1.cols, CV_8U);
 
-    for (int row = 0; row < src1.rows; ++row)
+    cv::VideoWriter writer;
+    if (!outputPath.empty())
     {
-        const uchar *ptrSrc1 = src1.ptr<uchar>(row);
-        const uchar *ptrSrc2 = src2.ptr<uchar>(row);
-        uchar *ptrDst = dst.ptr<uchar>(row);
+        cv::Size frameSize(cap.get(cv::CAP_PROP_FRAME_WIDTH), cap.get(cv::CAP_PROP_FRAME_HEIGHT));
+        writer.open(outputPath, cv::VideoWriter::fourcc('a', 'v', 'c', '1'), cap.get(cv::CAP_PROP_FPS), frameSize, false);
+    }
+
+    BackgroundParams params;
+    params.mode = gaussian ? BG_GAUSSIAN : BG_RUNNING_AVERAGE;
+    BackgroundModel model(params);
+
+    cv::Mat frame, grayFrame, prevGrayFrame, foreground, motionFrame;
+    std::chrono::duration<double> durationModel(0), durationDiff(0);
+    long frames = 0;
 
-        for (int col = 0; col < src1.cols; ++col)
+    while (cap.read(frame) && !frame.empty())
+    {
+        cv::cvtColor(frame, grayFrame, cv::COLOR_BGR2GRAY);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        model.apply(grayFrame, foreground);
+        durationModel += std::chrono::high_resolution_clock::now() - start;
+
+        long changed = 0, moving = 0;
+        if (!prevGrayFrame.empty())
         {
-            uchar pixel1 = ptrSrc1[col];
-            uchar pixel2 = ptrSrc2[col];
-            ptrDst[col] = std::abs(static_cast<int>(pixel1) - static_cast<int>(pixel2));
+            start = std::chrono::high_resolution_clock::now();
+            absDiff_Serial(grayFrame, prevGrayFrame, motionFrame);
+            durationDiff += std::chrono::high_resolution_clock::now() - start;
+
+            for (int row = 0; row < grayFrame.rows; ++row)
+                for (int col = 0; col < grayFrame.cols; ++col)
+                {
+                    changed += motionFrame.at<uchar>(row, col) > 25;
+                    moving += foreground.at<uchar>(row, col) != 0;
+                }
+            printf("frame %ld: foreground = %.2f%%, frame difference > 25 = %.2f%%\n", frames,
+                   100.0 * moving / grayFrame.total(), 100.0 * changed / grayFrame.total());
         }
+        if (writer.isOpened())
+            writer.write(foreground);
+
+        std::swap(grayFrame, prevGrayFrame);
+        ++frames;
     }
+
+    std::cout << "Time for background model (" << (gaussian ? "Gaussian" : "running average") << "): "
+              << durationModel.count() << " seconds (" << durationModel.count() / std::max(1L, frames) * 1e3 << " ms/frame)" << std::endl;
+    std::cout << "Time for frame differencing (serial): " << durationDiff.count() << " seconds" << std::endl;
+    return 0;
 }
 
-int main()
+int main(int argc, char **argv)
 {
+    std::string videoPath = "/home/atefeh/PP/PP-CA1-Fall03/assets/Q4/Q4.mp4";
+
+    // Pipelined mode: q4 --pipeline [video] [workers] [output.mp4]
+    if (argc >= 2 && std::string(argv[1]) == "--pipeline")
+    {
+        return runPipelineMode(argc > 2 ? argv[2] : videoPath, argc > 3 ? atoi(argv[3]) : 0, argc > 4 ? argv[4] : "");
+    }
+
+    // Fused kernel benchmark: q4 --fused [video] [threshold]
+    if (argc >= 2 && std::string(argv[1]) == "--fused")
+    {
+        return runFusedMode(argc > 2 ? argv[2] : videoPath, argc > 3 ? atoi(argv[3]) : 25);
+    }
+
+    // Motion regions: q4 --regions [video] [mean pixel difference threshold]
+    if (argc >= 2 && std::string(argv[1]) == "--regions")
+    {
+        return runRegionsMode(argc > 2 ? argv[2] : videoPath, argc > 3 ? atof(argv[3]) : 10.0);
+    }
+
+    // Coarse-to-fine detection: q4 --pyramid [video] [mean pixel difference threshold] [levels 2|3]
+    if (argc >= 2 && std::string(argv[1]) == "--pyramid")
+    {
+        return runPyramidMode(argc > 2 ? argv[2] : videoPath, argc > 3 ? atof(argv[3]) : 10.0, argc > 4 ? atoi(argv[4]) : 3);
+    }
+
+    // Background subtraction: q4 --background [video] [gaussian] [output.mp4]
+    if (argc >= 2 && std::string(argv[1]) == "--background")
+    {
+        return runBackgroundMode(argc > 2 ? argv[2] : videoPath, argc > 3 && std::string(argv[3]) == "gaussian", argc > 4 ? argv[4] : "");
+    }
+
+    // Multi-stream mode: q4 --streams <workers|0 = sweep 1..cores> [--realtime] <video or directory>...
+    if (argc >= 4 && std::string(argv[1]) == "--streams")
+    {
+        MultiStreamOptions options;
+        std::vector<std::string> inputs;
+        for (int i = 3; i < argc; ++i)
+        {
+            if (std::string(argv[i]) == "--realtime")
+                options.realtime = true;
+            else
+                inputs.push_back(argv[i]);
+        }
+        std::vector<std::string> paths = collectStreamInputs(inputs);
+
+        // Worker counts to run: the given one, or 1, 2, 4, ... up to all cores
+        std::vector<int> workerCounts;
+        int cores = std::max(1u, std::thread::hardware_concurrency());
+        if (atoi(argv[2]) > 0)
+            workerCounts.push_back(atoi(argv[2]));
+        else
+        {
+            for (int w = 1; w < cores; w *= 2)
+                workerCounts.push_back(w);
+            workerCounts.push_back(cores);
+        }
+
+        for (int w : workerCounts)
+        {
+            options.workers = w;
+            printMultiStreamResult(runMultiStream(paths, options));
+        }
+        return 0;
+    }
+
     // Open video file
-    cv::VideoCapture cap("/home/atefeh/PP/PP-CA1-Fall03/assets/Q4/Q4.mp4");
+    cv::VideoCapture cap(videoPath);
     if (!cap.isOpened())
     {
         std::cerr << "Error opening video file" << std::endl;
         return -1;
     }
 
-    cv::Mat frame, grayFrame, prevGrayFrame, motionFrame;
+    cv::Mat frame, grayFrame, prevGrayFrame, motionFrame, displayFrame;
+    ImageResampler resampler(RESAMPLE_BILINEAR);
     bool isFirstFrame = true;
 
     // Create VideoWriter object to save the processed video
@@ -100,14 +371,14 @@ int main()
             // Compute absolute difference between current and previous frames (SIMD)
             absDiff_SIMD(grayFrame, prevGrayFrame, motionFrame);
 
-            // Resize the motion frame to fit the window size (640x480)
-            cv::resize(motionFrame, motionFrame, cv::Size(640, 480));
+            // Resize the motion frame to fit the window size (640x480), into a reused buffer
+            resampler.apply(motionFrame, displayFrame, cv::Size(640, 480));
 
             // Write the frame to the output video
-            SIMDVideo.write(motionFrame);
+            SIMDVideo.write(displayFrame);
 
             // Show the motion frame for SIMD
-            cv::imshow("Motion Frame - SIMD", motionFrame);
+            cv::imshow("Motion Frame - SIMD", displayFrame);
             if (cv::waitKey(30) >= 0)
                 break;
         }
@@ -144,14 +415,14 @@ int main()
             // Compute absolute difference between current and previous frames (serial)
             absDiff_Serial(grayFrame, prevGrayFrame, motionFrame);
 
-            // Resize the motion frame to fit the window size (640x480)
-            cv::resize(motionFrame, motionFrame, cv::Size(640, 480));
+            // Resize the motion frame to fit the window size (640x480), into a reused buffer
+            resampler.apply(motionFrame, displayFrame, cv::Size(640, 480));
 
             // Write the frame to the output video
-            SerialVideo.write(motionFrame); // Optionally write serial motion frames too
+            SerialVideo.write(displayFrame); // Optionally write serial motion frames too
 
             // Show the motion frame for serial
-            cv::imshow("Motion Frame - Serial", motionFrame);
+            cv::imshow("Motion Frame - Serial", displayFrame);
             if (cv::waitKey(30) >= 0)
                 break;
         }
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include <vector>
+#include "resample.hpp"
+
+// cv::Mat front end of resample.hpp: a drop-in for cv::resize on 8-bit 1, 3
+// or 4 channel images that keeps its coefficient tables and the output buffer
+// between calls. Output rows are split into bands across cv::parallel_for_;
+// each band resamples only the input rows it needs, so bands stay independent.
+class ImageResampler
+{
+public:
+    explicit ImageResampler(ResampleFilter filter = RESAMPLE_BILINEAR, bool simd = true) : filter(filter), simd(simd) {}
+
+    // dst is reallocated only when its size or type changes
+    void apply(const cv::Mat &src, cv::Mat &dst, cv::Size size)
+    {
+        if (src.depth() != CV_8U || src.channels() > 4 || src.empty() || size.width <= 0 || size.height <= 0)
+        {
+            std::cerr << "ImageResampler: expects a non-empty 8-bit image with 1 to 4 channels." << std::endl;
+            return;
+        }
+        if (src.data == dst.data)
+        {
+            cv::Mat copy = src.clone();
+            apply(copy, dst, size);
+            return;
+        }
+        if (!ax.matches(src.cols, size.width, filter))
+            ax = makeResampleAxis(src.cols, size.width, filter);
+        if (!ay.matches(src.rows, size.height, filter))
+            ay = makeResampleAxis(src.rows, size.height, filter);
+        dst.create(size, src.type());
+
+        int cn = src.channels();
+        int bands = std::max(1, std::min(size.height, 4 * cv::getNumThreads()));
+        cv::parallel_for_(cv::Range(0, bands), [&](const cv::Range &range)
+                          {
+                              thread_local std::vector<uint8_t> scratch;
+                              for (int b = range.start; b < range.end; ++b)
+                                  resampleBand(src.data, src.step, dst.data, dst.step, cn, ax, ay,
+                                               size.height * b / bands, size.height * (b + 1) / bands, scratch, simd);
+                          },
+                          bands);
+    }
+
+    ResampleFilter filterType() const { return filter; }
+
+private:
+    ResampleFilter filter;
+    bool simd;
+    ResampleAxis ax, ay;
+};
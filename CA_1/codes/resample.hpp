@@ -0,0 +1,376 @@
+#pragma once
+
+#include <smmintrin.h>
+#include <tmmintrin.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "../../common/perf_counters.hpp"
+
+// Separable 8-bit image resampling (CA_1 Q1 logo scaling, Q4 motion frames),
+// without OpenCV: image_resampler.hpp wraps it for cv::Mat and threads it.
+//
+// Every output pixel is a weighted sum of a few input pixels per axis. The
+// weights depend only on the sizes, so they are computed once per axis
+// (ResampleAxis) in 16-bit fixed point, 1.0 = 1 << RESAMPLE_BITS, and summing
+// exactly to 1.0 so flat areas stay flat. One axis is resampled into an 8-bit
+// intermediate, then the other; both passes multiply pairs of taps with
+// _mm_madd_epi16.
+//
+// Pixel centres are aligned as in cv::resize: output i sits at input
+// (i + 0.5) * in / out - 0.5, and borders replicate the edge pixel.
+//
+//   RESAMPLE_BILINEAR  2 taps, like cv::INTER_LINEAR (no low-pass when shrinking)
+//   RESAMPLE_AREA      box average over the covered input, like cv::INTER_AREA
+//                      when shrinking; bilinear when enlarging
+//   RESAMPLE_LANCZOS3  windowed sinc, 6 taps, widened by the scale when shrinking
+
+enum ResampleFilter
+{
+    RESAMPLE_BILINEAR,
+    RESAMPLE_AREA,
+    RESAMPLE_LANCZOS3
+};
+
+const int RESAMPLE_BITS = 14;
+
+// Output i reads input start[i] .. start[i] + taps - 1 with weights[i * taps ..].
+// Windows are shifted to lie inside the input, with zero weights where needed.
+struct ResampleAxis
+{
+    int inSize = 0, outSize = 0, taps = 0;
+    ResampleFilter filter = RESAMPLE_BILINEAR;
+    std::vector<int> start;
+    std::vector<int16_t> weights;
+    // Single-channel horizontal pass: groups of 4 outputs, tap pairs
+    // interleaved as (o0 k, o0 k+1, o1 k, o1 k+1, ...), 8 weights per pair
+    std::vector<int16_t> grouped;
+
+    bool matches(int in, int out, ResampleFilter f) const { return inSize == in && outSize == out && filter == f; }
+};
+
+inline double lanczos3(double x)
+{
+    x = std::fabs(x);
+    if (x < 1e-9)
+        return 1.0;
+    if (x >= 3.0)
+        return 0.0;
+    const double pi = 3.14159265358979323846;
+    return 3.0 * std::sin(pi * x) * std::sin(pi * x / 3.0) / (pi * pi * x * x);
+}
+
+inline ResampleAxis makeResampleAxis(int inSize, int outSize, ResampleFilter filter)
+{
+    ResampleAxis axis;
+    axis.inSize = inSize;
+    axis.outSize = outSize;
+    axis.filter = filter;
+    if (inSize <= 0 || outSize <= 0)
+        return axis;
+
+    double scale = (double)inSize / outSize;
+    bool area = filter == RESAMPLE_AREA && scale > 1.0;
+
+    // Float weights per output, keyed by clamped input index
+    std::vector<std::vector<std::pair<int, double>>> taps(outSize);
+    int maxTaps = 1;
+    for (int i = 0; i < outSize; ++i)
+    {
+        std::vector<std::pair<int, double>> &t = taps[i];
+        auto add = [&](int j, double w)
+        {
+            if (std::fabs(w) < 1e-9)
+                return;
+            j = std::min(std::max(j, 0), inSize - 1);
+            if (!t.empty() && t.back().first == j)
+                t.back().second += w;
+            else
+                t.push_back({j, w});
+        };
+        if (area)
+        {
+            // Coverage of input pixel j by the output pixel [i * scale, (i + 1) * scale)
+            double lo = i * scale, hi = (i + 1) * scale;
+            for (int j = (int)std::floor(lo); j < hi; ++j)
+                add(j, std::min(hi, j + 1.0) - std::max(lo, (double)j));
+        }
+        else
+        {
+            double centre = (i + 0.5) * scale - 0.5;
+            if (filter == RESAMPLE_LANCZOS3)
+            {
+                double stretch = std::max(1.0, scale), support = 3.0 * stretch;
+                for (int j = (int)std::floor(centre - support) + 1; j <= (int)std::floor(centre + support); ++j)
+                    add(j, lanczos3((j - centre) / stretch));
+            }
+            else
+            {
+                int j = (int)std::floor(centre);
+                double f = centre - j;
+                add(j, 1.0 - f);
+                add(j + 1, f);
+            }
+        }
+        maxTaps = std::max(maxTaps, t.back().first - t.front().first + 1);
+    }
+
+    // An even tap count lets every pass work in pairs, when the input is wide enough
+    axis.taps = std::min(inSize, maxTaps + (maxTaps & 1));
+    axis.start.resize(outSize);
+    axis.weights.assign((size_t)outSize * axis.taps, 0);
+    for (int i = 0; i < outSize; ++i)
+    {
+        const std::vector<std::pair<int, double>> &t = taps[i];
+        int start = std::min(t.front().first, inSize - axis.taps);
+        axis.start[i] = start;
+
+        double sum = 0;
+        for (const auto &tap : t)
+            sum += tap.second;
+        int16_t *w = &axis.weights[(size_t)i * axis.taps];
+        int total = 0, largest = 0;
+        for (const auto &tap : t)
+        {
+            int k = tap.first - start;
+            w[k] = (int16_t)std::lround(tap.second / sum * (1 << RESAMPLE_BITS));
+            total += w[k];
+            if (std::abs(w[k]) > std::abs(w[largest]))
+                largest = k;
+        }
+        // Rounding error goes to the largest weight, so the weights sum to exactly 1.0
+        w[largest] = (int16_t)(w[largest] + (1 << RESAMPLE_BITS) - total);
+    }
+
+    if (axis.taps % 2 == 0)
+    {
+        int groups = outSize / 4;
+        axis.grouped.resize((size_t)groups * axis.taps * 4);
+        for (int g = 0; g < groups; ++g)
+            for (int p = 0; p < axis.taps / 2; ++p)
+                for (int o = 0; o < 4; ++o)
+                    for (int h = 0; h < 2; ++h)
+                        axis.grouped[((size_t)g * (axis.taps / 2) + p) * 8 + o * 2 + h] = axis.weights[(size_t)(4 * g + o) * axis.taps + 2 * p + h];
+    }
+    return axis;
+}
+
+inline uint8_t resampleRound(int sum)
+{
+    int v = (sum + (1 << (RESAMPLE_BITS - 1))) >> RESAMPLE_BITS;
+    return (uint8_t)(v < 0 ? 0 : v > 255 ? 255 : v);
+}
+
+// ---- Horizontal pass: one row of cn-channel pixels ---------------------------
+
+inline void resampleRowH_Serial(const uint8_t *src, uint8_t *dst, const ResampleAxis &ax, int cn)
+{
+    for (int x = 0; x < ax.outSize; ++x)
+    {
+        const uint8_t *s = src + (size_t)ax.start[x] * cn;
+        const int16_t *w = &ax.weights[(size_t)x * ax.taps];
+        for (int c = 0; c < cn; ++c)
+        {
+            int sum = 0;
+            for (int k = 0; k < ax.taps; ++k)
+                sum += s[k * cn + c] * w[k];
+            dst[x * cn + c] = resampleRound(sum);
+        }
+    }
+}
+
+// Round, shift and saturate four int32 sums to bytes (low 4 bytes of the result)
+inline __m128i resamplePack(__m128i sum)
+{
+    __m128i v = _mm_srai_epi32(_mm_add_epi32(sum, _mm_set1_epi32(1 << (RESAMPLE_BITS - 1))), RESAMPLE_BITS);
+    v = _mm_packs_epi32(v, v);
+    return _mm_packus_epi16(v, v);
+}
+
+// 3 or 4 channels: two pixels per load, channels interleaved as (p0 c, p1 c)
+// int16 pairs; CN is a constant so the partial loads and stores stay inline
+template <int CN>
+__attribute__((target("ssse3"))) inline void resampleRowH_Pixels(const uint8_t *src, uint8_t *dst, const ResampleAxis &ax)
+{
+    const __m128i spread = CN == 3 ? _mm_setr_epi8(0, -1, 3, -1, 1, -1, 4, -1, 2, -1, 5, -1, -1, -1, -1, -1)
+                                   : _mm_setr_epi8(0, -1, 4, -1, 1, -1, 5, -1, 2, -1, 6, -1, 3, -1, 7, -1);
+    const int pairs = ax.taps / 2;
+    const size_t rowBytes = (size_t)ax.inSize * CN;
+    for (int x = 0; x < ax.outSize; ++x)
+    {
+        const uint8_t *s = src + (size_t)ax.start[x] * CN;
+        const int16_t *w = &ax.weights[(size_t)x * ax.taps];
+        // An 8-byte load of two 3-byte pixels reads 2 bytes beyond them
+        bool wideLoads = CN == 4 || ((size_t)ax.start[x] + ax.taps) * CN + 2 <= rowBytes;
+        __m128i sum = _mm_setzero_si128();
+        for (int p = 0; p < pairs; ++p)
+        {
+            __m128i bytes;
+            if (wideLoads)
+                bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(s + 2 * p * CN));
+            else
+            {
+                int64_t v = 0;
+                memcpy(&v, s + 2 * p * CN, 2 * CN);
+                bytes = _mm_cvtsi64_si128(v);
+            }
+            int32_t pair;
+            memcpy(&pair, w + 2 * p, 4);
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_shuffle_epi8(bytes, spread), _mm_set1_epi32(pair)));
+        }
+        int packed = _mm_cvtsi128_si32(resamplePack(sum));
+        memcpy(dst + (size_t)x * CN, &packed, CN);
+    }
+}
+
+__attribute__((target("ssse3"))) inline void resampleRowH_SIMD(const uint8_t *src, uint8_t *dst, const ResampleAxis &ax, int cn)
+{
+    if (ax.taps % 2 || (cn != 1 && cn != 3 && cn != 4))
+        return resampleRowH_Serial(src, dst, ax, cn);
+
+    const int pairs = ax.taps / 2;
+    if (cn == 1)
+    {
+        // Four outputs at a time: each lane pair holds two neighbouring input bytes
+        const __m128i spread = _mm_setr_epi8(0, -1, 1, -1, 4, -1, 5, -1, 8, -1, 9, -1, 12, -1, 13, -1);
+        int x = 0;
+        for (; x + 4 <= ax.outSize; x += 4)
+        {
+            const uint8_t *s0 = src + ax.start[x], *s1 = src + ax.start[x + 1], *s2 = src + ax.start[x + 2], *s3 = src + ax.start[x + 3];
+            const int16_t *w = &ax.grouped[(size_t)(x / 4) * pairs * 8];
+            __m128i sum = _mm_setzero_si128();
+            for (int p = 0; p < pairs; ++p)
+            {
+                uint16_t a, b, c, d;
+                memcpy(&a, s0 + 2 * p, 2);
+                memcpy(&b, s1 + 2 * p, 2);
+                memcpy(&c, s2 + 2 * p, 2);
+                memcpy(&d, s3 + 2 * p, 2);
+                __m128i px = _mm_shuffle_epi8(_mm_setr_epi32(a, b, c, d), spread);
+                sum = _mm_add_epi32(sum, _mm_madd_epi16(px, _mm_loadu_si128(reinterpret_cast<const __m128i *>(w + 8 * p))));
+            }
+            int packed = _mm_cvtsi128_si32(resamplePack(sum));
+            memcpy(dst + x, &packed, 4);
+        }
+        for (; x < ax.outSize; ++x)
+        {
+            const uint8_t *s = src + ax.start[x];
+            const int16_t *w = &ax.weights[(size_t)x * ax.taps];
+            int sum = 0;
+            for (int k = 0; k < ax.taps; ++k)
+                sum += s[k] * w[k];
+            dst[x] = resampleRound(sum);
+        }
+        return;
+    }
+
+    if (cn == 3)
+        resampleRowH_Pixels<3>(src, dst, ax);
+    else
+        resampleRowH_Pixels<4>(src, dst, ax);
+}
+
+// ---- Vertical pass: n bytes of one output row from ax.taps input rows --------
+
+inline void resampleRowV_Serial(const uint8_t *const *rows, const int16_t *w, int taps, uint8_t *dst, int n)
+{
+    for (int i = 0; i < n; ++i)
+    {
+        int sum = 0;
+        for (int k = 0; k < taps; ++k)
+            sum += rows[k][i] * w[k];
+        dst[i] = resampleRound(sum);
+    }
+}
+
+inline void resampleRowV_SIMD(const uint8_t *const *rows, const int16_t *w, int taps, uint8_t *dst, int n)
+{
+    const __m128i zero = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i s0 = zero, s1 = zero, s2 = zero, s3 = zero;
+        for (int k = 0; k < taps; k += 2)
+        {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rows[k] + i));
+            __m128i b = k + 1 < taps ? _mm_loadu_si128(reinterpret_cast<const __m128i *>(rows[k + 1] + i)) : zero;
+            __m128i weights = _mm_set1_epi32((uint16_t)w[k] | (uint32_t)(uint16_t)(k + 1 < taps ? w[k + 1] : 0) << 16);
+            // (a, b) byte pairs widened to int16 pairs, 4 pixels per madd
+            __m128i lo = _mm_unpacklo_epi8(a, b), hi = _mm_unpackhi_epi8(a, b);
+            s0 = _mm_add_epi32(s0, _mm_madd_epi16(_mm_unpacklo_epi8(lo, zero), weights));
+            s1 = _mm_add_epi32(s1, _mm_madd_epi16(_mm_unpackhi_epi8(lo, zero), weights));
+            s2 = _mm_add_epi32(s2, _mm_madd_epi16(_mm_unpacklo_epi8(hi, zero), weights));
+            s3 = _mm_add_epi32(s3, _mm_madd_epi16(_mm_unpackhi_epi8(hi, zero), weights));
+        }
+        __m128i round = _mm_set1_epi32(1 << (RESAMPLE_BITS - 1));
+        s0 = _mm_srai_epi32(_mm_add_epi32(s0, round), RESAMPLE_BITS);
+        s1 = _mm_srai_epi32(_mm_add_epi32(s1, round), RESAMPLE_BITS);
+        s2 = _mm_srai_epi32(_mm_add_epi32(s2, round), RESAMPLE_BITS);
+        s3 = _mm_srai_epi32(_mm_add_epi32(s3, round), RESAMPLE_BITS);
+        __m128i packed = _mm_packus_epi16(_mm_packs_epi32(s0, s1), _mm_packs_epi32(s2, s3));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), packed);
+    }
+    if (i < n)
+    {
+        const uint8_t *tail[64];
+        int t = std::min(taps, 64);
+        for (int k = 0; k < t; ++k)
+            tail[k] = rows[k] + i;
+        resampleRowV_Serial(tail, w, t, dst + i, n - i);
+    }
+}
+
+// ---- One band of output rows ---------------------------------------------------
+
+// Output rows [y0, y1) of a cn-channel image; `scratch` is reused from call to
+// call. The horizontal pass costs the most per row, so it runs on whichever
+// side has fewer rows: after the vertical pass when shrinking vertically (one
+// input-width row per output row), before it otherwise (the input rows the
+// band needs, each resampled once).
+inline void resampleBand(const uint8_t *src, size_t srcStep, uint8_t *dst, size_t dstStep, int cn, const ResampleAxis &ax, const ResampleAxis &ay,
+                         int y0, int y1, std::vector<uint8_t> &scratch, bool simd)
+{
+    if (y0 >= y1 || ax.outSize <= 0)
+        return;
+    size_t inBytes = (size_t)ax.inSize * cn, outBytes = (size_t)ax.outSize * cn;
+    std::vector<const uint8_t *> rows(ay.taps);
+    auto horizontal = simd ? resampleRowH_SIMD : resampleRowH_Serial;
+    auto vertical = simd && ay.taps <= 64 ? resampleRowV_SIMD : resampleRowV_Serial;
+
+    if (ay.outSize <= ay.inSize)
+    {
+        PERF_REGION("resampleBand", (y1 - y0) * ((double)ay.taps * inBytes + outBytes),
+                    2.0 * (y1 - y0) * ((double)ay.taps * inBytes + (double)ax.taps * outBytes));
+        scratch.resize(inBytes);
+        for (int y = y0; y < y1; ++y)
+        {
+            for (int k = 0; k < ay.taps; ++k)
+                rows[k] = src + (ay.start[y] + k) * srcStep;
+            vertical(rows.data(), &ay.weights[(size_t)y * ay.taps], ay.taps, scratch.data(), (int)inBytes);
+            horizontal(scratch.data(), dst + y * dstStep, ax, cn);
+        }
+        return;
+    }
+
+    // Input rows [first, last); window starts are not strictly monotonic
+    int first = ay.start[y0], last = ay.start[y0] + ay.taps;
+    for (int y = y0 + 1; y < y1; ++y)
+    {
+        first = std::min(first, ay.start[y]);
+        last = std::max(last, ay.start[y] + ay.taps);
+    }
+    PERF_REGION("resampleBand", (last - first) * (double)inBytes + (y1 - y0) * (double)outBytes,
+                2.0 * ((last - first) * ax.taps + (y1 - y0) * ay.taps) * (double)outBytes);
+    scratch.resize((size_t)(last - first) * outBytes);
+    for (int r = first; r < last; ++r)
+        horizontal(src + r * srcStep, &scratch[(size_t)(r - first) * outBytes], ax, cn);
+
+    for (int y = y0; y < y1; ++y)
+    {
+        for (int k = 0; k < ay.taps; ++k)
+            rows[k] = &scratch[(size_t)(ay.start[y] + k - first) * outBytes];
+        vertical(rows.data(), &ay.weights[(size_t)y * ay.taps], ay.taps, dst + y * dstStep, (int)outBytes);
+    }
+}
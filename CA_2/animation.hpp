@@ -0,0 +1,214 @@
+#pragma once
+
+#include <omp.h>
+#include <stdint.h>
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../common/numa_affinity.hpp"
+
+// Streams rendered RGB frames into a raw YUV4MPEG2 (.y4m) video, with
+// rendering and encoding overlapped:
+//
+//   render thread (OpenMP team)   frame N+1  ->  ready queue  ->  encoder thread: frame N
+//                  ^                                                   |
+//                  +-------------------- idle pool <-------------------+
+//
+// Frame buffers come from a fixed pool, so memory stays at `poolSize` frames
+// however long the animation is, and the renderer blocks instead of running
+// ahead when the encoder falls behind. Y4M is uncompressed but plays and
+// converts directly, e.g. `ffmpeg -i zoom.y4m zoom.mp4`, or stream it with
+// the path "-": `./main1 --animate 2000 - | ffmpeg -i - zoom.mp4`.
+
+// Blocking FIFO with a fixed capacity; push() waits while full, pop() waits
+// while empty. After close(), pop() drains what is left and then returns false.
+template <typename T>
+class FrameQueue
+{
+public:
+    explicit FrameQueue(size_t capacity) : capacity(capacity), closed(false) {}
+
+    void push(T item)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [this]
+                     { return items.size() < capacity; });
+        items.push_back(std::move(item));
+        notEmpty.notify_one();
+    }
+
+    bool pop(T &item)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [this]
+                      { return !items.empty() || closed; });
+        if (items.empty())
+            return false;
+        item = std::move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        notEmpty.notify_all();
+    }
+
+private:
+    size_t capacity;
+    bool closed;
+    std::deque<T> items;
+    std::mutex mutex;
+    std::condition_variable notEmpty, notFull;
+};
+
+// Writes 4:2:0 Y4M frames. Colours are converted with BT.601 (limited range),
+// chroma is the average of each 2x2 block; odd sizes round the chroma planes up.
+class Y4MWriter
+{
+public:
+    // `path` "-" writes to stdout
+    Y4MWriter(const std::string &path, int width, int height, int fps)
+        : width(width), height(height), chromaWidth((width + 1) / 2), chromaHeight((height + 1) / 2),
+          planes((size_t)width * height + 2 * (size_t)chromaWidth * chromaHeight)
+    {
+        file = path == "-" ? stdout : fopen(path.c_str(), "wb");
+        if (!file)
+        {
+            std::cerr << "Error opening file " << path << " for writing.\n";
+            return;
+        }
+        fprintf(file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height, fps);
+    }
+
+    ~Y4MWriter()
+    {
+        if (file && file != stdout)
+            fclose(file);
+        else if (file)
+            fflush(file);
+    }
+
+    Y4MWriter(const Y4MWriter &) = delete;
+    Y4MWriter &operator=(const Y4MWriter &) = delete;
+
+    bool ok() const { return file != nullptr; }
+
+    bool write(const PixelBuffer &rgb)
+    {
+        if (!file)
+            return false;
+        unsigned char *yPlane = planes.data();
+        unsigned char *uPlane = yPlane + (size_t)width * height;
+        unsigned char *vPlane = uPlane + (size_t)chromaWidth * chromaHeight;
+
+        for (int y = 0; y < height; y++)
+        {
+            const unsigned char *p = &rgb[3 * (size_t)y * width];
+            for (int x = 0; x < width; x++, p += 3)
+                yPlane[(size_t)y * width + x] = (unsigned char)(((66 * p[0] + 129 * p[1] + 25 * p[2] + 128) >> 8) + 16);
+        }
+
+        for (int cy = 0; cy < chromaHeight; cy++)
+        {
+            int y0 = 2 * cy, y1 = std::min(y0 + 1, height - 1);
+            for (int cx = 0; cx < chromaWidth; cx++)
+            {
+                int x0 = 2 * cx, x1 = std::min(x0 + 1, width - 1);
+                int sum[3] = {0, 0, 0};
+                for (int k = 0; k < 3; k++)
+                    sum[k] = rgb[3 * ((size_t)y0 * width + x0) + k] + rgb[3 * ((size_t)y0 * width + x1) + k] +
+                             rgb[3 * ((size_t)y1 * width + x0) + k] + rgb[3 * ((size_t)y1 * width + x1) + k];
+                int r = (sum[0] + 2) >> 2, g = (sum[1] + 2) >> 2, b = (sum[2] + 2) >> 2;
+                uPlane[(size_t)cy * chromaWidth + cx] = (unsigned char)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+                vPlane[(size_t)cy * chromaWidth + cx] = (unsigned char)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+            }
+        }
+
+        fputs("FRAME\n", file);
+        return fwrite(planes.data(), 1, planes.size(), file) == planes.size();
+    }
+
+private:
+    int width, height, chromaWidth, chromaHeight;
+    std::vector<unsigned char> planes;
+    FILE *file = nullptr;
+};
+
+struct AnimationStats
+{
+    int frames = 0;
+    double seconds = 0;       // wall time, first render to last frame written
+    double renderSeconds = 0; // summed over frames, render thread
+    double encodeSeconds = 0; // summed over frames, encoder thread
+
+    double framesPerSecond() const { return seconds > 0 ? frames / seconds : 0; }
+    // Time saved by overlapping the two stages, relative to running them back to back
+    double overlap() const { return renderSeconds + encodeSeconds > 0 ? 1 - seconds / (renderSeconds + encodeSeconds) : 0; }
+};
+
+// render(frame, rgb) fills frame `frame` of `frames`; it runs on the calling
+// thread and may use its own OpenMP team. poolSize >= 2 lets one frame
+// render while the previous one encodes.
+template <class Render>
+inline AnimationStats render_animation(const std::string &path, int width, int height, int fps, int frames, Render render, int poolSize = 3)
+{
+    AnimationStats stats;
+    Y4MWriter writer(path, width, height, fps);
+    if (!writer.ok())
+        return stats;
+
+    poolSize = std::max(2, poolSize);
+    std::vector<PixelBuffer> pool(poolSize, PixelBuffer((size_t)width * height * 3));
+    for (PixelBuffer &frame : pool)
+        firstTouchRows(frame, 3 * width, height);
+
+    FrameQueue<PixelBuffer *> idle(poolSize), ready(poolSize);
+    for (PixelBuffer &frame : pool)
+        idle.push(&frame);
+
+    double start = omp_get_wtime();
+    bool writeFailed = false;
+    std::thread encoder([&]
+                        {
+        PixelBuffer *frame = nullptr;
+        while (ready.pop(frame))
+        {
+            double t = omp_get_wtime();
+            if (!writeFailed && !writer.write(*frame))
+            {
+                std::cerr << "Error writing video frame to " << path << "\n";
+                writeFailed = true;
+            }
+            stats.encodeSeconds += omp_get_wtime() - t;
+            idle.push(frame);
+        } });
+
+    int rendered = 0;
+    for (; rendered < frames; rendered++)
+    {
+        // The idle queue is never closed, so pop only fails if that changes
+        PixelBuffer *frame = nullptr;
+        if (!idle.pop(frame))
+            break;
+        double t = omp_get_wtime();
+        render(rendered, *frame);
+        stats.renderSeconds += omp_get_wtime() - t;
+        ready.push(frame);
+    }
+    ready.close();
+    encoder.join();
+
+    stats.seconds = omp_get_wtime() - start;
+    stats.frames = writeFailed ? 0 : rendered;
+    return stats;
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <omp.h>
+#include <stdint.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+#include "../common/numa_affinity.hpp"
+#include "../common/perf_counters.hpp"
+
+// Adaptive anti-aliasing shared by the fractal renderers (q1 Mandelbrot, q2 Julia).
+//
+//   1. Render at one sample per pixel, keeping each pixel's iteration count.
+//   2. Mark edge pixels: a neighbour (8-connected) whose iteration count
+//      differs by more than iterationTolerance, or whose colour differs by
+//      more than colorTolerance in any channel.
+//   3. Re-render only the edge pixels with `samples` jittered, stratified
+//      subsamples (a sqrt(samples)^2 grid, one random point per cell) and
+//      store the average colour.
+//
+// Flat areas keep their single sample, so the cost is close to 1 spp plus
+// `samples` per edge pixel. Edges look like full samples x SSAA. The jitter is
+// hashed from the pixel position, so images do not depend on the thread count.
+
+struct AAOptions
+{
+    int samples = 16;           // subsamples per edge pixel, rounded down to a square
+    int iterationTolerance = 1; // neighbour iteration counts within this are not an edge
+    int colorTolerance = 12;    // nor are colours within this, per channel
+};
+
+struct AAStats
+{
+    long pixels = 0;
+    long edgePixels = 0;
+    long samples = 0; // evaluated points in both passes
+
+    double edgeFraction() const { return pixels ? (double)edgePixels / pixels : 0; }
+    // Cost relative to supersampling every pixel with the same sample count
+    double costVersusFullSSAA(int samplesPerPixel) const { return pixels ? (double)samples / ((double)pixels * samplesPerPixel) : 0; }
+};
+
+// Deterministic jitter in [0, 1) for subsample s of pixel (x, y)
+inline float aaJitter(int x, int y, int s, int axis)
+{
+    uint32_t h = (uint32_t)x * 0x8da6b343u ^ (uint32_t)y * 0xd8163841u ^ (uint32_t)(2 * s + axis) * 0xcb1ab31fu;
+    h ^= h >> 16;
+    h *= 0x7feb352du;
+    h ^= h >> 15;
+    h *= 0x846ca68bu;
+    h ^= h >> 16;
+    return (h >> 8) * (1.0f / 16777216.0f);
+}
+
+// iterate(px, py) returns the iteration count at continuous pixel coordinates
+// (pixel x covers [x, x + 1)); color(iterations, r, g, b) maps it to RGB.
+template <class Iterate, class Color>
+inline AAStats render_antialiased(int width, int height, PixelBuffer &rgb, const AAOptions &opt, Iterate iterate, Color color)
+{
+    AAStats stats;
+    stats.pixels = (long)width * height;
+    std::vector<int> iterations((size_t)width * height);
+
+    // Pass 1: one sample per pixel, at the same point the plain renderers use
+#pragma omp parallel for schedule(dynamic)
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            int it = iterate((float)x, (float)y);
+            iterations[(size_t)y * width + x] = it;
+            int k = 3 * (y * width + x);
+            color(it, rgb[k], rgb[k + 1], rgb[k + 2]);
+        }
+    }
+
+    // Edge detection, compacted per row so pass 2 balances over edge pixels only
+    std::vector<std::vector<int>> edgeRows(height);
+#pragma omp parallel for schedule(dynamic)
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            int it = iterations[(size_t)y * width + x];
+            const unsigned char *c = &rgb[3 * ((size_t)y * width + x)];
+            bool edge = false;
+            for (int dy = -1; dy <= 1 && !edge; dy++)
+            {
+                int ny = y + dy;
+                if (ny < 0 || ny >= height)
+                    continue;
+                for (int dx = -1; dx <= 1 && !edge; dx++)
+                {
+                    int nx = x + dx;
+                    if (nx < 0 || nx >= width || (dx == 0 && dy == 0))
+                        continue;
+                    const unsigned char *n = &rgb[3 * ((size_t)ny * width + nx)];
+                    edge = std::abs(iterations[(size_t)ny * width + nx] - it) > opt.iterationTolerance ||
+                           std::abs(n[0] - c[0]) > opt.colorTolerance || std::abs(n[1] - c[1]) > opt.colorTolerance ||
+                           std::abs(n[2] - c[2]) > opt.colorTolerance;
+                }
+            }
+            if (edge)
+                edgeRows[y].push_back(x);
+        }
+    }
+
+    std::vector<int> edges; // y * width + x
+    for (int y = 0; y < height; y++)
+        for (int x : edgeRows[y])
+            edges.push_back(y * width + x);
+    stats.edgePixels = (long)edges.size();
+
+    // Pass 2: stratified jittered subsamples of the edge pixels. Colours are
+    // written only here, after detection finished reading them.
+    int grid = std::max(1, (int)std::sqrt((double)std::max(1, opt.samples)));
+    int n = grid * grid;
+    long count = (long)edges.size();
+#pragma omp parallel
+    {
+        PERF_REGION("render_antialiased edges", 0, 0);
+#pragma omp for schedule(dynamic, 16)
+        for (long e = 0; e < count; e++)
+        {
+            int x = edges[e] % width, y = edges[e] / width;
+            int sum[3] = {0, 0, 0};
+            for (int s = 0; s < n; s++)
+            {
+                float px = x + (s % grid + aaJitter(x, y, s, 0)) / grid;
+                float py = y + (s / grid + aaJitter(x, y, s, 1)) / grid;
+                unsigned char r, g, b;
+                color(iterate(px, py), r, g, b);
+                sum[0] += r;
+                sum[1] += g;
+                sum[2] += b;
+            }
+            int k = 3 * edges[e];
+            for (int c = 0; c < 3; c++)
+                rgb[k + c] = (unsigned char)((sum[c] + n / 2) / n);
+        }
+    }
+    stats.samples = stats.pixels + (long)n * stats.edgePixels;
+    return stats;
+}
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <mpi.h>
+#include <omp.h>
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../common/numa_affinity.hpp"
+
+// Hybrid MPI + OpenMP: one process per socket or node, OpenMP threads inside
+// each, so the work is no longer limited to one process's memory bandwidth.
+// Built only with -DPP_WITH_MPI (`make mpi` in q1 / q3, or the *_mpi CMake
+// targets); try it on one machine with e.g.
+//
+//   OMP_NUM_THREADS=4 mpirun -np 2 ./main1_mpi --mpi
+//
+// Fractal images are cut into bands of rows and handed out dynamically: rank
+// 0 is the master, sends a band index to each worker and a new one whenever
+// a finished band comes back (the message tag is the band index, so the
+// pixels are received straight into place). Between messages the master
+// renders bands itself rather than sit idle. With an output path given, every
+// rank writes its own bands into the PPM with MPI-IO instead, and only the
+// band numbers travel to rank 0.
+
+struct MPIRenderStats
+{
+    int ranks = 1;
+    int bands = 0;
+    double seconds = 0;
+    std::vector<int> bandsPerRank; // on rank 0
+
+    double bandsPerSecond() const { return seconds > 0 ? bands / seconds : 0; }
+};
+
+inline int mpi_rank()
+{
+    int rank = 0;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    return rank;
+}
+
+inline int mpi_size()
+{
+    int size = 1;
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    return size;
+}
+
+// MPI_Init with the threading level OpenMP needs: only the main thread calls MPI
+inline bool mpi_init(int &argc, char **&argv)
+{
+    int provided = 0;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+    if (provided < MPI_THREAD_FUNNELED)
+    {
+        if (mpi_rank() == 0)
+            std::cerr << "MPI library does not support MPI_THREAD_FUNNELED.\n";
+        MPI_Finalize();
+        return false;
+    }
+    return true;
+}
+
+// Monte Carlo pi over all ranks: rank r draws its share of total_points from
+// stream r (count(points, seed, stream), e.g. monte_carlo_count_seeded) and the
+// hit counts are summed with MPI_Allreduce. Every rank gets the estimate.
+template <class Count>
+inline double mpi_monte_carlo_pi(long long total_points, unsigned seed, Count count)
+{
+    int rank = mpi_rank(), size = mpi_size();
+    long long share = total_points / size + (rank < total_points % size ? 1 : 0);
+    long long hits = count(share, seed, rank), all_hits = 0;
+    MPI_Allreduce(&hits, &all_hits, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+    return 4.0 * all_hits / total_points;
+}
+
+namespace mpi_detail
+{
+    const int WORK_TAG = 0;
+    const int STOP_BAND = -1;
+
+    // The band index is the tag of the reply, which must stay under MPI_TAG_UB (>= 32767)
+    inline int band_rows_for(int height, int band_rows)
+    {
+        band_rows = std::max(1, band_rows);
+        return std::max(band_rows, (height + 32766) / 32767);
+    }
+
+    inline int band_begin(int band, int band_rows) { return band * band_rows; }
+    inline int band_end(int band, int band_rows, int height) { return std::min(height, (band + 1) * band_rows); }
+}
+
+// Renders a width x height RGB image across all ranks. render(y0, y1, out)
+// fills rows [y0, y1) into out, 3 * width bytes per row, and is free to use
+// OpenMP. Without a path the image is gathered into rgb on rank 0 (rgb is not
+// touched on the other ranks); with one, the ranks write a binary PPM
+// together with MPI-IO and rgb is not used. Collective: call it on every rank.
+template <class Render>
+inline MPIRenderStats mpi_render_bands(int width, int height, int band_rows, PixelBuffer &rgb, Render render,
+                                       const std::string &ppm_path = "")
+{
+    using namespace mpi_detail;
+
+    MPIRenderStats stats;
+    int rank = mpi_rank(), size = mpi_size();
+    band_rows = band_rows_for(height, band_rows);
+    size_t row_bytes = 3 * (size_t)width;
+    stats.ranks = size;
+    stats.bands = (height + band_rows - 1) / band_rows;
+
+    bool parallel_io = !ppm_path.empty();
+    MPI_File file;
+    char header[64];
+    int header_bytes = snprintf(header, sizeof(header), "P6\n%d %d\n255\n", width, height);
+    if (parallel_io)
+    {
+        if (MPI_File_open(MPI_COMM_WORLD, ppm_path.c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &file) != MPI_SUCCESS)
+        {
+            if (rank == 0)
+                std::cerr << "Error opening file " << ppm_path << " for writing.\n";
+            stats.bands = 0;
+            return stats;
+        }
+        MPI_File_set_size(file, header_bytes + (MPI_Offset)row_bytes * height);
+        if (rank == 0)
+            MPI_File_write_at(file, 0, header, header_bytes, MPI_CHAR, MPI_STATUS_IGNORE);
+    }
+    else if (rank == 0)
+        rgb.resize(row_bytes * height);
+
+    // Rendered bands go to the file, or (rank 0, gathering) straight into rgb
+    std::vector<unsigned char> band_pixels(parallel_io || rank != 0 ? row_bytes * band_rows : 0);
+    int done = 0;
+    auto render_band = [&](int band)
+    {
+        int y0 = band_begin(band, band_rows), y1 = band_end(band, band_rows, height);
+        unsigned char *out = band_pixels.empty() ? rgb.data() + row_bytes * y0 : band_pixels.data();
+        render(y0, y1, out);
+        if (parallel_io)
+            MPI_File_write_at(file, header_bytes + (MPI_Offset)row_bytes * y0, out, (int)(row_bytes * (y1 - y0)),
+                              MPI_UNSIGNED_CHAR, MPI_STATUS_IGNORE);
+        done++;
+        return (int)(row_bytes * (y1 - y0));
+    };
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    double start = MPI_Wtime();
+    if (rank == 0)
+    {
+        int next = 0, busy = 0;
+        for (int worker = 1; worker < size; worker++)
+        {
+            int band = next < stats.bands ? next++ : STOP_BAND;
+            MPI_Send(&band, 1, MPI_INT, worker, WORK_TAG, MPI_COMM_WORLD);
+            busy += band != STOP_BAND;
+        }
+        while (busy > 0 || next < stats.bands)
+        {
+            int ready = 0;
+            MPI_Status status;
+            // Keep rendering while no worker is waiting; block once the bands are all out
+            if (next < stats.bands)
+                MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &ready, &status);
+            else
+            {
+                MPI_Probe(MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
+                ready = 1;
+            }
+            if (!ready)
+            {
+                render_band(next++);
+                continue;
+            }
+            int band = status.MPI_TAG;
+            int y0 = band_begin(band, band_rows), y1 = band_end(band, band_rows, height);
+            if (parallel_io)
+                MPI_Recv(nullptr, 0, MPI_UNSIGNED_CHAR, status.MPI_SOURCE, band, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            else
+                MPI_Recv(rgb.data() + row_bytes * y0, (int)(row_bytes * (y1 - y0)), MPI_UNSIGNED_CHAR,
+                         status.MPI_SOURCE, band, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            int reply = next < stats.bands ? next++ : STOP_BAND;
+            MPI_Send(&reply, 1, MPI_INT, status.MPI_SOURCE, WORK_TAG, MPI_COMM_WORLD);
+            busy -= reply == STOP_BAND;
+        }
+    }
+    else
+    {
+        for (;;)
+        {
+            int band;
+            MPI_Recv(&band, 1, MPI_INT, 0, WORK_TAG, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            if (band == STOP_BAND)
+                break;
+            int bytes = render_band(band);
+            MPI_Send(band_pixels.data(), parallel_io ? 0 : bytes, MPI_UNSIGNED_CHAR, 0, band, MPI_COMM_WORLD);
+        }
+    }
+
+    if (parallel_io)
+        MPI_File_close(&file);
+    stats.seconds = MPI_Wtime() - start;
+
+    if (rank == 0)
+        stats.bandsPerRank.resize(size);
+    MPI_Gather(&done, 1, MPI_INT, rank == 0 ? stats.bandsPerRank.data() : nullptr, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    return stats;
+}
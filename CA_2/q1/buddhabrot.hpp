@@ -0,0 +1,567 @@
+#pragma once
+
+#include <emmintrin.h> // SSE2: the q1 Makefile builds without -m flags
+#include <stdint.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <omp.h>
+#include "mandelbrot.hpp"
+
+// Orbit-density (Buddhabrot) rendering: sample points c, iterate
+// z = z^2 + c as mandelbrot() does, and for every c that escapes add its whole
+// orbit z_1 .. z_n to a histogram, which is then shown as brightness.
+//
+// Every sample scatters up to MAX_ITERATIONS increments over the image, so
+//
+//   - each thread counts into its own uint32 histogram. After every batch of
+//     samples the histograms are summed pairwise in a tree (log2(threads)
+//     rounds, all threads working on each round) into a uint64 total; the
+//     batch is small enough that the uint32 counters cannot overflow.
+//     BUDDHA_SHARED_ATOMIC counts straight into the total instead, for
+//     comparison.
+//   - the image is symmetric about the real axis (the orbit of conj(c) is the
+//     conjugate orbit), so for a symmetric view the histograms hold only the
+//     rows with imag >= 0 and orbits are folded onto them: half the memory
+//     per thread, and more of it stays in cache. Half the samples are drawn,
+//     all with imag >= 0, and each stands for itself and its conjugate, so
+//     the counts are those of the unfolded image in expectation.
+//   - points are drawn by importance: the sampling domain is cut into a
+//     gridSize^2 grid, and cells near the boundary of the set (probed at their
+//     corners and centre) are drawn farWeight times as often as the others.
+//     A sample adds 1 in a boundary cell and farWeight elsewhere, so the
+//     image is the same in expectation as with uniform sampling. Points in
+//     the main cardioid or the period-2 bulb never escape and are skipped.
+//   - four samples are iterated at once with SSE2, first to find which escape
+//     and then again to plot their orbits; a lane that finishes takes the next
+//     sample right away. The scalar path performs the same float operations,
+//     so both produce identical histograms.
+//
+// Sample s takes its random numbers from a hash of (seed, s), and integer
+// sums do not depend on the order of the additions: the result does not
+// depend on the thread count, the histogram mode or SIMD.
+
+enum BuddhabrotHistograms
+{
+    BUDDHA_PRIVATE,      // per-thread histograms, tree-merged after every batch
+    BUDDHA_SHARED_ATOMIC // one histogram, atomic increments
+};
+
+struct BuddhabrotOptions
+{
+    long long samples = 1 << 21;
+    int maxIterations = MAX_ITERATIONS;
+    int minIterations = 1;        // shorter orbits are not plotted
+    int gridSize = 256;           // importance grid cells per axis
+    int boundaryIterations = 32;  // a probe escaping this late marks its cell as near the boundary
+    int farWeight = 8;            // boundary cells are drawn this many times as often
+    bool importance = true;       // false: uniform sampling
+    bool simd = true;
+    BuddhabrotHistograms histograms = BUDDHA_PRIVATE;
+    long long batchSamples = 1 << 16; // between merges; clamped so uint32 counters cannot overflow
+    unsigned seed = 1;
+};
+
+struct BuddhabrotStats
+{
+    long long samples = 0; // drawn: half of opt.samples for a folded view
+    int fold = 1;          // 2 when every sample also stood for its conjugate
+    long long orbits = 0; // samples that escaped and were plotted
+    long long points = 0; // histogram increments
+    int threads = 1;
+    int merges = 0;
+    double seconds = 0;
+
+    double samplesPerSecond() const { return seconds > 0 ? samples / seconds : 0; }
+};
+
+// Sampling domain, covering the whole set
+const float BUDDHA_RE_MIN = -2.0f, BUDDHA_RE_MAX = 1.0f, BUDDHA_IM_MIN = -1.5f, BUDDHA_IM_MAX = 1.5f;
+
+// Iterations before c escapes |z| > 2, or maxIterations; the loop of
+// mandelbrot_point() on explicit real and imaginary parts
+inline int buddhabrot_escape(float cx, float cy, int maxIterations)
+{
+    float zx = 0, zy = 0;
+    int n = 0;
+    while (n < maxIterations)
+    {
+        float x2 = zx * zx, y2 = zy * zy;
+        if (!(x2 + y2 <= 4.0f))
+            break;
+        float xy = zx * zy;
+        zy = xy + xy + cy;
+        zx = (x2 - y2) + cx;
+        n++;
+    }
+    return n;
+}
+
+// Main cardioid or period-2 bulb: bounded, nothing to plot
+inline bool buddhabrot_in_main_bulbs(float cx, float cy)
+{
+    float x = cx - 0.25f, y2 = cy * cy;
+    float q = x * x + y2;
+    return q * (q + x) <= 0.25f * y2 || (cx + 1) * (cx + 1) + y2 <= 0.0625f;
+}
+
+inline uint64_t buddhabrot_hash(uint64_t x)
+{
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+// Where samples are drawn: the grid cells, boundary cells first. The weight
+// range is laid out in that order, `far` units per boundary cell and one per
+// other cell, so drawing a cell is one multiply and no search.
+struct BuddhabrotSampler
+{
+    int grid = 0;
+    float cellW = 0, cellH = 0;
+    std::vector<uint32_t> cells; // grid indices, the boundaryCells first
+    long boundaryCells = 0;
+    uint32_t far = 1;            // weight of a boundary cell, and increment of a sample from another cell
+
+    uint64_t totalWeight() const { return (uint64_t)boundaryCells * far + (cells.size() - boundaryCells); }
+    double boundaryFraction() const { return cells.empty() ? 0 : (double)boundaryCells / cells.size(); }
+
+    // Point and increment of sample s
+    void draw(unsigned seed, long long s, float &cx, float &cy, uint32_t &inc) const
+    {
+        uint64_t a = buddhabrot_hash(((uint64_t)seed << 40) ^ (2 * (uint64_t)s));
+        uint64_t b = buddhabrot_hash(((uint64_t)seed << 40) ^ (2 * (uint64_t)s + 1));
+        uint64_t r = ((a >> 32) * totalWeight()) >> 32, boundaryWeight = (uint64_t)boundaryCells * far;
+        uint32_t cell = r < boundaryWeight ? cells[r / far] : cells[boundaryCells + (r - boundaryWeight)];
+        float u = (b & 0xffffff) * (1.0f / 16777216.0f), v = (b >> 40) * (1.0f / 16777216.0f);
+        cx = BUDDHA_RE_MIN + ((float)(cell % grid) + u) * cellW;
+        cy = BUDDHA_IM_MIN + ((float)(cell / grid) + v) * cellH;
+        inc = r < boundaryWeight ? 1 : far;
+    }
+};
+
+inline BuddhabrotSampler make_buddhabrot_sampler(const BuddhabrotOptions &opt = BuddhabrotOptions())
+{
+    BuddhabrotSampler sampler;
+    int g = sampler.grid = std::max(1, opt.gridSize);
+    sampler.cellW = (BUDDHA_RE_MAX - BUDDHA_RE_MIN) / g;
+    sampler.cellH = (BUDDHA_IM_MAX - BUDDHA_IM_MIN) / g;
+    std::vector<uint8_t> boundary((size_t)g * g, 0);
+
+    if (opt.importance)
+    {
+        // Escape counts at the (g + 1)^2 cell corners and the g^2 centres
+        std::vector<int> corner((size_t)(g + 1) * (g + 1)), centre((size_t)g * g);
+#pragma omp parallel for schedule(dynamic, 1)
+        for (int y = 0; y <= g; y++)
+            for (int x = 0; x <= g; x++)
+            {
+                float cx = BUDDHA_RE_MIN + x * sampler.cellW, cy = BUDDHA_IM_MIN + y * sampler.cellH;
+                corner[(size_t)y * (g + 1) + x] = buddhabrot_escape(cx, cy, opt.maxIterations);
+                if (x < g && y < g)
+                    centre[(size_t)y * g + x] = buddhabrot_escape(cx + sampler.cellW / 2, cy + sampler.cellH / 2, opt.maxIterations);
+            }
+
+        // Near the boundary: bounded and escaping probes mixed, or a probe escaping late
+        for (int y = 0; y < g; y++)
+            for (int x = 0; x < g; x++)
+            {
+                const int *row = &corner[(size_t)y * (g + 1) + x];
+                int probes[5] = {row[0], row[1], row[g + 1], row[g + 2], centre[(size_t)y * g + x]};
+                int bounded = 0, late = 0;
+                for (int n : probes)
+                {
+                    bounded += n == opt.maxIterations;
+                    late += n >= opt.boundaryIterations && n < opt.maxIterations;
+                }
+                boundary[(size_t)y * g + x] = (bounded > 0 && bounded < 5) || late > 0;
+            }
+        sampler.far = (uint32_t)std::max(1, opt.farWeight);
+    }
+
+    for (int pass = 1; pass >= 0; pass--)
+        for (uint32_t cell = 0; cell < boundary.size(); cell++)
+            if (boundary[cell] == pass)
+                sampler.cells.push_back(cell);
+    sampler.boundaryCells = std::count(boundary.begin(), boundary.end(), 1);
+    return sampler;
+}
+
+// Histogram geometry: rows with imag >= 0 only when folded
+struct BuddhabrotView
+{
+    float xMin, yMin, sx, sy, fw, fh;
+    int width, rows;
+    bool fold;
+};
+
+// Symmetric views with an even row count are folded
+inline bool buddhabrot_folds(int height, float y_min, float y_max)
+{
+    return y_min == -y_max && height % 2 == 0;
+}
+
+inline BuddhabrotView make_buddhabrot_view(int width, int height, float x_min, float x_max, float y_min, float y_max)
+{
+    BuddhabrotView v;
+    v.fold = buddhabrot_folds(height, y_min, y_max);
+    v.width = width;
+    v.rows = v.fold ? height / 2 : height;
+    v.xMin = x_min;
+    v.yMin = v.fold ? 0.0f : y_min;
+    v.sx = width / (x_max - x_min);
+    v.sy = v.rows / (y_max - v.yMin);
+    v.fw = (float)width;
+    v.fh = (float)v.rows;
+    return v;
+}
+
+// Reference: one sample, orbit plotted through plot(index, increment)
+template <class Plot>
+inline void buddhabrot_sample_scalar(float cx, float cy, uint32_t inc, const BuddhabrotView &v, const BuddhabrotOptions &opt,
+                                     Plot &plot, long long &orbits, long long &points)
+{
+    int n = buddhabrot_escape(cx, cy, opt.maxIterations);
+    if (n == opt.maxIterations || n < std::max(1, opt.minIterations))
+        return;
+    orbits++;
+    float zx = 0, zy = 0;
+    for (int k = 0; k < n; k++)
+    {
+        float x2 = zx * zx, y2 = zy * zy, xy = zx * zy;
+        zy = xy + xy + cy;
+        zx = (x2 - y2) + cx;
+        float px = (zx - v.xMin) * v.sx;
+        float py = ((v.fold ? std::fabs(zy) : zy) - v.yMin) * v.sy;
+        if (px >= 0 && px < v.fw && py >= 0 && py < v.fh)
+        {
+            plot((size_t)(int)py * v.width + (int)px, inc);
+            points++;
+        }
+    }
+}
+
+// A sample waiting to be iterated; n is its escape count once known
+struct BuddhabrotPoint
+{
+    float cx, cy;
+    uint32_t inc;
+    int n;
+};
+
+// Samples are handed to the threads BUDDHA_BLOCK at a time
+const int BUDDHA_BLOCK = 256;
+
+// Appends the samples of `in` that escape and are long enough to plot to
+// `out`, with n set. Four samples per SSE2 register, and a lane takes the
+// next sample as soon as its own is done, so short orbits do not wait for
+// long ones.
+inline void buddhabrot_escape_simd(const BuddhabrotPoint *in, size_t count, const BuddhabrotOptions &opt, std::vector<BuddhabrotPoint> &out)
+{
+    alignas(16) float cx[4], cy[4], zx[4], zy[4];
+    alignas(16) int n[4];
+    size_t sample[4], next = 0;
+    int live = 0;
+    auto refill = [&](int l)
+    {
+        cx[l] = cy[l] = zx[l] = zy[l] = 0;
+        n[l] = 0;
+        live &= ~(1 << l);
+        if (next < count)
+        {
+            sample[l] = next;
+            cx[l] = in[next].cx;
+            cy[l] = in[next].cy;
+            live |= 1 << l;
+            next++;
+        }
+    };
+    for (int l = 0; l < 4; l++)
+        refill(l);
+
+    const __m128 four = _mm_set1_ps(4.0f);
+    const __m128i one = _mm_set1_epi32(1), maxN = _mm_set1_epi32(opt.maxIterations);
+    const int minN = std::max(1, opt.minIterations);
+    __m128 vcx = _mm_load_ps(cx), vcy = _mm_load_ps(cy), vzx = _mm_load_ps(zx), vzy = _mm_load_ps(zy);
+    __m128i vn = _mm_load_si128(reinterpret_cast<const __m128i *>(n));
+    while (live)
+    {
+        __m128 x2 = _mm_mul_ps(vzx, vzx), y2 = _mm_mul_ps(vzy, vzy);
+        __m128 done = _mm_or_ps(_mm_cmpnle_ps(_mm_add_ps(x2, y2), four), _mm_castsi128_ps(_mm_cmpeq_epi32(vn, maxN)));
+        int finished = _mm_movemask_ps(done) & live;
+        if (finished)
+        {
+            _mm_store_ps(cx, vcx), _mm_store_ps(cy, vcy), _mm_store_ps(zx, vzx), _mm_store_ps(zy, vzy);
+            _mm_store_si128(reinterpret_cast<__m128i *>(n), vn);
+            for (; finished; finished &= finished - 1)
+            {
+                int l = __builtin_ctz(finished);
+                if (n[l] < opt.maxIterations && n[l] >= minN)
+                {
+                    out.push_back(in[sample[l]]);
+                    out.back().n = n[l];
+                }
+                refill(l);
+            }
+            vcx = _mm_load_ps(cx), vcy = _mm_load_ps(cy), vzx = _mm_load_ps(zx), vzy = _mm_load_ps(zy);
+            vn = _mm_load_si128(reinterpret_cast<const __m128i *>(n));
+            continue;
+        }
+        __m128 xy = _mm_mul_ps(vzx, vzy);
+        vzy = _mm_add_ps(_mm_add_ps(xy, xy), vcy);
+        vzx = _mm_add_ps(_mm_sub_ps(x2, y2), vcx);
+        vn = _mm_add_epi32(vn, one);
+    }
+}
+
+// Plots the orbits z_1 .. z_n of escaping samples, four lanes at a time with
+// refills as in buddhabrot_escape_simd
+template <class Plot>
+inline void buddhabrot_plot_simd(const BuddhabrotPoint *in, size_t count, const BuddhabrotView &v, Plot &plot, long long &points)
+{
+    alignas(16) float cx[4], cy[4], zx[4], zy[4];
+    alignas(16) int k[4], n[4], ix[4], iy[4];
+    uint32_t inc[4];
+    size_t next = 0;
+    int live = 0;
+    auto refill = [&](int l)
+    {
+        cx[l] = cy[l] = zx[l] = zy[l] = 0;
+        k[l] = n[l] = 0;
+        live &= ~(1 << l);
+        if (next < count)
+        {
+            cx[l] = in[next].cx;
+            cy[l] = in[next].cy;
+            n[l] = in[next].n;
+            inc[l] = in[next].inc;
+            live |= 1 << l;
+            next++;
+        }
+    };
+    for (int l = 0; l < 4; l++)
+        refill(l);
+
+    const __m128 sign = _mm_set1_ps(-0.0f), zero = _mm_setzero_ps();
+    const __m128 xMin = _mm_set1_ps(v.xMin), yMin = _mm_set1_ps(v.yMin), sx = _mm_set1_ps(v.sx), sy = _mm_set1_ps(v.sy);
+    const __m128 fw = _mm_set1_ps(v.fw), fh = _mm_set1_ps(v.fh);
+    const __m128i one = _mm_set1_epi32(1);
+    __m128 vcx = _mm_load_ps(cx), vcy = _mm_load_ps(cy), vzx = _mm_load_ps(zx), vzy = _mm_load_ps(zy);
+    __m128i vk = _mm_load_si128(reinterpret_cast<const __m128i *>(k)), vn = _mm_load_si128(reinterpret_cast<const __m128i *>(n));
+    while (live)
+    {
+        __m128 x2 = _mm_mul_ps(vzx, vzx), y2 = _mm_mul_ps(vzy, vzy), xy = _mm_mul_ps(vzx, vzy);
+        vzy = _mm_add_ps(_mm_add_ps(xy, xy), vcy);
+        vzx = _mm_add_ps(_mm_sub_ps(x2, y2), vcx);
+        vk = _mm_add_epi32(vk, one);
+
+        __m128 px = _mm_mul_ps(_mm_sub_ps(vzx, xMin), sx);
+        __m128 py = _mm_mul_ps(_mm_sub_ps(v.fold ? _mm_andnot_ps(sign, vzy) : vzy, yMin), sy);
+        __m128 in_view = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(px, zero), _mm_cmplt_ps(px, fw)),
+                                    _mm_and_ps(_mm_cmpge_ps(py, zero), _mm_cmplt_ps(py, fh)));
+        int mask = _mm_movemask_ps(in_view) & live;
+        if (mask)
+        {
+            _mm_store_si128(reinterpret_cast<__m128i *>(ix), _mm_cvttps_epi32(px));
+            _mm_store_si128(reinterpret_cast<__m128i *>(iy), _mm_cvttps_epi32(py));
+            for (; mask; mask &= mask - 1)
+            {
+                int l = __builtin_ctz(mask);
+                plot((size_t)iy[l] * v.width + ix[l], inc[l]);
+                points++;
+            }
+        }
+
+        int finished = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(vk, vn))) & live;
+        if (finished)
+        {
+            _mm_store_ps(cx, vcx), _mm_store_ps(cy, vcy), _mm_store_ps(zx, vzx), _mm_store_ps(zy, vzy);
+            _mm_store_si128(reinterpret_cast<__m128i *>(k), vk);
+            _mm_store_si128(reinterpret_cast<__m128i *>(n), vn);
+            for (; finished; finished &= finished - 1)
+                refill(__builtin_ctz(finished));
+            vcx = _mm_load_ps(cx), vcy = _mm_load_ps(cy), vzx = _mm_load_ps(zx), vzy = _mm_load_ps(zy);
+            vk = _mm_load_si128(reinterpret_cast<const __m128i *>(k));
+            vn = _mm_load_si128(reinterpret_cast<const __m128i *>(n));
+        }
+    }
+}
+
+// Samples [s0, s1): drawn, the ones in the main bulbs dropped, then iterated
+// and plotted. todo and escaping are the caller's scratch.
+template <class Plot>
+inline void buddhabrot_block(long long s0, long long s1, const BuddhabrotSampler &sampler, const BuddhabrotView &v,
+                             const BuddhabrotOptions &opt, Plot &plot, long long &orbits, long long &points,
+                             std::vector<BuddhabrotPoint> &todo, std::vector<BuddhabrotPoint> &escaping)
+{
+    todo.clear();
+    for (long long s = s0; s < s1; s++)
+    {
+        BuddhabrotPoint p;
+        sampler.draw(opt.seed, s, p.cx, p.cy, p.inc);
+        if (v.fold)
+            p.cy = std::fabs(p.cy); // stands for c and conj(c)
+        if (!buddhabrot_in_main_bulbs(p.cx, p.cy))
+            todo.push_back(p);
+    }
+    if (!opt.simd)
+    {
+        for (const BuddhabrotPoint &p : todo)
+            buddhabrot_sample_scalar(p.cx, p.cy, p.inc, v, opt, plot, orbits, points);
+        return;
+    }
+    escaping.clear();
+    buddhabrot_escape_simd(todo.data(), todo.size(), opt, escaping);
+    orbits += escaping.size();
+    buddhabrot_plot_simd(escaping.data(), escaping.size(), v, plot, points);
+}
+
+// dst += src, src = 0
+inline void buddhabrot_add_and_clear(uint32_t *dst, uint32_t *src, size_t n)
+{
+    size_t i = 0;
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_add_epi32(a, b));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(src + i), zero);
+    }
+    for (; i < n; i++)
+    {
+        dst[i] += src[i];
+        src[i] = 0;
+    }
+}
+
+// Orbit-density histogram of the view into hist (width * height counts, row
+// 0 at y_min), across the OpenMP threads
+inline BuddhabrotStats generate_buddhabrot(int width, int height, float x_min, float x_max, float y_min, float y_max,
+                                           std::vector<uint64_t> &hist, const BuddhabrotSampler &sampler,
+                                           const BuddhabrotOptions &opt = BuddhabrotOptions())
+{
+    BuddhabrotStats stats;
+    hist.assign((size_t)width * height, 0);
+    if (width <= 0 || height <= 0 || opt.samples <= 0 || sampler.totalWeight() == 0)
+        return stats;
+
+    const BuddhabrotView v = make_buddhabrot_view(width, height, x_min, x_max, y_min, y_max);
+    const size_t cells = (size_t)v.width * v.rows;
+    std::vector<uint64_t> total(cells, 0);
+
+    // A batch adds at most maxIterations * increment per sample to any counter
+    long long limit = (long long)(UINT32_MAX / ((uint64_t)std::max(1, opt.maxIterations) * sampler.far));
+    long long batchBlocks = std::max(1LL, std::min(opt.batchSamples, limit) / BUDDHA_BLOCK);
+    const long long drawn = v.fold ? (opt.samples + 1) / 2 : opt.samples;
+    long long blocks = (drawn + BUDDHA_BLOCK - 1) / BUDDHA_BLOCK;
+
+    std::vector<std::vector<uint32_t>> priv;
+    const size_t chunk = 16384;
+    const long long chunks = (long long)((cells + chunk - 1) / chunk);
+    long long orbits = 0, points = 0;
+    double start = omp_get_wtime();
+
+#pragma omp parallel reduction(+ : orbits, points)
+    {
+        int t = omp_get_thread_num(), threads = omp_get_num_threads();
+        const bool isPrivate = opt.histograms == BUDDHA_PRIVATE;
+#pragma omp single
+        {
+            stats.threads = threads;
+            if (isPrivate)
+                priv.resize(threads);
+        }
+        // Each thread's histogram on pages it touched first
+        if (isPrivate)
+            priv[t].assign(cells, 0);
+#pragma omp barrier
+
+        uint32_t *own = isPrivate ? priv[t].data() : nullptr;
+        auto plotPrivate = [own](size_t index, uint32_t inc)
+        { own[index] += inc; };
+        auto plotShared = [&total](size_t index, uint32_t inc)
+        {
+#pragma omp atomic
+            total[index] += inc;
+        };
+
+        std::vector<BuddhabrotPoint> todo, escaping;
+        for (long long b0 = 0; b0 < blocks; b0 += batchBlocks)
+        {
+            long long b1 = std::min(blocks, b0 + batchBlocks);
+#pragma omp for schedule(dynamic, 1)
+            for (long long b = b0; b < b1; b++)
+            {
+                long long s0 = b * BUDDHA_BLOCK, s1 = std::min(drawn, s0 + BUDDHA_BLOCK);
+                if (isPrivate)
+                    buddhabrot_block(s0, s1, sampler, v, opt, plotPrivate, orbits, points, todo, escaping);
+                else
+                    buddhabrot_block(s0, s1, sampler, v, opt, plotShared, orbits, points, todo, escaping);
+            }
+            if (!isPrivate)
+                continue;
+
+            // Tree merge: after the round of `step`, histogram d holds d .. d + 2 * step - 1
+            for (int step = 1; step < threads; step *= 2)
+            {
+#pragma omp for schedule(static)
+                for (long long c = 0; c < chunks; c++)
+                {
+                    size_t begin = (size_t)c * chunk, len = std::min(chunk, cells - begin);
+                    for (int d = 0; d + step < threads; d += 2 * step)
+                        buddhabrot_add_and_clear(priv[d].data() + begin, priv[d + step].data() + begin, len);
+                }
+            }
+#pragma omp for schedule(static)
+            for (long long c = 0; c < chunks; c++)
+            {
+                size_t begin = (size_t)c * chunk, end = std::min(cells, begin + chunk);
+                uint32_t *root = priv[0].data();
+                for (size_t i = begin; i < end; i++)
+                {
+                    total[i] += root[i];
+                    root[i] = 0;
+                }
+            }
+#pragma omp single nowait
+            stats.merges++;
+        }
+    }
+
+    stats.seconds = omp_get_wtime() - start;
+    stats.samples = drawn;
+    stats.fold = v.fold ? 2 : 1;
+    stats.orbits = orbits;
+    stats.points = points;
+
+    // Unfold: image rows below the axis mirror the ones above
+    for (int y = 0; y < height; y++)
+    {
+        int row = !v.fold ? y : y >= v.rows ? y - v.rows : v.rows - 1 - y;
+        std::copy(total.begin() + (size_t)row * width, total.begin() + (size_t)(row + 1) * width, hist.begin() + (size_t)y * width);
+    }
+    return stats;
+}
+
+inline BuddhabrotStats generate_buddhabrot(int width, int height, float x_min, float x_max, float y_min, float y_max,
+                                           std::vector<uint64_t> &hist, const BuddhabrotOptions &opt = BuddhabrotOptions())
+{
+    return generate_buddhabrot(width, height, x_min, x_max, y_min, y_max, hist, make_buddhabrot_sampler(opt), opt);
+}
+
+// Brightness sqrt(count / max), slightly warm
+inline void buddhabrot_to_rgb(const std::vector<uint64_t> &hist, PixelBuffer &rgb)
+{
+    rgb.resize(3 * hist.size());
+    uint64_t peak = hist.empty() ? 0 : *std::max_element(hist.begin(), hist.end());
+    double scale = peak ? 1.0 / peak : 0;
+    for (size_t i = 0; i < hist.size(); i++)
+    {
+        double t = std::sqrt(hist[i] * scale);
+        rgb[3 * i] = (unsigned char)(255 * t);
+        rgb[3 * i + 1] = (unsigned char)(255 * std::pow(t, 1.2));
+        rgb[3 * i + 2] = (unsigned char)(255 * std::pow(t, 1.5));
+    }
+}
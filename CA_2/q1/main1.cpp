@@ -1,106 +1,20 @@
 #include <iostream>
 #include <vector>
 #include <complex>
+#include <cmath>
+#include <cstdlib>
 #include <omp.h>
 #include <string>
+#include "mandelbrot.hpp"
+#include "buddhabrot.hpp"
+#include "../animation.hpp"
+#include "../../bench/tuning.hpp"
+#ifdef PP_WITH_MPI
+#include "../mpi_hybrid.hpp"
+#endif
 
 using namespace std;
 
-const int MAX_ITERATIONS = 1000;
-
-// Color mapping function
-void apply_color(int iteration, int max_iteration, unsigned char &r, unsigned char &g, unsigned char &b)
-{
-    if (iteration == max_iteration)
-    {
-        r = g = b = 255;
-    }
-    else
-    {
-        float t = (float)iteration / max_iteration;
-        r = (unsigned char)(9 * (1 - t) * t * t * t * 255);
-        g = (unsigned char)(15 * (1 - t) * (1 - t) * t * t * 255);
-        b = (unsigned char)(8.5 * (1 - t) * (1 - t) * (1 - t) * t * 255);
-    }
-}
-
-// Mandelbrot computation for a single point
-int mandelbrot(int width, int height, float x_min, float x_max, float y_min, float y_max, int x, int y)
-{
-    float real = ((float)x / width) * (x_max - x_min) + x_min;
-    float imag = ((float)y / height) * (y_max - y_min) + y_min;
-
-    complex<float> point(real, imag);
-    //complex<float> point(0, 16);
-
-    complex<float> z(0, 0);
-
-    int iteration = 0;
-    while (abs(z) <= 2 && iteration < MAX_ITERATIONS)
-    {
-        z = z * z + point;
-        iteration++;
-    }
-    return iteration;
-}
-
-// Serial Mandelbrot generation
-void generate_mandelbrot_serial(int width, int height, float x_min, float x_max, float y_min, float y_max, vector<unsigned char> &rgb)
-{
-    for (int y = 0; y < height; y++)
-    {
-        for (int x = 0; x < width; x++)
-        {
-            int mandelbrot_value = mandelbrot(width, height, x_min, x_max, y_min, y_max, x, y);
-
-            unsigned char r, g, b;
-            apply_color(mandelbrot_value, MAX_ITERATIONS, r, g, b);
-
-            int k = 3 * (y * width + x);
-            rgb[k] = r;
-            rgb[k + 1] = g;
-            rgb[k + 2] = b;
-        }
-    }
-}
-
-// Parallel Mandelbrot generation using OpenMP
-void generate_mandelbrot_parallel(int width, int height, float x_min, float x_max, float y_min, float y_max, vector<unsigned char> &rgb)
-{
-#pragma omp parallel for schedule(dynamic)
-    for (int y = 0; y < height; y++)
-    {
-        for (int x = 0; x < width; x++)
-        {
-            int mandelbrot_value = mandelbrot(width, height, x_min, x_max, y_min, y_max, x, y);
-
-            unsigned char r, g, b;
-            apply_color(mandelbrot_value, MAX_ITERATIONS, r, g, b);
-
-            int k = 3 * (y * width + x);
-            rgb[k] = r;
-            rgb[k + 1] = g;
-            rgb[k + 2] = b;
-        }
-    }
-}
-
-// Write RGB data to a PPM file
-void write_ppm_image(int width, int height, const vector<unsigned char> &rgb, const string &filename)
-{
-    FILE *file_unit = fopen(filename.c_str(), "wb");
-
-    if (!file_unit)
-    {
-        cerr << "Error opening file " << filename << " for writing.\n";
-        return;
-    }
-
-    fprintf(file_unit, "P6\n%d %d\n255\n", width, height);
-    fwrite(rgb.data(), sizeof(unsigned char), 3 * width * height, file_unit);
-    fclose(file_unit);
-}
-
 // int main()
 // {
 //     int width = 1000, height = 1000;
@@ -130,12 +44,153 @@ void write_ppm_image(int width, int height, const vector<unsigned char> &rgb, co
 
 //     return 0;
 // }
-int main()
+// Hybrid MPI + OpenMP render of the full set: bands of band_rows rows are
+// handed out by rank 0 and gathered into mandelbrot_mpi.ppm, or written by
+// every rank into out_filename with MPI-IO when one is given
+static int run_mpi(int argc, char **argv, int width, int height, float x_min, float x_max, float y_min, float y_max)
+{
+#ifdef PP_WITH_MPI
+    if (!mpi_init(argc, argv))
+        return 1;
+    int band_rows = argc > 2 ? atoi(argv[2]) : 8;
+    string out_filename = argc > 3 ? argv[3] : "";
+    bool root = mpi_rank() == 0;
+
+    PixelBuffer rgb;
+    MPIRenderStats stats = mpi_render_bands(width, height, band_rows, rgb, [&](int y0, int y1, unsigned char *out)
+                                            { generate_mandelbrot_rows(width, height, x_min, x_max, y_min, y_max, y0, y1, out); },
+                                            out_filename);
+    if (root && stats.bands > 0)
+    {
+        cout << "MPI render: " << stats.ranks << " ranks x " << omp_get_max_threads() << " threads, "
+             << stats.bands << " bands in " << stats.seconds << " seconds ("
+             << (double)width * height / stats.seconds / 1e6 << " Mpixel/s)\n";
+        cout << "  bands per rank:";
+        for (int bands : stats.bandsPerRank)
+            cout << " " << bands;
+        cout << "\n";
+        if (out_filename.empty())
+        {
+            out_filename = "mandelbrot_mpi.ppm";
+            write_ppm_image(width, height, rgb, out_filename);
+        }
+        cout << "Saved image: " << out_filename << (argc > 3 ? " (MPI-IO)" : "") << "\n";
+    }
+    MPI_Finalize();
+    return stats.bands > 0 ? 0 : 1;
+#else
+    (void)argc, (void)width, (void)height, (void)x_min, (void)x_max, (void)y_min, (void)y_max;
+    cerr << argv[0] << " was built without MPI; build it with `make mpi` (or the ca2_mandelbrot_mpi target).\n";
+    return 1;
+#endif
+}
+
+// Buddhabrot of the full view: scalar reference, then the SIMD renderer over
+// 1, 2, 4, ... threads with private histograms and with a shared atomic one
+static int run_buddhabrot(int argc, char **argv, int width, int height, float x_min, float x_max, float y_min, float y_max)
+{
+    BuddhabrotOptions opt;
+    if (argc > 2)
+        opt.samples = atoll(argv[2]);
+    string filename = argc > 3 ? argv[3] : "buddhabrot.ppm";
+    if (opt.samples <= 0)
+    {
+        cerr << "Usage: " << argv[0] << " --buddhabrot [samples] [out.ppm]\n";
+        return 1;
+    }
+
+    double start_time = omp_get_wtime();
+    BuddhabrotSampler sampler = make_buddhabrot_sampler(opt);
+    cout << "Importance grid: " << 100 * sampler.boundaryFraction() << "% of the cells near the boundary, built in "
+         << omp_get_wtime() - start_time << " seconds\n";
+
+    vector<uint64_t> reference, hist;
+    int max_threads = omp_get_max_threads();
+    BuddhabrotOptions serial = opt;
+    serial.simd = false;
+    omp_set_num_threads(1);
+    BuddhabrotStats stats = generate_buddhabrot(width, height, x_min, x_max, y_min, y_max, reference, sampler, serial);
+    double serial_rate = stats.samplesPerSecond();
+    cout << "Serial: " << serial_rate << " samples/sec (" << stats.orbits << " orbits, " << stats.points << " points)\n";
+    if (stats.fold > 1)
+        cout << "Symmetric view: " << stats.samples << " samples drawn, each also standing for its conjugate ("
+             << stats.fold << "x the samples/sec over the whole domain)\n";
+
+    for (BuddhabrotHistograms mode : {BUDDHA_PRIVATE, BUDDHA_SHARED_ATOMIC})
+    {
+        BuddhabrotOptions simd = opt;
+        simd.histograms = mode;
+        double one_thread = 0;
+        for (int threads = 1;; threads = min(2 * threads, max_threads))
+        {
+            omp_set_num_threads(threads);
+            stats = generate_buddhabrot(width, height, x_min, x_max, y_min, y_max, hist, sampler, simd);
+            if (threads == 1)
+                one_thread = stats.samplesPerSecond();
+            cout << (mode == BUDDHA_PRIVATE ? "SIMD, private histograms" : "SIMD, shared atomic histogram") << ", "
+                 << threads << " threads: " << stats.samplesPerSecond() << " samples/sec, speedup "
+                 << stats.samplesPerSecond() / serial_rate << " over serial, " << stats.samplesPerSecond() / one_thread
+                 << " over 1 thread" << (mode == BUDDHA_PRIVATE ? ", " + to_string(stats.merges) + " merges" : "")
+                 << (hist == reference ? "" : " (MISMATCH with serial)") << "\n";
+            if (threads == max_threads)
+                break;
+        }
+    }
+    omp_set_num_threads(max_threads);
+
+    PixelBuffer rgb;
+    buddhabrot_to_rgb(hist, rgb);
+    write_ppm_image(width, height, rgb, filename);
+    cout << "Saved Buddhabrot image: " << filename << "\n";
+    return 0;
+}
+
+// Usage: main1                               3 zoom steps, serial / parallel PPMs
+//        main1 --aa [samples]                 the same plus adaptive anti-aliased PPMs (default 16 samples)
+//        main1 --animate [frames] [out.y4m]   zoom video, rendering overlapped with encoding ("-" = stdout)
+//        main1 --buddhabrot [samples] [out.ppm] orbit-density render, samples/sec over thread counts
+//        mpirun -np N main1_mpi --mpi [band_rows] [out.ppm]
+//                                             bands across MPI ranks, gathered to rank 0 or written with MPI-IO
+int main(int argc, char **argv)
 {
     int width = 1000, height = 1000;
     float x_min = -2.0, x_max = 1.0, y_min = -1.5, y_max = 1.5;
 
-    vector<unsigned char> rgb(width * height * 3);
+    if (argc > 1 && string(argv[1]) == "--mpi")
+        return run_mpi(argc, argv, width, height, x_min, x_max, y_min, y_max);
+    if (argc > 1 && string(argv[1]) == "--buddhabrot")
+        return run_buddhabrot(argc, argv, width, height, x_min, x_max, y_min, y_max);
+
+    bool animate = argc > 1 && string(argv[1]) == "--animate";
+    int animation_frames = animate && argc > 2 ? atoi(argv[2]) : 300;
+    string video_filename = animate && argc > 3 ? argv[3] : "mandelbrot_zoom.y4m";
+    bool antialias = argc > 1 && string(argv[1]) == "--aa";
+    AAOptions aa_options;
+    if (antialias && argc > 2)
+        aa_options.samples = atoi(argv[2]);
+    if (animation_frames <= 0 || aa_options.samples <= 0)
+    {
+        cerr << "Usage: " << argv[0] << " [--aa [samples] | --animate [frames] [out.y4m] | --buddhabrot [samples] [out.ppm] | --mpi [band_rows] [out.ppm]]\n";
+        return 1;
+    }
+    // The video may be going to stdout
+    ostream &log = animate && video_filename == "-" ? cerr : cout;
+
+    // Pages are placed by the OpenMP threads' first touch, not by the main thread
+    PixelBuffer rgb(width * height * 3);
+    firstTouchRows(rgb, 3 * width, height);
+
+    // Thread count and row chunk: tuned on the first run on this host, then read from the tuning cache
+    TuningCache cache;
+    TuneSpace space;
+    space.threads = tuneThreadCandidates();
+    space.chunks = tuneChunkCandidates(height, space.threads.front());
+    TuneConfig tuned = autotune(cache, "mandelbrot", (double)width * height, space, [&](const TuneConfig &c)
+                                {
+        omp_set_num_threads(c.threads);
+        generate_mandelbrot_parallel(width, height, x_min, x_max, y_min, y_max, rgb, c.chunk); });
+    omp_set_num_threads(tuned.threads);
+    log << "Tuned configuration: " << tuned.threads << " threads, chunk " << tuned.chunk << "\n";
 
     // Zoom parameters
     float zoom_factor =0.8; // f < 1 = zoom in | f > 1 = zoom out
@@ -143,6 +198,28 @@ int main()
     float center_y = 0.0;    // Center of zoom (imaginary part)
     int zoom_iterations = 3;
 
+    if (animate)
+    {
+        // Smaller steps than the stills, for a smooth 30 fps zoom; bounds are
+        // recomputed per frame, so frames do not depend on each other
+        const float frame_zoom = 0.98f;
+        const float x_range0 = x_max - x_min, y_range0 = y_max - y_min;
+        AnimationStats anim = render_animation(video_filename, width, height, 30, animation_frames, [&](int frame, PixelBuffer &pixels)
+                                               {
+            float scale = pow(frame_zoom, frame + 1);
+            float x_range = x_range0 * scale, y_range = y_range0 * scale;
+            generate_mandelbrot_parallel(width, height, center_x - x_range / 2, center_x + x_range / 2,
+                                         center_y - y_range / 2, center_y + y_range / 2, pixels, tuned.chunk); });
+        if (anim.frames == 0)
+            return 1;
+        log << "Animation: " << anim.frames << " frames in " << anim.seconds << " seconds, "
+            << anim.framesPerSecond() << " frames/sec end to end\n";
+        log << "  render " << anim.renderSeconds << " s, encode " << anim.encodeSeconds << " s, "
+            << 100 * anim.overlap() << "% saved by overlapping them\n";
+        log << "Saved video: " << video_filename << "\n";
+        return 0;
+    }
+
     for (int i = 0; i < zoom_iterations; ++i)
     {
         cout << "Zoom iteration " << i + 1 << "...\n";
@@ -168,7 +245,7 @@ int main()
 
         // Parallel execution
         start_time = omp_get_wtime();
-        generate_mandelbrot_parallel(width, height, x_min, x_max, y_min, y_max, rgb);
+        generate_mandelbrot_parallel(width, height, x_min, x_max, y_min, y_max, rgb, tuned.chunk);
         end_time = omp_get_wtime();
         double parallel_time = end_time - start_time;
         cout << "Parallel execution time: " << parallel_time << " seconds\n";
@@ -180,6 +257,21 @@ int main()
         // Compute speedup
         double speedup = serial_time / parallel_time;
         cout << "Speedup (Serial / Parallel): " << speedup << "\n";
+
+        if (!antialias)
+            continue;
+
+        // Adaptive anti-aliasing: jittered subsamples on edge pixels only
+        start_time = omp_get_wtime();
+        AAStats aa = generate_mandelbrot_antialiased(width, height, x_min, x_max, y_min, y_max, rgb, aa_options);
+        end_time = omp_get_wtime();
+        cout << "Anti-aliased execution time: " << end_time - start_time << " seconds ("
+             << 100 * aa.edgeFraction() << "% edge pixels, " << 100 * aa.costVersusFullSSAA(aa_options.samples)
+             << "% of the samples of " << aa_options.samples << "x SSAA)\n";
+
+        string aa_filename = "mandelbrot_aa_zoom_" + to_string(i + 1) + ".ppm";
+        write_ppm_image(width, height, rgb, aa_filename);
+        cout << "Saved anti-aliased image: " << aa_filename << "\n";
     }
 
     return 0;
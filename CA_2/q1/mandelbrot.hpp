@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstdio>
+#include <iostream>
+#include <vector>
+#include <complex>
+#include <string>
+#include "../../common/numa_affinity.hpp"
+#include "../../common/perf_counters.hpp"
+#include "../antialias.hpp"
+
+const int MAX_ITERATIONS = 1000;
+
+// Roughly: complex square and add (8) plus |z| (4) per iteration, for the perf report
+const double MANDELBROT_FLOPS_PER_ITERATION = 12;
+
+// Color mapping function
+inline void apply_color(int iteration, int max_iteration, unsigned char &r, unsigned char &g, unsigned char &b)
+{
+    if (iteration == max_iteration)
+    {
+        r = g = b = 255;
+    }
+    else
+    {
+        float t = (float)iteration / max_iteration;
+        r = (unsigned char)(9 * (1 - t) * t * t * t * 255);
+        g = (unsigned char)(15 * (1 - t) * (1 - t) * t * t * 255);
+        b = (unsigned char)(8.5 * (1 - t) * (1 - t) * (1 - t) * t * 255);
+    }
+}
+
+// Iteration count of c = real + imag * i
+inline int mandelbrot_point(float real, float imag)
+{
+    std::complex<float> point(real, imag);
+    //std::complex<float> point(0, 16);
+
+    std::complex<float> z(0, 0);
+
+    int iteration = 0;
+    while (abs(z) <= 2 && iteration < MAX_ITERATIONS)
+    {
+        z = z * z + point;
+        iteration++;
+    }
+    return iteration;
+}
+
+// Mandelbrot computation for a single point
+inline int mandelbrot(int width, int height, float x_min, float x_max, float y_min, float y_max, int x, int y)
+{
+    float real = ((float)x / width) * (x_max - x_min) + x_min;
+    float imag = ((float)y / height) * (y_max - y_min) + y_min;
+    return mandelbrot_point(real, imag);
+}
+
+// Serial Mandelbrot generation
+inline void generate_mandelbrot_serial(int width, int height, float x_min, float x_max, float y_min, float y_max, PixelBuffer &rgb)
+{
+    PERF_REGION("generate_mandelbrot_serial", 3.0 * width * height, 0);
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            int mandelbrot_value = mandelbrot(width, height, x_min, x_max, y_min, y_max, x, y);
+
+            unsigned char r, g, b;
+            apply_color(mandelbrot_value, MAX_ITERATIONS, r, g, b);
+            PERF_REGION_ADD(0, MANDELBROT_FLOPS_PER_ITERATION * mandelbrot_value);
+
+            int k = 3 * (y * width + x);
+            rgb[k] = r;
+            rgb[k + 1] = g;
+            rgb[k + 2] = b;
+        }
+    }
+}
+
+// Rows [y0, y1) of the image into out (3 * width bytes per row, row y0
+// first), across the OpenMP threads `chunk` rows at a time
+inline void generate_mandelbrot_rows(int width, int height, float x_min, float x_max, float y_min, float y_max,
+                                     int y0, int y1, unsigned char *out, int chunk = 1)
+{
+    // One perf region per thread, so the report shows the load balance
+#pragma omp parallel
+    {
+        PERF_REGION("generate_mandelbrot_parallel", 0, 0);
+#pragma omp for schedule(dynamic, chunk)
+        for (int y = y0; y < y1; y++)
+        {
+            for (int x = 0; x < width; x++)
+            {
+                int mandelbrot_value = mandelbrot(width, height, x_min, x_max, y_min, y_max, x, y);
+
+                unsigned char r, g, b;
+                apply_color(mandelbrot_value, MAX_ITERATIONS, r, g, b);
+                PERF_REGION_ADD(3.0, MANDELBROT_FLOPS_PER_ITERATION * mandelbrot_value);
+
+                size_t k = 3 * ((size_t)(y - y0) * width + x);
+                out[k] = r;
+                out[k + 1] = g;
+                out[k + 2] = b;
+            }
+        }
+    }
+}
+
+// Parallel Mandelbrot generation using OpenMP; rows are handed out `chunk` at a time
+inline void generate_mandelbrot_parallel(int width, int height, float x_min, float x_max, float y_min, float y_max, PixelBuffer &rgb, int chunk = 1)
+{
+    generate_mandelbrot_rows(width, height, x_min, x_max, y_min, y_max, 0, height, rgb.data(), chunk);
+}
+
+// Anti-aliased render: one sample per pixel, plus opt.samples jittered
+// subsamples on edge pixels only (../antialias.hpp)
+inline AAStats generate_mandelbrot_antialiased(int width, int height, float x_min, float x_max, float y_min, float y_max, PixelBuffer &rgb, const AAOptions &opt = AAOptions())
+{
+    return render_antialiased(
+        width, height, rgb, opt,
+        [&](float px, float py)
+        { return mandelbrot_point((px / width) * (x_max - x_min) + x_min, (py / height) * (y_max - y_min) + y_min); },
+        [](int iteration, unsigned char &r, unsigned char &g, unsigned char &b)
+        { apply_color(iteration, MAX_ITERATIONS, r, g, b); });
+}
+
+// Write RGB data to a PPM file
+inline void write_ppm_image(int width, int height, const PixelBuffer &rgb, const std::string &filename)
+{
+    FILE *file_unit = fopen(filename.c_str(), "wb");
+
+    if (!file_unit)
+    {
+        std::cerr << "Error opening file " << filename << " for writing.\n";
+        return;
+    }
+
+    fprintf(file_unit, "P6\n%d %d\n255\n", width, height);
+    fwrite(rgb.data(), sizeof(unsigned char), 3 * width * height, file_unit);
+    fclose(file_unit);
+}
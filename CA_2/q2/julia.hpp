@@ -0,0 +1,156 @@
+#pragma once
+
+#include <cstdio>
+#include <iostream>
+#include <vector>
+#include <string>
+#include "../../common/numa_affinity.hpp"
+#include "../../common/perf_counters.hpp"
+#include "../antialias.hpp"
+
+// Namespaced because the Mandelbrot program (CA_2/q1) defines the same
+// helper names (MAX_ITERATIONS, apply_color, write_ppm_image)
+namespace julia_set
+{
+
+const float constant_real = 0.355;
+const float constant_imag = 0.355;
+const int MAX_ITERATIONS = 1000;
+
+// |z|^2 test (3), new real part (3) and imaginary part (3) per iteration, for the perf report
+const double JULIA_FLOPS_PER_ITERATION = 9;
+
+inline void apply_color(int iteration, int max_iteration, unsigned char &r, unsigned char &g, unsigned char &b)
+{
+    if (iteration == max_iteration)
+    {
+        r = g = b = 0;
+    }
+    else
+    {
+        float t = (float)iteration / max_iteration;
+        r = (unsigned char)(9 * (1 - t) * t * t * t * 255);
+        g = (unsigned char)(15 * (1 - t) * (1 - t) * t * t * 255);
+        b = (unsigned char)(8.5 * (1 - t) * (1 - t) * (1 - t) * t * 255);
+    }
+}
+
+// Iteration count of z0 = real_coord + imag_coord * i
+inline int julia_point(float real_coord, float imag_coord)
+{
+    float real_part, imag_part;
+    float temp;
+
+    real_part = real_coord;
+    imag_part = imag_coord;
+
+    for (int iteration = 0; iteration < MAX_ITERATIONS; iteration++)
+    {
+        if (real_part * real_part + imag_part * imag_part > 4)
+        {
+            return iteration;
+        }
+        temp = real_part * real_part - imag_part * imag_part + constant_real;
+        imag_part = 2 * real_part * imag_part + constant_imag;
+        real_part = temp;
+    }
+
+    return MAX_ITERATIONS;
+}
+
+// Plane coordinate of pixel position x; 0 .. width - 1 spans x_min .. x_max
+inline float julia_coord(float x, int width, float x_min, float x_max)
+{
+    return (((float)(width - 1) - x) * x_min + x * x_max) / (float)(width - 1);
+}
+
+inline int julia(int width, int height, float x_min, float x_max, float y_min, float y_max, int x, int y)
+{
+    return julia_point(julia_coord((float)x, width, x_min, x_max), julia_coord((float)y, height, y_min, y_max));
+}
+
+// Rows are handed out `chunk` at a time
+inline void generate_julia_set_parallel(int width, int height, float x_min, float x_max, float y_min, float y_max, PixelBuffer &rgb, int chunk = 1)
+{
+    int julia_value;
+    int k;
+
+    // One perf region per thread, so the report shows the load balance
+#pragma omp parallel private(julia_value, k)
+    {
+        PERF_REGION("generate_julia_set_parallel", 0, 0);
+#pragma omp for schedule(dynamic, chunk)
+        for (int y = 0; y < height; y++)
+        {
+            for (int x = 0; x < width; x++)
+            {
+                julia_value = julia(width, height, x_min, x_max, y_min, y_max, x, y);
+
+                unsigned char r, g, b;
+                apply_color(julia_value, MAX_ITERATIONS, r, g, b);
+                PERF_REGION_ADD(3.0, JULIA_FLOPS_PER_ITERATION * julia_value);
+
+                k = 3 * (y * width + x);
+                rgb[k] = r;
+                rgb[k + 1] = g;
+                rgb[k + 2] = b;
+            }
+        }
+    }
+}
+
+inline void generate_julia_set_serial(int width, int height, float x_min, float x_max, float y_min, float y_max, PixelBuffer &rgb)
+{
+    int julia_value;
+    int k;
+    PERF_REGION("generate_julia_set_serial", 3.0 * width * height, 0);
+
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            julia_value = julia(width, height, x_min, x_max, y_min, y_max, x, y);
+
+            unsigned char r, g, b;
+            apply_color(julia_value, MAX_ITERATIONS, r, g, b);
+            PERF_REGION_ADD(0, JULIA_FLOPS_PER_ITERATION * julia_value);
+
+            k = 3 * (y * width + x);
+            rgb[k] = r;
+            rgb[k + 1] = g;
+            rgb[k + 2] = b;
+        }
+    }
+}
+
+// Anti-aliased render: one sample per pixel, plus opt.samples jittered
+// subsamples on edge pixels only (../antialias.hpp)
+inline AAStats generate_julia_set_antialiased(int width, int height, float x_min, float x_max, float y_min, float y_max, PixelBuffer &rgb, const AAOptions &opt = AAOptions())
+{
+    return render_antialiased(
+        width, height, rgb, opt,
+        [&](float px, float py)
+        { return julia_point(julia_coord(px, width, x_min, x_max), julia_coord(py, height, y_min, y_max)); },
+        [](int iteration, unsigned char &r, unsigned char &g, unsigned char &b)
+        { apply_color(iteration, MAX_ITERATIONS, r, g, b); });
+}
+
+inline void write_ppm_image(int width, int height, const PixelBuffer &rgb, const std::string &filename)
+{
+    FILE *file_unit = fopen(filename.c_str(), "wb");
+
+    if (!file_unit)
+    {
+        std::cerr << "Error opening file " << filename << " for writing.\n";
+        return;
+    }
+
+    fprintf(file_unit, "P6\n");
+    fprintf(file_unit, "%d %d\n", width, height);
+    fprintf(file_unit, "255\n");
+
+    fwrite(rgb.data(), sizeof(unsigned char), 3 * width * height, file_unit);
+    fclose(file_unit);
+}
+
+} // namespace julia_set
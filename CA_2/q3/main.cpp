@@ -1,69 +1,74 @@
 #include <iostream>
 #include <random>
+#include <cmath>
+#include <cstdlib>
 #include <ctime>
+#include <string>
 #include <omp.h>
-
-const int TOTAL_POINTS = 100000;
-
-// Serial Monte Carlo
-double monte_carlo_serial()
+#include "monte_carlo.hpp"
+#include "../../bench/tuning.hpp"
+#ifdef PP_WITH_MPI
+#include "../mpi_hybrid.hpp"
+#endif
+
+// Hybrid MPI + OpenMP estimate: every rank draws its share of the points from
+// its own seeded streams and the hit counts are reduced (../mpi_hybrid.hpp)
+static int run_mpi(int argc, char **argv)
 {
-    int points_inside_circle = 0;
-
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<> dis(0.0, 1.0);
-
-    for (int i = 0; i < TOTAL_POINTS; i++)
+#ifdef PP_WITH_MPI
+    if (!mpi_init(argc, argv))
+        return 1;
+    long long total_points = argc > 2 ? atoll(argv[2]) : 1000LL * TOTAL_POINTS;
+    unsigned seed = argc > 3 ? (unsigned)atoi(argv[3]) : 2024;
+    if (total_points <= 0)
     {
-        double x = dis(gen);
-        double y = dis(gen);
-
-        if (x * x + y * y <= 1.0)
-        {
-            points_inside_circle++;
-        }
+        if (mpi_rank() == 0)
+            std::cerr << "Usage: " << argv[0] << " --mpi [points] [seed]\n";
+        MPI_Finalize();
+        return 1;
     }
 
-    return 4.0 * points_inside_circle / TOTAL_POINTS;
-}
-
-// Parallel Monte Carlo
-double monte_carlo_parallel()
-{
-    int points_inside_circle = 0;
+    MPI_Barrier(MPI_COMM_WORLD);
+    double start_time = MPI_Wtime();
+    double pi = mpi_monte_carlo_pi(total_points, seed, monte_carlo_count_seeded);
+    double elapsed = MPI_Wtime() - start_time;
 
-#pragma omp parallel
+    if (mpi_rank() == 0)
     {
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        std::uniform_real_distribution<> dis(0.0, 1.0);
-
-        int local_points_inside_circle = 0;
-
-#pragma omp for
-        for (int i = 0; i < TOTAL_POINTS; i++)
-        {
-            double x = dis(gen);
-            double y = dis(gen);
-
-            if (x * x + y * y <= 1.0)
-            {
-                local_points_inside_circle++;
-            }
-        }
-
-#pragma omp atomic
-        points_inside_circle += local_points_inside_circle;
+        std::cout << "MPI Pi estimation: " << pi << " (error " << std::fabs(pi - M_PI) << ")\n";
+        std::cout << "MPI execution time: " << elapsed << " seconds, " << mpi_size() << " ranks x "
+                  << omp_get_max_threads() << " threads, " << total_points / elapsed / 1e6 << " Mpoints/s\n";
     }
-
-    return 4.0 * points_inside_circle / TOTAL_POINTS;
+    MPI_Finalize();
+    return 0;
+#else
+    (void)argc;
+    std::cerr << argv[0] << " was built without MPI; build it with `make mpi` (or the ca2_pi_mpi target).\n";
+    return 1;
+#endif
 }
 
-int main()
+// Usage: main                                 serial vs OpenMP estimate
+//        mpirun -np N main_mpi --mpi [points] [seed]
+//                                             points spread over MPI ranks, OpenMP threads in each
+int main(int argc, char **argv)
 {
+    if (argc > 1 && std::string(argv[1]) == "--mpi")
+        return run_mpi(argc, argv);
+
     double start_time, end_time, time_serial, time_parallel;
 
+    // Thread count: tuned on the first run on this host, then read from the tuning cache
+    TuningCache cache;
+    TuneSpace space;
+    space.threads = tuneThreadCandidates();
+    TuneConfig tuned = autotune(cache, "pi", TOTAL_POINTS, space, [](const TuneConfig &c)
+                                {
+        omp_set_num_threads(c.threads);
+        benchDoNotOptimize(monte_carlo_parallel()); });
+    omp_set_num_threads(tuned.threads);
+    std::cout << "Tuned configuration: " << tuned.threads << " threads\n\n";
+
     // Serial computation
     start_time = omp_get_wtime();
     double pi_serial = monte_carlo_serial();
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <random>
+#include <omp.h>
+#include "../../common/perf_counters.hpp"
+
+const int TOTAL_POINTS = 100000;
+
+// Serial Monte Carlo
+inline double monte_carlo_serial(long total_points = TOTAL_POINTS)
+{
+    long points_inside_circle = 0;
+    PERF_REGION("monte_carlo_serial", 0, 4.0 * total_points);
+
+    std::random_device rd;
+    std::mt19937 gen(rd());
+    std::uniform_real_distribution<> dis(0.0, 1.0);
+
+    for (long i = 0; i < total_points; i++)
+    {
+        double x = dis(gen);
+        double y = dis(gen);
+
+        if (x * x + y * y <= 1.0)
+        {
+            points_inside_circle++;
+        }
+    }
+
+    return 4.0 * points_inside_circle / total_points;
+}
+
+// Parallel Monte Carlo
+inline double monte_carlo_parallel(long total_points = TOTAL_POINTS)
+{
+    long points_inside_circle = 0;
+
+#pragma omp parallel
+    {
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        std::uniform_real_distribution<> dis(0.0, 1.0);
+
+        long local_points_inside_circle = 0;
+        PERF_REGION("monte_carlo_parallel", 0, 0);
+
+#pragma omp for
+        for (long i = 0; i < total_points; i++)
+        {
+            double x = dis(gen);
+            double y = dis(gen);
+            PERF_REGION_ADD(0, 4);
+
+            if (x * x + y * y <= 1.0)
+            {
+                local_points_inside_circle++;
+            }
+        }
+
+#pragma omp atomic
+        points_inside_circle += local_points_inside_circle;
+    }
+
+    return 4.0 * points_inside_circle / total_points;
+}
+
+// Points inside the circle out of total_points, from reproducible streams:
+// thread t of stream `stream` (an MPI rank, see ../mpi_hybrid.hpp) seeds its
+// mt19937 from (seed, stream, t), so no two threads or ranks share a sequence
+inline long long monte_carlo_count_seeded(long long total_points, unsigned seed, int stream)
+{
+    long long points_inside_circle = 0;
+
+#pragma omp parallel reduction(+ : points_inside_circle)
+    {
+        std::seed_seq seq{seed, (unsigned)stream, (unsigned)omp_get_thread_num()};
+        std::mt19937 gen(seq);
+        std::uniform_real_distribution<> dis(0.0, 1.0);
+        PERF_REGION("monte_carlo_seeded", 0, 0);
+
+#pragma omp for
+        for (long long i = 0; i < total_points; i++)
+        {
+            double x = dis(gen);
+            double y = dis(gen);
+            PERF_REGION_ADD(0, 4);
+
+            if (x * x + y * y <= 1.0)
+            {
+                points_inside_circle++;
+            }
+        }
+    }
+
+    return points_inside_circle;
+}
@@ -0,0 +1,348 @@
+#pragma once
+
+// Shared benchmark harness for the kernel bench binaries.
+//
+// Every case is warmed up (first-touch page faults, cold caches and lazy
+// thread-pool start-up land there), then timed over repeated trials. A trial
+// repeats the kernel until it lasts at least --min-time so tiny inputs are not
+// dominated by timer resolution. Results carry median, p95, mean, standard
+// deviation and a 95% confidence interval of the median, plus throughput, and
+// are written as JSON or CSV for tracking across releases.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum ThroughputUnit
+{
+    UNIT_PIXELS,   // pixels/s
+    UNIT_SAMPLES,  // samples/s
+    UNIT_BYTES,    // reported as GB/s
+    UNIT_ELEMENTS  // elements/s
+};
+
+inline const char *throughputUnitName(ThroughputUnit unit)
+{
+    switch (unit)
+    {
+    case UNIT_PIXELS:
+        return "pixels/s";
+    case UNIT_SAMPLES:
+        return "samples/s";
+    case UNIT_BYTES:
+        return "GB/s";
+    default:
+        return "elements/s";
+    }
+}
+
+struct BenchOptions
+{
+    int warmup = 2;             // untimed runs before the trials
+    int trials = 15;            // timed trials per case
+    double minTrialSeconds = 0.01;
+    std::string format = "json"; // json | csv
+    std::string output;          // file, empty = stdout
+    std::vector<long> sizes;     // problem sizes to sweep
+    std::vector<int> threads;    // thread counts to sweep
+    std::vector<std::string> kernels; // empty = all
+};
+
+inline std::vector<long> parseLongList(const std::string &text)
+{
+    std::vector<long> values;
+    size_t pos = 0;
+    while (pos < text.size())
+    {
+        size_t comma = text.find(',', pos);
+        if (comma == std::string::npos)
+            comma = text.size();
+        values.push_back(std::atol(text.substr(pos, comma - pos).c_str()));
+        pos = comma + 1;
+    }
+    return values;
+}
+
+// Thread counts 1, 2, 4, ... up to and including all cores
+inline std::vector<int> defaultThreadSweep()
+{
+    int cores = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<int> threads;
+    for (int t = 1; t < cores; t *= 2)
+        threads.push_back(t);
+    threads.push_back(cores);
+    return threads;
+}
+
+inline void printBenchUsage(const char *program)
+{
+    std::cerr << "Usage: " << program << " [--warmup N] [--trials N] [--min-time seconds] [--format json|csv]\n"
+              << "       [--out file] [--sizes a,b,...] [--threads a,b,...] [--kernels name,...]\n";
+}
+
+// Common command line; defaults apply when a list is not given. Exits on --help or bad flags.
+inline BenchOptions parseBenchOptions(int argc, char **argv, const std::vector<long> &defaultSizes, const std::vector<int> &defaultThreads)
+{
+    BenchOptions opt;
+    opt.sizes = defaultSizes;
+    opt.threads = defaultThreads;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--warmup" && hasValue)
+            opt.warmup = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--trials" && hasValue)
+            opt.trials = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--min-time" && hasValue)
+            opt.minTrialSeconds = std::atof(argv[++i]);
+        else if (arg == "--format" && hasValue)
+            opt.format = argv[++i];
+        else if (arg == "--out" && hasValue)
+            opt.output = argv[++i];
+        else if (arg == "--sizes" && hasValue)
+            opt.sizes = parseLongList(argv[++i]);
+        else if (arg == "--threads" && hasValue)
+        {
+            opt.threads.clear();
+            int cores = std::max(1u, std::thread::hardware_concurrency());
+            for (long t : parseLongList(argv[++i]))
+                opt.threads.push_back(t > 0 ? static_cast<int>(t) : cores);
+        }
+        else if (arg == "--kernels" && hasValue)
+        {
+            std::string list = argv[++i];
+            size_t pos = 0;
+            while (pos < list.size())
+            {
+                size_t comma = std::min(list.find(',', pos), list.size());
+                opt.kernels.push_back(list.substr(pos, comma - pos));
+                pos = comma + 1;
+            }
+        }
+        else
+        {
+            printBenchUsage(argv[0]);
+            std::exit(arg == "--help" || arg == "-h" ? 0 : 1);
+        }
+    }
+    if (opt.format != "json" && opt.format != "csv")
+    {
+        printBenchUsage(argv[0]);
+        std::exit(1);
+    }
+    return opt;
+}
+
+inline bool benchKernelSelected(const BenchOptions &opt, const std::string &kernel)
+{
+    return opt.kernels.empty() || std::find(opt.kernels.begin(), opt.kernels.end(), kernel) != opt.kernels.end();
+}
+
+// Keeps a result alive so the compiler cannot drop the computation that produced it
+template <typename T>
+inline void benchDoNotOptimize(const T &value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct BenchResult
+{
+    std::string kernel;
+    long size = 0;
+    int threads = 1;
+    double work = 0; // units of work per run (pixels, samples, bytes, elements)
+    ThroughputUnit unit = UNIT_ELEMENTS;
+    int repeats = 1; // kernel runs per trial
+    std::vector<double> seconds; // per run, one entry per trial
+
+    double median = 0, p95 = 0, mean = 0, stddev = 0, min = 0;
+    double ciLow = 0, ciHigh = 0; // 95% confidence interval of the median
+
+    double throughput() const
+    {
+        double perSecond = median > 0 ? work / median : 0.0;
+        return unit == UNIT_BYTES ? perSecond * 1e-9 : perSecond;
+    }
+};
+
+// Nearest-rank percentile of sorted data
+inline double sortedPercentile(const std::vector<double> &sorted, double p)
+{
+    if (sorted.empty())
+        return 0.0;
+    size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+    return sorted[std::min(sorted.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
+
+inline void computeBenchStats(BenchResult &r)
+{
+    std::vector<double> sorted(r.seconds);
+    std::sort(sorted.begin(), sorted.end());
+    size_t n = sorted.size();
+    if (n == 0)
+        return;
+
+    r.min = sorted.front();
+    r.median = n % 2 ? sorted[n / 2] : 0.5 * (sorted[n / 2 - 1] + sorted[n / 2]);
+    r.p95 = sortedPercentile(sorted, 95);
+
+    double sum = 0;
+    for (double s : sorted)
+        sum += s;
+    r.mean = sum / n;
+    double squares = 0;
+    for (double s : sorted)
+        squares += (s - r.mean) * (s - r.mean);
+    r.stddev = n > 1 ? std::sqrt(squares / (n - 1)) : 0.0;
+
+    // Distribution-free CI of the median: order statistics n/2 -+ 1.96 sqrt(n)/2
+    double half = 0.98 * std::sqrt(static_cast<double>(n));
+    long lo = static_cast<long>(std::floor(n / 2.0 - half));
+    long hi = static_cast<long>(std::ceil(n / 2.0 + half));
+    r.ciLow = sorted[std::max(0L, std::min<long>(n - 1, lo))];
+    r.ciHigh = sorted[std::max(0L, std::min<long>(n - 1, hi))];
+}
+
+// Time `run` after `opt.warmup` untimed calls. `run` must do exactly one
+// kernel invocation on inputs prepared outside of it.
+inline BenchResult runBench(const std::string &kernel, long size, int threads, double work, ThroughputUnit unit,
+                            const BenchOptions &opt, const std::function<void()> &run)
+{
+    using clock = std::chrono::steady_clock;
+
+    BenchResult r;
+    r.kernel = kernel;
+    r.size = size;
+    r.threads = threads;
+    r.work = work;
+    r.unit = unit;
+
+    for (int i = 0; i < opt.warmup; ++i)
+        run();
+
+    // Calibrate the repeat count on one run
+    auto start = clock::now();
+    run();
+    double once = std::chrono::duration<double>(clock::now() - start).count();
+    if (once > 0 && once < opt.minTrialSeconds)
+        r.repeats = static_cast<int>(std::min(1e6, std::ceil(opt.minTrialSeconds / once)));
+
+    for (int t = 0; t < opt.trials; ++t)
+    {
+        start = clock::now();
+        for (int k = 0; k < r.repeats; ++k)
+            run();
+        r.seconds.push_back(std::chrono::duration<double>(clock::now() - start).count() / r.repeats);
+    }
+
+    computeBenchStats(r);
+    std::fprintf(stderr, "%-24s size %-10ld threads %-3d median %.6f s  p95 %.6f s  %.4g %s\n",
+                 kernel.c_str(), size, threads, r.median, r.p95, r.throughput(), throughputUnitName(unit));
+    return r;
+}
+
+// "model name" from /proc/cpuinfo, empty when unavailable
+inline std::string benchCpuModel()
+{
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line))
+    {
+        if (line.compare(0, 10, "model name") == 0)
+        {
+            size_t colon = line.find(':');
+            return colon == std::string::npos ? "" : line.substr(line.find_first_not_of(' ', colon + 1));
+        }
+    }
+    return "";
+}
+
+inline std::string jsonEscape(const std::string &text)
+{
+    std::string out;
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+            out += '\\';
+        if (static_cast<unsigned char>(c) >= 0x20)
+            out += c;
+    }
+    return out;
+}
+
+// Collects the results of one bench binary and writes them in the requested format
+class BenchReport
+{
+public:
+    explicit BenchReport(const std::string &benchmark) : benchmark(benchmark) {}
+
+    void add(const BenchResult &r) { results.push_back(r); }
+
+    bool write(const BenchOptions &opt) const
+    {
+        FILE *out = opt.output.empty() ? stdout : std::fopen(opt.output.c_str(), "w");
+        if (!out)
+        {
+            std::cerr << "Error opening file " << opt.output << " for writing.\n";
+            return false;
+        }
+        if (opt.format == "csv")
+            writeCSV(out);
+        else
+            writeJSON(out, opt);
+        if (out != stdout)
+            std::fclose(out);
+        return true;
+    }
+
+private:
+    void writeCSV(FILE *out) const
+    {
+        std::fprintf(out, "benchmark,kernel,size,threads,trials,repeats,median_s,p95_s,mean_s,stddev_s,min_s,ci95_low_s,ci95_high_s,throughput,unit\n");
+        for (const BenchResult &r : results)
+            std::fprintf(out, "%s,%s,%ld,%d,%zu,%d,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%s\n",
+                         benchmark.c_str(), r.kernel.c_str(), r.size, r.threads, r.seconds.size(), r.repeats,
+                         r.median, r.p95, r.mean, r.stddev, r.min, r.ciLow, r.ciHigh, r.throughput(), throughputUnitName(r.unit));
+    }
+
+    void writeJSON(FILE *out, const BenchOptions &opt) const
+    {
+        std::time_t now = std::time(nullptr);
+        char timestamp[32];
+        std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+        std::fprintf(out, "{\n  \"benchmark\": \"%s\",\n  \"timestamp\": \"%s\",\n", jsonEscape(benchmark).c_str(), timestamp);
+        std::fprintf(out, "  \"host\": {\"cpu\": \"%s\", \"cores\": %u, \"compiler\": \"%s\"},\n",
+                     jsonEscape(benchCpuModel()).c_str(), std::thread::hardware_concurrency(), jsonEscape(__VERSION__).c_str());
+        std::fprintf(out, "  \"config\": {\"warmup\": %d, \"trials\": %d, \"min_trial_s\": %g},\n", opt.warmup, opt.trials, opt.minTrialSeconds);
+        std::fprintf(out, "  \"results\": [\n");
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const BenchResult &r = results[i];
+            std::fprintf(out, "    {\"kernel\": \"%s\", \"size\": %ld, \"threads\": %d, \"repeats\": %d, "
+                              "\"median_s\": %.9g, \"p95_s\": %.9g, \"mean_s\": %.9g, \"stddev_s\": %.9g, \"min_s\": %.9g, "
+                              "\"ci95_s\": [%.9g, %.9g], \"throughput\": %.9g, \"unit\": \"%s\", \"samples_s\": [",
+                         jsonEscape(r.kernel).c_str(), r.size, r.threads, r.repeats, r.median, r.p95, r.mean, r.stddev, r.min,
+                         r.ciLow, r.ciHigh, r.throughput(), throughputUnitName(r.unit));
+            for (size_t k = 0; k < r.seconds.size(); ++k)
+                std::fprintf(out, "%s%.9g", k ? ", " : "", r.seconds[k]);
+            std::fprintf(out, "]}%s\n", i + 1 < results.size() ? "," : "");
+        }
+        std::fprintf(out, "  ]\n}\n");
+    }
+
+    std::string benchmark;
+    std::vector<BenchResult> results;
+};
@@ -0,0 +1,61 @@
+#include <opencv2/opencv.hpp>
+#include "bench.hpp"
+#include "../CA_1/codes/Q1/blend_engine.hpp"
+#include "../CA_1/codes/Q1/logo_overlay.hpp"
+#include "../CA_1/codes/Q1/alpha_composite.hpp"
+
+// Image blending (CA_1 Q1): the blending engine per ISA and thread count, the
+// cached logo overlay and BGRA "over" compositing. Sizes are frame widths at 16:9.
+int main(int argc, char **argv)
+{
+    BenchOptions opt = parseBenchOptions(argc, argv, {640, 1920, 3840}, defaultThreadSweep());
+    BenchReport report("blend");
+    const float alpha = 0.625f;
+    const char *isaNames[] = {"engine_scalar", "engine_sse", "engine_avx2"};
+    cv::RNG rng(1);
+
+    for (long width : opt.sizes)
+    {
+        int cols = static_cast<int>(width), rows = static_cast<int>(width * 9 / 16);
+        cv::Mat image(rows, cols, CV_8UC3), logo(rows, cols, CV_8UC3), bgra(rows, cols, CV_8UC4), dst;
+        rng.fill(image, cv::RNG::UNIFORM, 0, 256);
+        rng.fill(logo, cv::RNG::UNIFORM, 0, 256);
+        rng.fill(bgra, cv::RNG::UNIFORM, 0, 256);
+        double pixels = (double)rows * cols;
+
+        for (int isa = BLEND_SCALAR; isa <= detectBlendISA(); ++isa)
+        {
+            if (!benchKernelSelected(opt, isaNames[isa]))
+                continue;
+            for (int threads : opt.threads)
+            {
+                cv::setNumThreads(threads);
+                const float alpha3[3] = {alpha, alpha, alpha};
+                report.add(runBench(isaNames[isa], width, threads, pixels, UNIT_PIXELS, opt, [&]
+                                    {
+                    mergePhotosWeighted_Engine(image, logo, dst, alpha3, threads, static_cast<BlendISA>(isa));
+                    benchDoNotOptimize(dst.data[0]); }));
+            }
+        }
+
+        if (benchKernelSelected(opt, "logo_overlay"))
+        {
+            LogoOverlay overlay(logo, alpha);
+            image.copyTo(dst);
+            report.add(runBench("logo_overlay", width, 1, pixels, UNIT_PIXELS, opt, [&]
+                                {
+                overlay.apply(dst, cv::Point(0, 0));
+                benchDoNotOptimize(dst.data[0]); }));
+        }
+
+        if (benchKernelSelected(opt, "composite_over"))
+        {
+            image.copyTo(dst);
+            report.add(runBench("composite_over", width, 1, pixels, UNIT_PIXELS, opt, [&]
+                                {
+                compositeOver_SIMD(bgra, dst, ALPHA_STRAIGHT);
+                benchDoNotOptimize(dst.data[0]); }));
+        }
+    }
+    return report.write(opt) ? 0 : 1;
+}
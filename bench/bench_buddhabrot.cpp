@@ -0,0 +1,55 @@
+#include <omp.h>
+#include "bench.hpp"
+#include "../CA_2/q1/buddhabrot.hpp"
+
+// Buddhabrot orbit density (CA_2/q1) of a 512x512 view: scalar reference, SIMD
+// with per-thread tree-merged histograms, SIMD with one shared atomic
+// histogram, and uniform sampling, over sample counts and thread counts
+int main(int argc, char **argv)
+{
+    BenchOptions opt = parseBenchOptions(argc, argv, {1 << 18, 1 << 20, 1 << 22}, defaultThreadSweep());
+    BenchReport report("buddhabrot");
+    const int side = 512;
+    float x_min = -2.0, x_max = 1.0, y_min = -1.5, y_max = 1.5;
+
+    BuddhabrotOptions importance, uniform;
+    uniform.importance = false;
+    const BuddhabrotSampler sampler = make_buddhabrot_sampler(importance), uniformSampler = make_buddhabrot_sampler(uniform);
+    std::vector<uint64_t> hist;
+
+    for (long samples : opt.sizes)
+    {
+        auto run = [&](const std::string &kernel, int threads, BuddhabrotOptions o, const BuddhabrotSampler &s)
+        {
+            o.samples = samples;
+            omp_set_num_threads(threads);
+            // The view is symmetric: only half the samples are drawn, and the rate counts those
+            double drawn = buddhabrot_folds(side, y_min, y_max) ? (samples + 1) / 2 : samples;
+            report.add(runBench(kernel, samples, threads, drawn, UNIT_SAMPLES, opt, [&]
+                                {
+                generate_buddhabrot(side, side, x_min, x_max, y_min, y_max, hist, s, o);
+                benchDoNotOptimize(hist[0]); }));
+        };
+
+        if (benchKernelSelected(opt, "scalar"))
+        {
+            BuddhabrotOptions o = importance;
+            o.simd = false;
+            run("scalar", 1, o, sampler);
+        }
+        for (int threads : opt.threads)
+        {
+            if (benchKernelSelected(opt, "private"))
+                run("private", threads, importance, sampler);
+            if (benchKernelSelected(opt, "atomic"))
+            {
+                BuddhabrotOptions o = importance;
+                o.histograms = BUDDHA_SHARED_ATOMIC;
+                run("atomic", threads, o, sampler);
+            }
+            if (benchKernelSelected(opt, "uniform"))
+                run("uniform", threads, uniform, uniformSampler);
+        }
+    }
+    return report.write(opt) ? 0 : 1;
+}
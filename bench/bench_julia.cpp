@@ -0,0 +1,36 @@
+#include <omp.h>
+#include "bench.hpp"
+#include "../CA_2/q2/julia.hpp"
+
+// Julia set rendering (CA_2/q2), serial and OpenMP, over image sizes and thread counts
+int main(int argc, char **argv)
+{
+    BenchOptions opt = parseBenchOptions(argc, argv, {128, 256, 512}, defaultThreadSweep());
+    BenchReport report("julia");
+    float x_min = -2, x_max = 2, y_min = -2, y_max = 2;
+
+    for (long size : opt.sizes)
+    {
+        int width = static_cast<int>(size), height = static_cast<int>(size);
+        PixelBuffer rgb(3 * width * height);
+        firstTouchRows(rgb, 3 * width, height);
+        double pixels = (double)width * height;
+
+        if (benchKernelSelected(opt, "serial"))
+            report.add(runBench("serial", size, 1, pixels, UNIT_PIXELS, opt, [&]
+                                {
+                julia_set::generate_julia_set_serial(width, height, x_min, x_max, y_min, y_max, rgb);
+                benchDoNotOptimize(rgb[0]); }));
+
+        if (benchKernelSelected(opt, "openmp"))
+            for (int threads : opt.threads)
+            {
+                omp_set_num_threads(threads);
+                report.add(runBench("openmp", size, threads, pixels, UNIT_PIXELS, opt, [&]
+                                    {
+                    julia_set::generate_julia_set_parallel(width, height, x_min, x_max, y_min, y_max, rgb);
+                    benchDoNotOptimize(rgb[0]); }));
+            }
+    }
+    return report.write(opt) ? 0 : 1;
+}
@@ -0,0 +1,98 @@
+#include <opencv2/opencv.hpp>
+#include "bench.hpp"
+#include "../CA_1/codes/Q4/abs_diff.hpp"
+#include "../CA_1/codes/Q4/fused_motion.hpp"
+#include "../CA_1/codes/Q4/motion_regions.hpp"
+#include "../CA_1/codes/Q4/background_model.hpp"
+#include "../CA_1/codes/Q4/pyramid_motion.hpp"
+
+// Motion detection kernels (CA_1 Q4) on synthetic frame pairs. Sizes are frame
+// widths at 16:9; the parallel kernels are swept over OpenCV thread counts.
+int main(int argc, char **argv)
+{
+    BenchOptions opt = parseBenchOptions(argc, argv, {640, 1920, 3840}, defaultThreadSweep());
+    BenchReport report("motion");
+    cv::RNG rng(1);
+
+    for (long width : opt.sizes)
+    {
+        // absDiff_SIMD works in whole 16-byte groups
+        int cols = static_cast<int>(width / 16 * 16), rows = static_cast<int>(width * 9 / 16);
+        cv::Mat frame(rows, cols, CV_8UC3), cur(rows, cols, CV_8U), prev(rows, cols, CV_8U);
+        rng.fill(frame, cv::RNG::UNIFORM, 0, 256);
+        rng.fill(cur, cv::RNG::UNIFORM, 0, 256);
+        rng.fill(prev, cv::RNG::UNIFORM, 0, 256);
+        double pixels = (double)rows * cols;
+        cv::Mat diff, blockMask, sad, foreground;
+
+        if (benchKernelSelected(opt, "absdiff_serial"))
+            report.add(runBench("absdiff_serial", cols, 1, pixels, UNIT_PIXELS, opt, [&]
+                                {
+                absDiff_Serial(cur, prev, diff);
+                benchDoNotOptimize(diff.data[0]); }));
+
+        if (benchKernelSelected(opt, "absdiff_sse"))
+            report.add(runBench("absdiff_sse", cols, 1, pixels, UNIT_PIXELS, opt, [&]
+                                {
+                absDiff_SIMD(cur, prev, diff);
+                benchDoNotOptimize(diff.data[0]); }));
+
+        for (int threads : opt.threads)
+        {
+            cv::setNumThreads(threads);
+
+            if (benchKernelSelected(opt, "fused"))
+            {
+                FusedMotionDetector detector;
+                report.add(runBench("fused", cols, threads, pixels, UNIT_PIXELS, opt, [&]
+                                    {
+                    detector.process(frame, diff, blockMask);
+                    benchDoNotOptimize(blockMask.data[0]); }));
+            }
+
+            if (benchKernelSelected(opt, "block_sad"))
+                report.add(runBench("block_sad", cols, threads, pixels, UNIT_PIXELS, opt, [&]
+                                    {
+                    blockSAD_SIMD(cur, prev, sad);
+                    benchDoNotOptimize(sad.data[0]); }));
+
+            // Coarse-to-fine detection of a mostly static scene: the same frame
+            // except for one moving 64x64 square. Frames alternate, as in a stream,
+            // so each call builds one pyramid level and reuses the other.
+            for (int levels = 2; levels <= 3; ++levels)
+            {
+                const char *name = levels == 2 ? "pyramid2_static" : "pyramid3_static";
+                if (!benchKernelSelected(opt, name))
+                    continue;
+                cv::Mat still = cur.clone();
+                cv::Rect square(cols / 2, rows / 2, std::min(64, cols / 2), std::min(64, rows / 2));
+                prev(square).copyTo(still(square));
+                PyramidMotionOptions options;
+                options.levels = levels;
+                PyramidMotionDetector detector(options);
+                long frame = 0;
+                report.add(runBench(name, cols, threads, pixels, UNIT_PIXELS, opt, [&]
+                                    {
+                    bool flip = ++frame % 2;
+                    detector.detect(flip ? still : cur, flip ? cur : still, 10.0, sad, frame);
+                    benchDoNotOptimize(sad.data[0]); }));
+            }
+
+            for (int mode = BG_RUNNING_AVERAGE; mode <= BG_GAUSSIAN; ++mode)
+            {
+                const char *name = mode == BG_GAUSSIAN ? "background_gaussian" : "background_average";
+                if (!benchKernelSelected(opt, name))
+                    continue;
+                BackgroundParams params;
+                params.mode = static_cast<BackgroundMode>(mode);
+                BackgroundModel model(params);
+                model.apply(prev, foreground); // seed
+                report.add(runBench(name, cols, threads, pixels, UNIT_PIXELS, opt, [&]
+                                    {
+                    model.apply(cur, foreground);
+                    benchDoNotOptimize(foreground.data[0]); }));
+            }
+        }
+    }
+    return report.write(opt) ? 0 : 1;
+}
@@ -0,0 +1,43 @@
+#include <stdlib.h>
+#include <vector>
+#include "bench.hpp"
+#include "../CA_1/codes/Q2/outliers.hpp"
+
+// Z-score outlier counting (CA_1 Q2): mean/stddev + count, serial and SSE, over array sizes
+int main(int argc, char **argv)
+{
+    // The kernels are single-threaded, so a thread count would be ignored
+    for (int i = 1; i < argc; ++i)
+        if (std::string(argv[i]) == "--threads")
+        {
+            std::cerr << argv[0] << ": the outlier kernels are single-threaded; --threads is not supported\n";
+            return 1;
+        }
+    BenchOptions opt = parseBenchOptions(argc, argv, {1 << 16, 1 << 20, 1 << 24}, {1});
+    BenchReport report("outliers");
+    srand(1);
+
+    for (long size : opt.sizes)
+    {
+        int n = static_cast<int>(size);
+        std::vector<float> array(n);
+        for (int i = 0; i < n; i++)
+            array[i] = (float)(rand() % 2000001) - 1000000.0f;
+        double bytes = (double)n * sizeof(float);
+
+        if (benchKernelSelected(opt, "serial"))
+            report.add(runBench("serial", n, 1, bytes, UNIT_BYTES, opt, [&]
+                                {
+                float mean, sigma;
+                meanAndSTD_Serial(array.data(), n, &mean, &sigma);
+                benchDoNotOptimize(countOutliers_Serial(array.data(), n, mean, sigma)); }));
+
+        if (benchKernelSelected(opt, "sse"))
+            report.add(runBench("sse", n, 1, bytes, UNIT_BYTES, opt, [&]
+                                {
+                float mean, sigma;
+                meanAndSTD_Parallel(array.data(), n, &mean, &sigma);
+                benchDoNotOptimize(countOutliers_Parallel(array.data(), n, mean, sigma)); }));
+    }
+    return report.write(opt) ? 0 : 1;
+}
@@ -0,0 +1,26 @@
+#include <omp.h>
+#include "bench.hpp"
+#include "../CA_2/q3/monte_carlo.hpp"
+
+// Monte Carlo pi (CA_2/q3), serial and OpenMP, over sample counts and thread counts
+int main(int argc, char **argv)
+{
+    BenchOptions opt = parseBenchOptions(argc, argv, {100000, 1000000, 10000000}, defaultThreadSweep());
+    BenchReport report("monte_carlo_pi");
+
+    for (long samples : opt.sizes)
+    {
+        if (benchKernelSelected(opt, "serial"))
+            report.add(runBench("serial", samples, 1, (double)samples, UNIT_SAMPLES, opt, [&]
+                                { benchDoNotOptimize(monte_carlo_serial(samples)); }));
+
+        if (benchKernelSelected(opt, "openmp"))
+            for (int threads : opt.threads)
+            {
+                omp_set_num_threads(threads);
+                report.add(runBench("openmp", samples, threads, (double)samples, UNIT_SAMPLES, opt, [&]
+                                    { benchDoNotOptimize(monte_carlo_parallel(samples)); }));
+            }
+    }
+    return report.write(opt) ? 0 : 1;
+}
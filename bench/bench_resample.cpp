@@ -0,0 +1,71 @@
+#include <opencv2/opencv.hpp>
+#include "bench.hpp"
+#include "../CA_1/codes/image_resampler.hpp"
+
+// Image resampling (CA_1 Q1 logo, Q4 motion frames): the separable fixed-point
+// resampler per filter, SIMD and scalar, against cv::resize with the nearest
+// interpolation. Sizes are source frame widths at 16:9; "down" goes to the Q4
+// window size (640x480), "up" doubles the frame. Throughput is output pixels.
+int main(int argc, char **argv)
+{
+    BenchOptions opt = parseBenchOptions(argc, argv, {640, 1920, 3840}, defaultThreadSweep());
+    BenchReport report("resample");
+    const struct
+    {
+        const char *name;
+        ResampleFilter filter;
+        int interpolation;
+    } filters[] = {{"bilinear", RESAMPLE_BILINEAR, cv::INTER_LINEAR},
+                   {"area", RESAMPLE_AREA, cv::INTER_AREA},
+                   {"lanczos3", RESAMPLE_LANCZOS3, cv::INTER_LANCZOS4}};
+    cv::RNG rng(1);
+
+    for (long width : opt.sizes)
+    {
+        int cols = static_cast<int>(width), rows = static_cast<int>(width * 9 / 16);
+        for (int channels : {1, 3})
+        {
+            cv::Mat src(rows, cols, CV_8UC(channels)), dst;
+            rng.fill(src, cv::RNG::UNIFORM, 0, 256);
+            for (bool up : {false, true})
+            {
+                cv::Size size = up ? cv::Size(2 * cols, 2 * rows) : cv::Size(640, 480);
+                double pixels = (double)size.area();
+                std::string suffix = std::string(channels == 1 ? "_gray" : "_bgr") + (up ? "_up" : "_down");
+
+                for (const auto &f : filters)
+                {
+                    std::string simdName = std::string("resample_") + f.name + suffix;
+                    std::string scalarName = std::string("resample_scalar_") + f.name + suffix;
+                    std::string cvName = std::string("cv_resize_") + f.name + suffix;
+                    for (int threads : opt.threads)
+                    {
+                        cv::setNumThreads(threads);
+                        if (benchKernelSelected(opt, simdName))
+                        {
+                            ImageResampler resampler(f.filter);
+                            report.add(runBench(simdName, width, threads, pixels, UNIT_PIXELS, opt, [&]
+                                                {
+                                resampler.apply(src, dst, size);
+                                benchDoNotOptimize(dst.data[0]); }));
+                        }
+                        if (benchKernelSelected(opt, scalarName))
+                        {
+                            ImageResampler resampler(f.filter, false);
+                            report.add(runBench(scalarName, width, threads, pixels, UNIT_PIXELS, opt, [&]
+                                                {
+                                resampler.apply(src, dst, size);
+                                benchDoNotOptimize(dst.data[0]); }));
+                        }
+                        if (benchKernelSelected(opt, cvName))
+                            report.add(runBench(cvName, width, threads, pixels, UNIT_PIXELS, opt, [&]
+                                                {
+                                cv::resize(src, dst, size, 0, 0, f.interpolation);
+                                benchDoNotOptimize(dst.data[0]); }));
+                    }
+                }
+            }
+        }
+    }
+    return report.write(opt) ? 0 : 1;
+}
@@ -0,0 +1,29 @@
+#include <random>
+#include "bench.hpp"
+#include "../CA_1/codes/Q3/rle.hpp"
+
+// Run-length encoding (CA_1 Q3), serial and SSE, over input lengths
+int main(int argc, char **argv)
+{
+    BenchOptions opt = parseBenchOptions(argc, argv, {1 << 12, 1 << 16, 1 << 20}, {1});
+    BenchReport report("rle");
+    std::mt19937 gen(1);
+
+    for (long size : opt.sizes)
+    {
+        // Runs of 1-32 letters, a mix of short and long runs
+        std::string input;
+        while ((long)input.size() < size)
+            input.append(std::min<long>(1 + gen() % 32, size - input.size()), static_cast<char>('a' + gen() % 26));
+        double bytes = (double)input.size();
+
+        if (benchKernelSelected(opt, "serial"))
+            report.add(runBench("serial", size, 1, bytes, UNIT_BYTES, opt, [&]
+                                { benchDoNotOptimize(rle_compress_serial(input).size()); }));
+
+        if (benchKernelSelected(opt, "sse"))
+            report.add(runBench("sse", size, 1, bytes, UNIT_BYTES, opt, [&]
+                                { benchDoNotOptimize(rle_compress_simd(input).size()); }));
+    }
+    return report.write(opt) ? 0 : 1;
+}
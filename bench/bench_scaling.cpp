@@ -0,0 +1,188 @@
+#include <omp.h>
+#include <cmath>
+#include "bench.hpp"
+#include "../common/numa_affinity.hpp"
+#include "../CA_2/q1/mandelbrot.hpp"
+#include "../CA_2/q2/julia.hpp"
+#include "../CA_2/q3/monte_carlo.hpp"
+
+// Strong and weak scaling of the CA_2 OpenMP kernels over 1..N threads.
+//
+//   strong: fixed problem, speedup S = T1 / Tp
+//   weak:   problem grows with p (pixels or samples ~ p), scaled speedup S = (Wp / W1) * T1 / Tp
+//   efficiency E = S / p, Karp-Flatt serial fraction e = (1/S - 1/p) / (1 - 1/p)
+//
+// A Karp-Flatt metric that grows with p points at parallel overhead (scheduling,
+// imbalance, memory bandwidth) rather than at a fixed serial part.
+
+struct ScalingPoint
+{
+    std::string kernel, mode;
+    int threads;
+    long size;
+    BenchResult result;
+    double speedup = 1, efficiency = 1, karpFlatt = 0;
+};
+
+struct ScalingKernel
+{
+    std::string name;
+    long baseSize;
+    bool image; // size is an image side (work = side^2), otherwise a sample count
+};
+
+static void writeScaling(const std::vector<ScalingPoint> &points, const BenchOptions &opt, PinPolicy pin, bool firstTouch)
+{
+    FILE *out = opt.output.empty() ? stdout : std::fopen(opt.output.c_str(), "w");
+    if (!out)
+    {
+        std::cerr << "Error opening file " << opt.output << " for writing.\n";
+        return;
+    }
+
+    if (opt.format == "csv")
+    {
+        std::fprintf(out, "kernel,mode,pin,first_touch,threads,size,work,median_s,p95_s,ci95_low_s,ci95_high_s,speedup,efficiency,karp_flatt,throughput,unit\n");
+        for (const ScalingPoint &p : points)
+            std::fprintf(out, "%s,%s,%s,%d,%d,%ld,%.0f,%.9g,%.9g,%.9g,%.9g,%.6g,%.6g,%.6g,%.9g,%s\n",
+                         p.kernel.c_str(), p.mode.c_str(), pinPolicyName(pin), firstTouch, p.threads, p.size, p.result.work,
+                         p.result.median, p.result.p95, p.result.ciLow, p.result.ciHigh, p.speedup, p.efficiency, p.karpFlatt,
+                         p.result.throughput(), throughputUnitName(p.result.unit));
+    }
+    else
+    {
+        std::fprintf(out, "{\n  \"benchmark\": \"scaling\",\n  \"host\": {\"cpu\": \"%s\", \"cores\": %u},\n",
+                     jsonEscape(benchCpuModel()).c_str(), std::thread::hardware_concurrency());
+        std::fprintf(out, "  \"config\": {\"pin\": \"%s\", \"first_touch\": %s, \"warmup\": %d, \"trials\": %d},\n  \"results\": [\n",
+                     pinPolicyName(pin), firstTouch ? "true" : "false", opt.warmup, opt.trials);
+        for (size_t i = 0; i < points.size(); ++i)
+        {
+            const ScalingPoint &p = points[i];
+            std::fprintf(out, "    {\"kernel\": \"%s\", \"mode\": \"%s\", \"threads\": %d, \"size\": %ld, \"work\": %.0f, "
+                              "\"median_s\": %.9g, \"p95_s\": %.9g, \"ci95_s\": [%.9g, %.9g], \"speedup\": %.6g, "
+                              "\"efficiency\": %.6g, \"karp_flatt\": %.6g, \"throughput\": %.9g, \"unit\": \"%s\"}%s\n",
+                         p.kernel.c_str(), p.mode.c_str(), p.threads, p.size, p.result.work, p.result.median, p.result.p95,
+                         p.result.ciLow, p.result.ciHigh, p.speedup, p.efficiency, p.karpFlatt, p.result.throughput(),
+                         throughputUnitName(p.result.unit), i + 1 < points.size() ? "," : "");
+        }
+        std::fprintf(out, "  ]\n}\n");
+    }
+    if (out != stdout)
+        std::fclose(out);
+}
+
+int main(int argc, char **argv)
+{
+    // Driver-only flags are taken out before the common parser sees the rest
+    std::string mode = "both";
+    PinPolicy pin = PIN_NONE;
+    bool firstTouch = true;
+    std::vector<char *> rest = {argv[0]};
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--mode" && i + 1 < argc)
+            mode = argv[++i];
+        else if (arg == "--pin" && i + 1 < argc && parsePinPolicy(argv[i + 1], pin))
+            ++i;
+        else if (arg == "--first-touch" && i + 1 < argc)
+            firstTouch = std::string(argv[++i]) != "off";
+        else
+            rest.push_back(argv[i]);
+    }
+    if (mode != "strong" && mode != "weak" && mode != "both")
+    {
+        std::cerr << "Usage: " << argv[0] << " [--mode strong|weak|both] [--pin none|compact|scatter] [--first-touch on|off] [common options]\n";
+        printBenchUsage(argv[0]);
+        return 1;
+    }
+
+    int cores = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<int> allThreads;
+    for (int t = 1; t <= cores; ++t)
+        allThreads.push_back(t);
+    BenchOptions opt = parseBenchOptions(static_cast<int>(rest.size()), rest.data(), {}, allThreads);
+
+    // Every metric is relative to the single-thread run
+    std::sort(opt.threads.begin(), opt.threads.end());
+    opt.threads.erase(std::unique(opt.threads.begin(), opt.threads.end()), opt.threads.end());
+    if (opt.threads.empty() || opt.threads.front() != 1)
+        opt.threads.insert(opt.threads.begin(), 1);
+
+    std::vector<ScalingKernel> kernels = {{"mandelbrot", 512, true}, {"julia", 512, true}, {"pi", 4000000, false}};
+    std::vector<std::string> modes;
+    if (mode != "weak")
+        modes.push_back("strong");
+    if (mode != "strong")
+        modes.push_back("weak");
+
+    std::vector<ScalingPoint> points;
+    for (const ScalingKernel &k : kernels)
+    {
+        if (!benchKernelSelected(opt, k.name))
+            continue;
+        long base = opt.sizes.empty() ? k.baseSize : opt.sizes.front();
+
+        for (const std::string &m : modes)
+        {
+            double t1 = 0, w1 = 0;
+            for (int threads : opt.threads)
+            {
+                omp_set_num_threads(threads);
+                pinOpenMPThreads(pin);
+
+                // Weak scaling keeps the work per thread constant
+                long size = base;
+                if (m == "weak")
+                    size = k.image ? std::lround(base * std::sqrt((double)threads)) : base * threads;
+
+                ScalingPoint p;
+                p.kernel = k.name;
+                p.mode = m;
+                p.threads = threads;
+                p.size = size;
+
+                if (k.image)
+                {
+                    int side = static_cast<int>(size);
+                    PixelBuffer rgb(3 * side * side);
+                    if (firstTouch)
+                        firstTouchRows(rgb, 3 * side, side);
+                    else
+                        std::fill(rgb.begin(), rgb.end(), 0);
+
+                    double pixels = (double)side * side;
+                    if (k.name == "mandelbrot")
+                        p.result = runBench(k.name, size, threads, pixels, UNIT_PIXELS, opt, [&]
+                                            {
+                            generate_mandelbrot_parallel(side, side, -2.0f, 1.0f, -1.5f, 1.5f, rgb);
+                            benchDoNotOptimize(rgb[0]); });
+                    else
+                        p.result = runBench(k.name, size, threads, pixels, UNIT_PIXELS, opt, [&]
+                                            {
+                            julia_set::generate_julia_set_parallel(side, side, -2.0f, 2.0f, -2.0f, 2.0f, rgb);
+                            benchDoNotOptimize(rgb[0]); });
+                }
+                else
+                    p.result = runBench(k.name, size, threads, (double)size, UNIT_SAMPLES, opt, [&]
+                                        { benchDoNotOptimize(monte_carlo_parallel(size)); });
+
+                if (threads == 1)
+                {
+                    t1 = p.result.median;
+                    w1 = p.result.work;
+                }
+                else if (p.result.median > 0)
+                {
+                    p.speedup = (p.result.work / w1) * t1 / p.result.median;
+                    p.efficiency = p.speedup / threads;
+                    p.karpFlatt = (1.0 / p.speedup - 1.0 / threads) / (1.0 - 1.0 / threads);
+                }
+                points.push_back(p);
+            }
+        }
+    }
+
+    writeScaling(points, opt, pin, firstTouch);
+    return 0;
+}
@@ -0,0 +1,277 @@
+#pragma once
+
+// Auto-tuned kernel parameters, persisted per host.
+//
+// The first run of a kernel at a given size class times candidate
+// configurations (ISA variant, OpenMP thread count, dynamic-schedule chunk)
+// and stores the winner in a tuning cache keyed by CPU model. Later runs find
+// it there and start with no tuning delay.
+//
+//   TuningCache cache;
+//   TuneConfig cfg = autotune(cache, "mandelbrot", width * height, space,
+//                             [&](const TuneConfig &c) { ... run once with c ... });
+//
+// Environment:
+//   PP_TUNING_CACHE  cache file (default $XDG_CACHE_HOME/pp/tuning.tsv or ~/.cache/pp/tuning.tsv)
+//   PP_TUNE=off      never tune, use the first candidate of every dimension
+//   PP_TUNE=retune   ignore cached entries for this CPU and tune again
+
+#include <omp.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bench.hpp"
+
+struct TuneConfig
+{
+    std::string isa; // empty when the kernel has a single variant
+    int threads = 0; // OpenMP threads
+    int chunk = 0;   // schedule(dynamic, chunk) rows; 0 when the kernel has no chunked loop
+    double seconds = 0; // tuned time of one run
+};
+
+// Candidate values per dimension. The first entry of each is the untuned default.
+struct TuneSpace
+{
+    std::vector<std::string> isas;
+    std::vector<int> threads;
+    std::vector<int> chunks;
+};
+
+// Work grows by 4x per class, so one tuning covers e.g. every image from 512^2 to 1023^2
+inline int tuneSizeClass(double work)
+{
+    return work < 1 ? 0 : static_cast<int>(std::log2(work) / 2);
+}
+
+// All cores first, then halvings down to one thread
+inline std::vector<int> tuneThreadCandidates()
+{
+    int cores = std::max(1, omp_get_num_procs());
+    std::vector<int> threads = {cores};
+    for (int t = cores / 2; t >= 1; t /= 2)
+        threads.push_back(t);
+    return threads;
+}
+
+// Dynamic-schedule chunks that still leave every thread a few chunks of `items`
+inline std::vector<int> tuneChunkCandidates(int items, int maxThreads)
+{
+    std::vector<int> chunks = {1};
+    for (int c = 2; c <= 64 && c * 4 * maxThreads <= items; c *= 2)
+        chunks.push_back(c);
+    return chunks;
+}
+
+inline std::string defaultTuningCachePath()
+{
+    if (const char *path = std::getenv("PP_TUNING_CACHE"))
+        return path;
+    std::string dir;
+    if (const char *xdg = std::getenv("XDG_CACHE_HOME"))
+        dir = xdg;
+    else if (const char *home = std::getenv("HOME"))
+        dir = std::string(home) + "/.cache";
+    else
+        return "pp_tuning.tsv";
+    return dir + "/pp/tuning.tsv";
+}
+
+// Tab-separated: cpu, kernel, size class, isa, threads, chunk, seconds.
+// Entries of other CPUs are kept, so one file can serve a shared home directory.
+class TuningCache
+{
+public:
+    explicit TuningCache(const std::string &path = defaultTuningCachePath()) : path(path), cpu(benchCpuModel())
+    {
+        if (cpu.empty())
+            cpu = "unknown-cpu";
+        load();
+    }
+
+    bool lookup(const std::string &kernel, int sizeClass, TuneConfig &cfg) const
+    {
+        for (const Entry &e : entries)
+        {
+            if (e.cpu == cpu && e.kernel == kernel && e.sizeClass == sizeClass)
+            {
+                cfg = e.config;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Replace or add the entry and rewrite the file
+    void store(const std::string &kernel, int sizeClass, const TuneConfig &cfg)
+    {
+        bool found = false;
+        for (Entry &e : entries)
+        {
+            if (e.cpu == cpu && e.kernel == kernel && e.sizeClass == sizeClass)
+            {
+                e.config = cfg;
+                found = true;
+            }
+        }
+        if (!found)
+            entries.push_back({cpu, kernel, sizeClass, cfg});
+        save();
+    }
+
+    const std::string &filePath() const { return path; }
+    const std::string &cpuModel() const { return cpu; }
+
+private:
+    struct Entry
+    {
+        std::string cpu, kernel;
+        int sizeClass;
+        TuneConfig config;
+    };
+
+    void load()
+    {
+        std::ifstream in(path);
+        std::string line;
+        while (std::getline(in, line))
+        {
+            if (line.empty() || line[0] == '#')
+                continue;
+            std::vector<std::string> fields;
+            std::stringstream ss(line);
+            std::string field;
+            while (std::getline(ss, field, '\t'))
+                fields.push_back(field);
+            if (fields.size() != 7)
+                continue;
+
+            Entry e;
+            e.cpu = fields[0];
+            e.kernel = fields[1];
+            e.sizeClass = std::atoi(fields[2].c_str());
+            e.config.isa = fields[3] == "-" ? "" : fields[3];
+            e.config.threads = std::atoi(fields[4].c_str());
+            e.config.chunk = std::atoi(fields[5].c_str());
+            e.config.seconds = std::atof(fields[6].c_str());
+            entries.push_back(e);
+        }
+    }
+
+    // Written to a temporary file and renamed, so a concurrent reader never sees half a cache
+    void save() const
+    {
+        size_t slash = path.rfind('/');
+        if (slash != std::string::npos)
+            makeDirectories(path.substr(0, slash));
+
+        std::string tmp = path + ".tmp." + std::to_string(static_cast<long>(::getpid()));
+        FILE *out = std::fopen(tmp.c_str(), "w");
+        if (!out)
+        {
+            std::cerr << "Error opening file " << tmp << " for writing.\n";
+            return;
+        }
+        std::fprintf(out, "# pp tuning cache: cpu\tkernel\tsize_class\tisa\tthreads\tchunk\tseconds\n");
+        for (const Entry &e : entries)
+            std::fprintf(out, "%s\t%s\t%d\t%s\t%d\t%d\t%.6g\n", e.cpu.c_str(), e.kernel.c_str(), e.sizeClass,
+                         e.config.isa.empty() ? "-" : e.config.isa.c_str(), e.config.threads, e.config.chunk, e.config.seconds);
+        std::fclose(out);
+        if (std::rename(tmp.c_str(), path.c_str()) != 0)
+        {
+            std::cerr << "Error writing tuning cache " << path << "\n";
+            std::remove(tmp.c_str());
+        }
+    }
+
+    static void makeDirectories(const std::string &dir)
+    {
+        for (size_t pos = 1; pos <= dir.size(); ++pos)
+            if (pos == dir.size() || dir[pos] == '/')
+                ::mkdir(dir.substr(0, pos).c_str(), 0755);
+    }
+
+    std::string path, cpu;
+    std::vector<Entry> entries;
+};
+
+// Median of up to three timed runs; gives up after one run that is clearly
+// slower than the best so far
+template <class Run>
+inline double timeTuneCandidate(const TuneConfig &cfg, Run &run, double best)
+{
+    std::vector<double> times;
+    for (int trial = 0; trial < 3; ++trial)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        run(cfg);
+        times.push_back(std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count());
+        if (times.back() > 1.25 * best)
+            break;
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+// Cached configuration for (kernel, size class) on this CPU, or tune it now.
+// Tuning is a coordinate descent: ISA, then threads, then chunk, each swept
+// with the other dimensions held at their best value so far.
+template <class Run>
+inline TuneConfig autotune(TuningCache &cache, const std::string &kernel, double work, const TuneSpace &space, Run run)
+{
+    TuneConfig cfg;
+    cfg.isa = space.isas.empty() ? "" : space.isas.front();
+    cfg.threads = space.threads.empty() ? std::max(1, omp_get_num_procs()) : space.threads.front();
+    cfg.chunk = space.chunks.empty() ? 0 : space.chunks.front();
+
+    const char *mode = std::getenv("PP_TUNE");
+    std::string tuneMode = mode ? mode : "";
+    if (tuneMode == "off")
+        return cfg;
+
+    int sizeClass = tuneSizeClass(work);
+    TuneConfig cached;
+    if (tuneMode != "retune" && cache.lookup(kernel, sizeClass, cached))
+        return cached;
+
+    std::cerr << "[tune] " << kernel << " size class " << sizeClass << " on " << cache.cpuModel() << "..." << std::endl;
+    auto tuneStart = std::chrono::high_resolution_clock::now();
+
+    // One untimed run for page faults and lazy initialisation
+    run(cfg);
+    cfg.seconds = timeTuneCandidate(cfg, run, 1e300);
+
+    auto sweep = [&](auto values, auto field)
+    {
+        for (const auto &value : values)
+        {
+            if (cfg.*field == value)
+                continue;
+            TuneConfig candidate = cfg;
+            candidate.*field = value;
+            candidate.seconds = timeTuneCandidate(candidate, run, cfg.seconds);
+            if (candidate.seconds < cfg.seconds)
+                cfg = candidate;
+        }
+    };
+    sweep(space.isas, &TuneConfig::isa);
+    sweep(space.threads, &TuneConfig::threads);
+    sweep(space.chunks, &TuneConfig::chunk);
+
+    double tuneSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - tuneStart).count();
+    std::cerr << "[tune] " << kernel << ": " << (cfg.isa.empty() ? "" : cfg.isa + ", ") << cfg.threads << " threads"
+              << (cfg.chunk ? ", chunk " + std::to_string(cfg.chunk) : "") << " (" << cfg.seconds << " s/run, tuned in "
+              << tuneSeconds << " s) -> " << cache.filePath() << std::endl;
+    cache.store(kernel, sizeClass, cfg);
+    return cfg;
+}
@@ -0,0 +1,202 @@
+#pragma once
+
+// NUMA-aware first touch and thread pinning for the OpenMP kernels.
+//
+// Linux places a page on the NUMA node of the thread that first writes it, so
+// a buffer zero-filled by the main thread lives entirely on one node. Buffers
+// allocated with FirstTouchAllocator are left untouched at allocation, and
+// firstTouchRows() lets the OpenMP threads write their own rows first.
+//
+// Pinning policies (the topology comes from /sys, no libnuma needed):
+//   compact - fill one node's physical cores first, then their SMT siblings, then the next node
+//   scatter - round-robin over nodes, physical cores before SMT siblings
+
+#include <sched.h>
+#include <pthread.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <new>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// std::allocator that default-initialises instead of value-initialising, so
+// std::vector<unsigned char, FirstTouchAllocator<unsigned char>>(n) does not
+// write (and thereby place) its pages
+template <typename T>
+struct FirstTouchAllocator
+{
+    using value_type = T;
+
+    FirstTouchAllocator() = default;
+    template <typename U>
+    FirstTouchAllocator(const FirstTouchAllocator<U> &) {}
+
+    T *allocate(size_t n) { return static_cast<T *>(::operator new(n * sizeof(T))); }
+    void deallocate(T *p, size_t) { ::operator delete(p); }
+
+    template <typename U>
+    void construct(U *p) { ::new (static_cast<void *>(p)) U; }
+    template <typename U, typename... Args>
+    void construct(U *p, Args &&...args) { ::new (static_cast<void *>(p)) U(std::forward<Args>(args)...); }
+
+    template <typename U>
+    bool operator==(const FirstTouchAllocator<U> &) const { return true; }
+    template <typename U>
+    bool operator!=(const FirstTouchAllocator<U> &) const { return false; }
+};
+
+// Image buffer of the fractal kernels
+using PixelBuffer = std::vector<unsigned char, FirstTouchAllocator<unsigned char>>;
+
+// Zero `rows` rows of `rowBytes` each, split statically across the OpenMP
+// threads so each page is placed on the node of a thread that works on it
+template <typename Buffer>
+inline void firstTouchRows(Buffer &buffer, size_t rowBytes, size_t rows)
+{
+    unsigned char *data = reinterpret_cast<unsigned char *>(buffer.data());
+#pragma omp parallel for schedule(static)
+    for (long row = 0; row < (long)rows; ++row)
+        std::memset(data + row * rowBytes, 0, rowBytes);
+}
+
+struct CpuTopology
+{
+    int cpu;
+    int node;
+    int package;
+    int core;
+};
+
+inline int readSysInt(const std::string &path, int fallback)
+{
+    std::ifstream in(path);
+    int value;
+    return in >> value ? value : fallback;
+}
+
+// CPUs this process may run on, with their node, package and core ids
+inline std::vector<CpuTopology> readCpuTopology()
+{
+    namespace fs = std::filesystem;
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    sched_getaffinity(0, sizeof(allowed), &allowed);
+
+    std::vector<CpuTopology> cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+    {
+        if (!CPU_ISSET(cpu, &allowed))
+            continue;
+        std::string dir = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+        CpuTopology t{cpu, 0, readSysInt(dir + "/topology/physical_package_id", 0), readSysInt(dir + "/topology/core_id", cpu)};
+
+        std::error_code ec;
+        for (const auto &entry : fs::directory_iterator(dir, ec))
+        {
+            std::string name = entry.path().filename().string();
+            if (name.compare(0, 4, "node") == 0 && name.size() > 4 && isdigit(name[4]))
+                t.node = std::atoi(name.c_str() + 4);
+        }
+        cpus.push_back(t);
+    }
+    return cpus;
+}
+
+enum PinPolicy
+{
+    PIN_NONE,
+    PIN_COMPACT,
+    PIN_SCATTER
+};
+
+inline bool parsePinPolicy(const std::string &name, PinPolicy &policy)
+{
+    if (name == "none")
+        policy = PIN_NONE;
+    else if (name == "compact")
+        policy = PIN_COMPACT;
+    else if (name == "scatter")
+        policy = PIN_SCATTER;
+    else
+        return false;
+    return true;
+}
+
+inline const char *pinPolicyName(PinPolicy policy)
+{
+    return policy == PIN_COMPACT ? "compact" : policy == PIN_SCATTER ? "scatter" : "none";
+}
+
+// CPU for thread i is order[i % order.size()]
+inline std::vector<int> pinOrder(PinPolicy policy, const std::vector<CpuTopology> &cpus)
+{
+    // Rank physical cores within their node and SMT siblings within their core
+    std::map<std::tuple<int, int, int>, int> siblings; // (node, package, core) -> siblings seen
+    std::map<int, std::map<std::pair<int, int>, int>> coreRankOf; // node -> (package, core) -> rank
+    for (const CpuTopology &t : cpus)
+        coreRankOf[t.node].emplace(std::make_pair(t.package, t.core), 0);
+    for (auto &node : coreRankOf)
+    {
+        int rank = 0;
+        for (auto &core : node.second)
+            core.second = rank++;
+    }
+
+    std::vector<std::tuple<int, int, int, int>> keyed; // sort key (3 ints) + cpu
+    for (const CpuTopology &t : cpus)
+    {
+        int smt = siblings[std::make_tuple(t.node, t.package, t.core)]++;
+        int coreRank = coreRankOf[t.node][std::make_pair(t.package, t.core)];
+        if (policy == PIN_SCATTER)
+            keyed.emplace_back(smt, coreRank, t.node, t.cpu);
+        else
+            keyed.emplace_back(t.node, smt, coreRank, t.cpu);
+    }
+    std::sort(keyed.begin(), keyed.end());
+
+    std::vector<int> order;
+    for (const auto &k : keyed)
+        order.push_back(std::get<3>(k));
+    return order;
+}
+
+inline bool pinCurrentThread(const std::vector<int> &cpus)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus)
+        CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+// Pin the threads of the current OpenMP team size (set omp_set_num_threads first).
+// The runtime reuses its threads, so later parallel regions of the same size
+// keep the placement. PIN_NONE releases the threads onto every allowed CPU.
+inline void pinOpenMPThreads(PinPolicy policy)
+{
+    static const std::vector<CpuTopology> cpus = readCpuTopology();
+    std::vector<int> order = pinOrder(policy, cpus);
+    if (order.empty())
+        return;
+#pragma omp parallel
+    {
+        int thread = 0;
+#ifdef _OPENMP
+        thread = omp_get_thread_num();
+#endif
+        if (policy == PIN_NONE)
+            pinCurrentThread(order);
+        else
+            pinCurrentThread({order[thread % order.size()]});
+    }
+}
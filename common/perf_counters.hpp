@@ -0,0 +1,297 @@
+#pragma once
+
+// Hardware performance counters for named kernel regions (Linux perf_event_open).
+//
+// Compiled out unless PP_PERF is defined: PERF_REGION / PERF_REGION_ADD expand
+// to nothing and their arguments are never evaluated. With -DPP_PERF every
+// thread that enters a region lazily opens its own counters (user space only),
+// each region execution is accumulated per (region, thread), and a report is
+// printed to stderr at exit (or to the file named by $PP_PERF_OUT):
+// cycles, instructions, IPC, LLC misses, branch mispredicts, page faults,
+// nominal bandwidth (annotated bytes / time), LLC-miss bandwidth (64 B per
+// miss / time) and arithmetic intensity (annotated ops / byte). Counters the
+// kernel or hypervisor does not expose are reported as "-".
+//
+//   PERF_REGION("absDiff_SIMD", bytesTouched, opsPerformed);
+//   ...
+//   PERF_REGION_ADD(0, extraOps); // work only known at the end of the region
+
+#ifdef PP_PERF
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+
+enum PerfEvent
+{
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_LLC_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_PAGE_FAULTS,
+    PERF_EVENT_COUNT
+};
+
+struct PerfTotals
+{
+    long calls = 0;
+    double seconds = 0;
+    double bytes = 0; // annotated memory traffic
+    double ops = 0;   // annotated arithmetic operations (flops or integer ops)
+    double counts[PERF_EVENT_COUNT] = {};
+    bool valid[PERF_EVENT_COUNT] = {};
+
+    void merge(const PerfTotals &o)
+    {
+        calls += o.calls;
+        seconds = std::max(seconds, o.seconds); // threads overlap in time
+        bytes += o.bytes;
+        ops += o.ops;
+        for (int e = 0; e < PERF_EVENT_COUNT; ++e)
+        {
+            counts[e] += o.counts[e];
+            valid[e] = valid[e] || o.valid[e];
+        }
+    }
+};
+
+// One counter per event for the calling thread. Events are opened separately
+// (not as a group) so an unsupported one does not disable the others;
+// multiplexed counts are scaled by time enabled / time running.
+class PerfThreadCounters
+{
+public:
+    PerfThreadCounters()
+    {
+        static std::atomic<int> nextId(0);
+        id = nextId.fetch_add(1);
+
+        const std::pair<uint32_t, uint64_t> events[PERF_EVENT_COUNT] = {
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+            {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS}};
+
+        for (int e = 0; e < PERF_EVENT_COUNT; ++e)
+        {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = events[e].first;
+            attr.config = events[e].second;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            fd[e] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+    }
+
+    ~PerfThreadCounters()
+    {
+        for (int e = 0; e < PERF_EVENT_COUNT; ++e)
+            if (fd[e] >= 0)
+                close(fd[e]);
+    }
+
+    // Scaled counter values; false where the event is unavailable
+    void read(double values[PERF_EVENT_COUNT], bool valid[PERF_EVENT_COUNT]) const
+    {
+        for (int e = 0; e < PERF_EVENT_COUNT; ++e)
+        {
+            uint64_t buf[3]; // value, time enabled, time running
+            valid[e] = fd[e] >= 0 && ::read(fd[e], buf, sizeof(buf)) == sizeof(buf);
+            values[e] = valid[e] && buf[2] > 0 ? buf[0] * ((double)buf[1] / buf[2]) : 0.0;
+        }
+    }
+
+    int id;
+
+private:
+    int fd[PERF_EVENT_COUNT];
+};
+
+class PerfRegistry
+{
+public:
+    static PerfRegistry &instance()
+    {
+        static PerfRegistry registry;
+        return registry;
+    }
+
+    void record(const std::string &name, int thread, const PerfTotals &t)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        PerfTotals &total = totals[std::make_pair(name, thread)];
+        total.calls += t.calls;
+        total.seconds += t.seconds;
+        total.bytes += t.bytes;
+        total.ops += t.ops;
+        for (int e = 0; e < PERF_EVENT_COUNT; ++e)
+        {
+            total.counts[e] += t.counts[e];
+            total.valid[e] = total.valid[e] || t.valid[e];
+        }
+    }
+
+    void report(FILE *out)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (totals.empty())
+            return;
+
+        std::fprintf(out, "\n%-32s %6s %8s %10s %12s %12s %6s %11s %11s %8s %9s %9s %8s\n",
+                     "region", "thread", "calls", "seconds", "cycles", "instructions", "IPC",
+                     "LLC-misses", "br-misses", "faults", "GB/s", "LLC-GB/s", "ops/B");
+
+        std::string current;
+        PerfTotals all;
+        int threads = 0;
+        for (const auto &entry : totals)
+        {
+            if (entry.first.first != current)
+            {
+                if (threads > 1)
+                    printRow(out, current, "all", all);
+                current = entry.first.first;
+                all = PerfTotals();
+                threads = 0;
+            }
+            printRow(out, current, std::to_string(entry.first.second), entry.second);
+            all.merge(entry.second);
+            threads++;
+        }
+        if (threads > 1)
+            printRow(out, current, "all", all);
+
+        std::fprintf(out, "GB/s = annotated bytes / time; LLC-GB/s = 64 B per LLC miss / time; ops/B = arithmetic intensity.\n"
+                          "\"all\" rows sum the threads' counts over the longest thread's time.\n"
+                          "Regions well below the machine balance (peak ops/s / peak bytes/s) are memory-bound, well above it compute-bound.\n");
+    }
+
+    ~PerfRegistry()
+    {
+        const char *path = std::getenv("PP_PERF_OUT");
+        FILE *out = path ? std::fopen(path, "w") : stderr;
+        if (!out)
+            out = stderr;
+        report(out);
+        if (out != stderr)
+            std::fclose(out);
+    }
+
+private:
+    static void printCount(FILE *out, int width, const PerfTotals &t, PerfEvent e)
+    {
+        if (t.valid[e])
+            std::fprintf(out, " %*.0f", width, t.counts[e]);
+        else
+            std::fprintf(out, " %*s", width, "-");
+    }
+
+    static void printRow(FILE *out, const std::string &name, const std::string &thread, const PerfTotals &t)
+    {
+        std::fprintf(out, "%-32s %6s %8ld %10.6f", name.c_str(), thread.c_str(), t.calls, t.seconds);
+        printCount(out, 12, t, PERF_CYCLES);
+        printCount(out, 12, t, PERF_INSTRUCTIONS);
+        if (t.valid[PERF_CYCLES] && t.valid[PERF_INSTRUCTIONS] && t.counts[PERF_CYCLES] > 0)
+            std::fprintf(out, " %6.2f", t.counts[PERF_INSTRUCTIONS] / t.counts[PERF_CYCLES]);
+        else
+            std::fprintf(out, " %6s", "-");
+        printCount(out, 11, t, PERF_LLC_MISSES);
+        printCount(out, 11, t, PERF_BRANCH_MISSES);
+        printCount(out, 8, t, PERF_PAGE_FAULTS);
+
+        double seconds = t.seconds > 0 ? t.seconds : 1e-12;
+        std::fprintf(out, " %9.2f", t.bytes / seconds * 1e-9);
+        if (t.valid[PERF_LLC_MISSES])
+            std::fprintf(out, " %9.2f", t.counts[PERF_LLC_MISSES] * 64 / seconds * 1e-9);
+        else
+            std::fprintf(out, " %9s", "-");
+        if (t.bytes > 0)
+            std::fprintf(out, " %8.3f\n", t.ops / t.bytes);
+        else
+            std::fprintf(out, " %8s\n", "-");
+    }
+
+    std::mutex mutex;
+    std::map<std::pair<std::string, int>, PerfTotals> totals;
+};
+
+// Measures the enclosing scope on the calling thread
+class PerfRegion
+{
+public:
+    PerfRegion(const char *name, double bytes, double ops) : name(name)
+    {
+        PerfRegistry::instance(); // constructed first, so it outlives the thread-local counters
+        totals.calls = 1;
+        totals.bytes = bytes;
+        totals.ops = ops;
+        counters().read(startCounts, totals.valid);
+        start = std::chrono::steady_clock::now();
+    }
+
+    ~PerfRegion()
+    {
+        totals.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double endCounts[PERF_EVENT_COUNT];
+        bool endValid[PERF_EVENT_COUNT];
+        PerfThreadCounters &c = counters();
+        c.read(endCounts, endValid);
+        for (int e = 0; e < PERF_EVENT_COUNT; ++e)
+        {
+            totals.valid[e] = totals.valid[e] && endValid[e];
+            totals.counts[e] = totals.valid[e] ? endCounts[e] - startCounts[e] : 0.0;
+        }
+        PerfRegistry::instance().record(name, c.id, totals);
+    }
+
+    void add(double bytes, double ops)
+    {
+        totals.bytes += bytes;
+        totals.ops += ops;
+    }
+
+private:
+    static PerfThreadCounters &counters()
+    {
+        thread_local PerfThreadCounters perThread;
+        return perThread;
+    }
+
+    const char *name;
+    PerfTotals totals;
+    double startCounts[PERF_EVENT_COUNT];
+    std::chrono::steady_clock::time_point start;
+};
+
+#define PERF_REGION(name, bytes, ops) PerfRegion perfRegion_((name), (bytes), (ops))
+#define PERF_REGION_ADD(bytes, ops) perfRegion_.add((bytes), (ops))
+
+#else
+
+// sizeof keeps the arguments "used" without evaluating them
+#define PERF_REGION(name, bytes, ops)           \
+    do                                          \
+    {                                           \
+        (void)sizeof(bytes), (void)sizeof(ops); \
+    } while (0)
+#define PERF_REGION_ADD(bytes, ops)             \
+    do                                          \
+    {                                           \
+        (void)sizeof(bytes), (void)sizeof(ops); \
+    } while (0)
+
+#endif
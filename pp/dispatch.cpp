@@ -0,0 +1,127 @@
+// Run-time selection among the ISA variants built into libppkernels.
+// CMake defines PP_HAVE_<ISA> for every variant it compiled.
+
+#include "pp_kernels.hpp"
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+
+#ifdef PP_HAVE_SSE42
+const PPKernelTable *ppKernelTable_sse42();
+#endif
+#ifdef PP_HAVE_AVX2
+const PPKernelTable *ppKernelTable_avx2();
+#endif
+#ifdef PP_HAVE_AVX512
+const PPKernelTable *ppKernelTable_avx512();
+#endif
+
+namespace
+{
+
+struct Variant
+{
+    const PPKernelTable *(*table)();
+    bool (*supported)();
+};
+
+[[maybe_unused]] bool supportsSSE42() { return __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt"); }
+
+// Every extension in the variant's PP_ISA_FLAGS_<isa>: the compiler may use any
+// of them, and a VM can mask one while passing the rest through
+[[maybe_unused]] bool supportsAVX2()
+{
+    return supportsSSE42() && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") &&
+           __builtin_cpu_supports("bmi") && __builtin_cpu_supports("bmi2") && __builtin_cpu_supports("lzcnt") &&
+           __builtin_cpu_supports("f16c");
+}
+
+[[maybe_unused]] bool supportsAVX512()
+{
+    return supportsAVX2() && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+           __builtin_cpu_supports("avx512vl") && __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512cd");
+}
+
+// Narrowest first
+const std::vector<Variant> &variants()
+{
+    static const std::vector<Variant> all = {
+#ifdef PP_HAVE_SSE42
+        {ppKernelTable_sse42, supportsSSE42},
+#endif
+#ifdef PP_HAVE_AVX2
+        {ppKernelTable_avx2, supportsAVX2},
+#endif
+#ifdef PP_HAVE_AVX512
+        {ppKernelTable_avx512, supportsAVX512},
+#endif
+    };
+    return all;
+}
+
+std::mutex selectionMutex;
+const PPKernelTable *selected = nullptr;
+bool resolved = false;
+
+const PPKernelTable *findSupported(const std::string &isa)
+{
+    for (const PPKernelTable *table : ppSupportedKernels())
+        if (isa == table->isa)
+            return table;
+    return nullptr;
+}
+
+} // namespace
+
+std::vector<const PPKernelTable *> ppSupportedKernels()
+{
+    std::vector<const PPKernelTable *> tables;
+    for (const Variant &v : variants())
+        if (v.supported())
+            tables.push_back(v.table());
+    return tables;
+}
+
+bool ppSelectISA(const std::string &isa)
+{
+    const PPKernelTable *table = findSupported(isa);
+    if (!table)
+        return false;
+    std::lock_guard<std::mutex> lock(selectionMutex);
+    selected = table;
+    resolved = true;
+    return true;
+}
+
+const PPKernelTable *ppKernelsOrNull()
+{
+    std::lock_guard<std::mutex> lock(selectionMutex);
+    if (!resolved)
+    {
+        resolved = true;
+        std::vector<const PPKernelTable *> tables = ppSupportedKernels();
+        selected = tables.empty() ? nullptr : tables.back();
+
+        const char *forced = std::getenv("PP_ISA");
+        if (forced && *forced)
+        {
+            if (const PPKernelTable *table = findSupported(forced))
+                selected = table;
+            else
+                std::cerr << "PP_ISA=" << forced << " is not built or not supported by this CPU; using "
+                          << (selected ? selected->isa : "none") << std::endl;
+        }
+    }
+    return selected;
+}
+
+const PPKernelTable &ppKernels()
+{
+    const PPKernelTable *table = ppKernelsOrNull();
+    if (!table)
+    {
+        std::cerr << "libppkernels: this CPU supports none of the built variants (SSE4.2 or newer required)" << std::endl;
+        std::exit(1);
+    }
+    return *table;
+}
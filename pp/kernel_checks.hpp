@@ -0,0 +1,577 @@
+#pragma once
+
+// Fuzzed checks of every optimised kernel against its serial reference.
+//
+// kernels_isa.cpp includes this inside each variant's namespace, so every ISA
+// variant checks its own code generation; the system and OpenCV headers are
+// the ones kernels_isa.cpp pulls in first. Sizes, alignments, row strides and
+// value ranges are drawn at random. Inputs are copied into exactly sized
+// buffers, so an ASan build (PP_SANITIZE) flags reads past the end.
+
+struct KernelCheck
+{
+    struct Tally
+    {
+        int cases = 0, failures = 0;
+    };
+
+    std::mt19937 gen;
+    bool verbose;
+    std::vector<std::pair<std::string, Tally>> tallies; // in first-use order
+
+    KernelCheck(unsigned seed, bool verbose) : gen(seed), verbose(verbose) {}
+
+    int uniform(int lo, int hi) { return std::uniform_int_distribution<int>(lo, hi)(gen); }
+    float uniformf(float lo, float hi) { return std::uniform_real_distribution<float>(lo, hi)(gen); }
+
+    // Sizes near SIMD block boundaries are drawn more often than the rest
+    int length(int maxLength)
+    {
+        static const int edges[] = {0, 1, 3, 4, 5, 15, 16, 17, 31, 32, 33, 47, 48, 49, 63, 64, 65};
+        if (uniform(0, 2) == 0)
+        {
+            int e = edges[uniform(0, sizeof(edges) / sizeof(edges[0]) - 1)];
+            if (e <= maxLength)
+                return e;
+        }
+        return uniform(0, maxLength);
+    }
+
+    void expect(bool ok, const std::string &kernel, const std::string &detail)
+    {
+        Tally *t = nullptr;
+        for (auto &entry : tallies)
+            if (entry.first == kernel)
+                t = &entry.second;
+        if (!t)
+        {
+            tallies.push_back({kernel, Tally()});
+            t = &tallies.back().second;
+        }
+        ++t->cases;
+        if (!ok)
+        {
+            ++t->failures;
+            if (verbose || t->failures <= 3)
+                std::cerr << "  FAIL " << kernel << ": " << detail << "\n";
+        }
+    }
+
+    int failures() const
+    {
+        int total = 0;
+        for (const auto &entry : tallies)
+            total += entry.second.failures;
+        return total;
+    }
+};
+
+inline std::string checkSize(int rows, int cols)
+{
+    return std::to_string(rows) + "x" + std::to_string(cols);
+}
+
+// Index of the first differing byte, or -1
+inline long firstMismatch(const unsigned char *a, const unsigned char *b, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+        if (a[i] != b[i])
+            return static_cast<long>(i);
+    return -1;
+}
+
+// ---- CA_1 Q2: mean / standard deviation and z-score outliers ----------------
+
+inline void checkOutliers(KernelCheck &check)
+{
+    int size = check.length(check.uniform(0, 3) ? 64 : 4099);
+    if (size == 0)
+        size = 1;
+    int offset = check.uniform(0, 3); // misaligns the start by whole floats
+
+    // Normal data at a random location and scale, constant data, or sparse spikes
+    std::vector<float> storage(offset + size);
+    float *data = storage.data() + offset;
+    int shape = check.uniform(0, 2);
+    float location = check.uniformf(-100.0f, 100.0f), scale = check.uniformf(0.01f, 100.0f);
+    std::normal_distribution<float> normal(location, scale);
+    for (int i = 0; i < size; ++i)
+    {
+        if (shape == 0)
+            data[i] = normal(check.gen);
+        else if (shape == 1)
+            data[i] = location;
+        else
+            data[i] = check.uniform(0, 20) == 0 ? location + 50 * scale : location;
+    }
+
+    float meanSerial, stdSerial, meanSimd, stdSimd;
+    meanAndSTD_Serial(data, size, &meanSerial, &stdSerial);
+    meanAndSTD_Parallel(data, size, &meanSimd, &stdSimd);
+
+    // Both sum in float, in different orders: allow the usual n * eps error bound
+    double meanAbs = 0;
+    for (int i = 0; i < size; ++i)
+        meanAbs += std::fabs(data[i]);
+    meanAbs /= size;
+    double bound = (size * 1.2e-7 + 1e-5) * meanAbs + 1e-30;
+    check.expect(std::fabs(meanSerial - meanSimd) <= bound, "meanAndSTD_Parallel",
+                 "size " + std::to_string(size) + " mean " + std::to_string(meanSimd) + " vs " + std::to_string(meanSerial));
+    check.expect(std::fabs(stdSerial - stdSimd) <= 1e-3 * stdSerial + 2 * bound, "meanAndSTD_Parallel",
+                 "size " + std::to_string(size) + " stddev " + std::to_string(stdSimd) + " vs " + std::to_string(stdSerial));
+
+    // With the same mean and deviation the counts must agree exactly
+    int serial = countOutliers_Serial(data, size, meanSerial, stdSerial);
+    int simd = countOutliers_Parallel(data, size, meanSerial, stdSerial);
+    check.expect(serial == simd, "countOutliers_Parallel",
+                 "size " + std::to_string(size) + ": " + std::to_string(simd) + " vs " + std::to_string(serial));
+}
+
+// Column statistics and per-column thresholds of the columnar table, fused and
+// tiled, against the double-precision two-pass reference
+inline void checkColumnar(KernelCheck &check)
+{
+    size_t rows = std::max(1, check.length(check.uniform(0, 3) ? 64 : 1000));
+    size_t cols = check.uniform(1, 12);
+    ColumnTable table(rows, cols);
+    std::vector<float> thresholds(check.uniform(0, (int)cols)); // shorter: THRESHOLD for the rest
+    for (float &t : thresholds)
+        t = check.uniformf(0.5f, 4.0f);
+    for (size_t c = 0; c < cols; ++c)
+    {
+        int shape = check.uniform(0, 2);
+        float location = check.uniformf(-1000.0f, 1000.0f), scale = check.uniformf(0.01f, 100.0f);
+        std::normal_distribution<float> normal(location, scale);
+        float *col = table.column(c);
+        for (size_t r = 0; r < rows; ++r)
+        {
+            if (shape == 0)
+                col[r] = normal(check.gen);
+            else if (shape == 1)
+                col[r] = location;
+            else
+                col[r] = check.uniform(0, 20) == 0 ? location + 50 * scale : location;
+        }
+    }
+
+    std::vector<ColumnStats> serial = columnOutliers_Serial(table, thresholds);
+    for (int tiled = 0; tiled <= 1; ++tiled)
+    {
+        ColumnarOptions opt;
+        opt.forceTiled = tiled;
+        if (tiled)
+            opt.chunkRows = COLUMN_ALIGN_ROWS * check.uniform(1, 8); // several tiles per column
+        std::vector<ColumnStats> simd = columnOutliers_Parallel(table, thresholds, opt);
+        std::string kernel = tiled ? "columnOutliers_Parallel (tiled)" : "columnOutliers_Parallel";
+
+        for (size_t c = 0; c < cols; ++c)
+        {
+            const float *col = table.column(c);
+            std::string where = checkSize((int)rows, (int)cols) + " column " + std::to_string(c);
+
+            // Float partial sums against double: the n * eps bound of checkOutliers
+            double meanAbs = 0;
+            for (size_t r = 0; r < rows; ++r)
+                meanAbs += std::fabs(col[r]);
+            meanAbs /= rows;
+            double bound = (rows * 1.2e-7 + 1e-5) * meanAbs + 1e-30;
+            check.expect(std::fabs(simd[c].mean - serial[c].mean) <= bound, kernel,
+                         where + " mean " + std::to_string(simd[c].mean) + " vs " + std::to_string(serial[c].mean));
+            check.expect(std::fabs(simd[c].stddev - serial[c].stddev) <= 1e-3 * serial[c].stddev + 2 * bound, kernel,
+                         where + " stddev " + std::to_string(simd[c].stddev) + " vs " + std::to_string(serial[c].stddev));
+
+            // With the kernel's own mean and deviation the count must be exact
+            float limit = (c < thresholds.size() ? thresholds[c] : (float)THRESHOLD) * simd[c].stddev;
+            long expected = 0;
+            for (size_t r = 0; r < rows; ++r)
+                expected += fabsf(col[r] - simd[c].mean) > limit;
+            check.expect(simd[c].outliers == expected, kernel,
+                         where + " outliers " + std::to_string(simd[c].outliers) + " vs " + std::to_string(expected));
+        }
+    }
+}
+
+// ---- CA_1 Q3: run-length encoding -----------------------------------------------
+
+inline void checkRle(KernelCheck &check)
+{
+    // Runs of random length over a small alphabet, so runs cross 16-byte blocks
+    int length = check.length(check.uniform(0, 3) ? 80 : 600);
+    int alphabet = check.uniform(1, 4);
+    int maxRun = check.uniform(0, 1) ? 4 : 40;
+    std::string input;
+    while ((int)input.size() < length)
+    {
+        char c = static_cast<char>(check.uniform(0, 3) == 0 ? check.uniform(-128, 127) : 'a' + check.uniform(0, alphabet - 1));
+        input.append(std::min(check.uniform(1, maxRun), length - (int)input.size()), c);
+    }
+
+    std::string serial = rle_compress_serial(input);
+    std::string simd = rle_compress_simd(input);
+    check.expect(serial == simd, "rle_compress_simd", "length " + std::to_string(length) + ": \"" + simd.substr(0, 40) + "\" vs \"" + serial.substr(0, 40) + "\"");
+}
+
+// Random runs of 0 and 1 pixels (some longer than a word), exactly sized
+inline std::vector<unsigned char> checkMask(KernelCheck &check, int length)
+{
+    std::vector<unsigned char> mask;
+    int maxRun = check.uniform(0, 1) ? 5 : 150;
+    unsigned char on = static_cast<unsigned char>(check.uniform(1, 255));
+    bool value = check.uniform(0, 1);
+    while ((int)mask.size() < length)
+    {
+        mask.insert(mask.end(), std::min(check.uniform(1, maxRun), length - (int)mask.size()), value ? on : 0);
+        value = !value;
+    }
+    return mask;
+}
+
+inline void checkBitRle(KernelCheck &check)
+{
+    int length = check.length(check.uniform(0, 3) ? 200 : 3000);
+    std::vector<unsigned char> a = checkMask(check, length);
+    std::vector<unsigned char> b = checkMask(check, check.uniform(0, 3) ? length : check.length(3000));
+    std::string size = "length " + std::to_string(a.size()) + " / " + std::to_string(b.size());
+
+    std::vector<uint64_t> packedA = pack_mask_simd(a.data(), a.size()), packedB = pack_mask_simd(b.data(), b.size());
+    check.expect(packedA == pack_mask_serial(a.data(), a.size()), "pack_mask_simd", size);
+
+    std::string rleA = bitrle_encode(packedA, a.size()), rleB = bitrle_encode(packedB, b.size());
+    check.expect(rleA == bitrle_encode_serial(a.data(), a.size()), "bitrle_encode", size);
+    check.expect(bitrle_encoded_size(packedA, a.size()) == rleA.size(), "bitrle_encoded_size", size);
+    size_t n;
+    check.expect(bitrle_decode(rleA, n) == packedA && n == a.size(), "bitrle_decode", size);
+
+    // Set operations on the runs against the same operations on the words
+    size_t words = std::max(packedA.size(), packedB.size()), pixels = std::max(a.size(), b.size());
+    packedA.resize(words, 0);
+    packedB.resize(words, 0);
+    std::vector<uint64_t> both(words), either(words);
+    for (size_t w = 0; w < words; ++w)
+    {
+        both[w] = packedA[w] & packedB[w];
+        either[w] = packedA[w] | packedB[w];
+    }
+    check.expect(bitrle_and(rleA, rleB) == bitrle_encode(both, pixels), "bitrle_and", size);
+    check.expect(bitrle_or(rleA, rleB) == bitrle_encode(either, pixels), "bitrle_or", size);
+}
+
+// ---- CA_1: resampling -------------------------------------------------------------------
+
+inline void checkResample(KernelCheck &check)
+{
+    static const int channelCounts[] = {1, 3, 4};
+    static const char *filterNames[] = {"bilinear", "area", "lanczos3"};
+    int inW = check.uniform(1, 80), inH = check.uniform(1, 40), outW = check.uniform(1, 80), outH = check.uniform(1, 40);
+    int cn = channelCounts[check.uniform(0, 2)];
+    ResampleFilter filter = (ResampleFilter)check.uniform(0, 2);
+    std::string size = checkSize(inH, inW) + " -> " + checkSize(outH, outW) + " x" + std::to_string(cn) + " " + filterNames[filter];
+
+    // Weights sum to 1.0 and windows stay inside the input
+    ResampleAxis ax = makeResampleAxis(inW, outW, filter), ay = makeResampleAxis(inH, outH, filter);
+    bool tables = true;
+    for (const ResampleAxis *axis : {&ax, &ay})
+        for (int i = 0; i < axis->outSize; ++i)
+        {
+            int sum = 0;
+            for (int k = 0; k < axis->taps; ++k)
+                sum += axis->weights[(size_t)i * axis->taps + k];
+            tables &= sum == 1 << RESAMPLE_BITS && axis->start[i] >= 0 && axis->start[i] + axis->taps <= axis->inSize;
+        }
+    check.expect(tables, "makeResampleAxis", size);
+
+    size_t srcStep = (size_t)inW * cn + check.uniform(0, 16), dstStep = (size_t)outW * cn;
+    std::vector<unsigned char> src((inH - 1) * srcStep + (size_t)inW * cn);
+    for (unsigned char &v : src)
+        v = (unsigned char)check.uniform(0, 255);
+    std::vector<unsigned char> serial(outH * dstStep), simd(outH * dstStep), scratch;
+    resampleBand(src.data(), srcStep, serial.data(), dstStep, cn, ax, ay, 0, outH, scratch, false);
+    // Two bands, as the threaded front end splits them
+    int split = check.uniform(0, outH);
+    resampleBand(src.data(), srcStep, simd.data(), dstStep, cn, ax, ay, 0, split, scratch, true);
+    resampleBand(src.data(), srcStep, simd.data(), dstStep, cn, ax, ay, split, outH, scratch, true);
+    check.expect(serial == simd, "resampleBand SIMD", size);
+}
+
+// ---- CA_2: fractals ---------------------------------------------------------------------
+
+inline void checkFractals(KernelCheck &check)
+{
+    int width = check.uniform(1, 48), height = check.uniform(1, 48);
+    int chunk = check.uniform(1, 8);
+    float cx = check.uniformf(-1.5f, 0.5f), cy = check.uniformf(-1.0f, 1.0f), r = check.uniformf(0.01f, 1.5f);
+
+    PixelBuffer serial(3 * width * height), parallel(3 * width * height);
+    generate_mandelbrot_serial(width, height, cx - r, cx + r, cy - r, cy + r, serial);
+    generate_mandelbrot_parallel(width, height, cx - r, cx + r, cy - r, cy + r, parallel, chunk);
+    long at = firstMismatch(serial.data(), parallel.data(), serial.size());
+    check.expect(at < 0, "generate_mandelbrot_parallel", checkSize(height, width) + " chunk " + std::to_string(chunk) + ", byte " + std::to_string(at));
+
+    julia_set::generate_julia_set_serial(width, height, cx - r, cx + r, cy - r, cy + r, serial);
+    julia_set::generate_julia_set_parallel(width, height, cx - r, cx + r, cy - r, cy + r, parallel, chunk);
+    at = firstMismatch(serial.data(), parallel.data(), serial.size());
+    check.expect(at < 0, "generate_julia_set_parallel", checkSize(height, width) + " chunk " + std::to_string(chunk) + ", byte " + std::to_string(at));
+}
+
+// SIMD orbits with lane refills and per-thread histograms against the scalar,
+// shared-histogram reference; symmetric (folded) views and others
+inline void checkBuddhabrot(KernelCheck &check)
+{
+    int width = check.uniform(1, 40), height = check.uniform(1, 40);
+    float cx = check.uniformf(-1.5f, 0.5f), r = check.uniformf(0.05f, 1.5f);
+    float cy = check.uniform(0, 1) ? 0.0f : check.uniformf(-1.0f, 1.0f);
+    BuddhabrotOptions opt;
+    opt.samples = check.uniform(0, 3000);
+    opt.maxIterations = check.uniform(1, 200);
+    opt.minIterations = check.uniform(0, 4);
+    opt.gridSize = check.uniform(1, 32);
+    opt.boundaryIterations = check.uniform(1, 64);
+    opt.farWeight = check.uniform(1, 8);
+    opt.importance = check.uniform(0, 1);
+    opt.batchSamples = check.uniform(1, 1000);
+    opt.seed = check.uniform(0, 1000);
+    BuddhabrotSampler sampler = make_buddhabrot_sampler(opt);
+
+    std::vector<uint64_t> serial, simd;
+    opt.simd = false;
+    opt.histograms = BUDDHA_SHARED_ATOMIC;
+    generate_buddhabrot(width, height, cx - r, cx + r, cy - r, cy + r, serial, sampler, opt);
+    opt.simd = true;
+    opt.histograms = BUDDHA_PRIVATE;
+    generate_buddhabrot(width, height, cx - r, cx + r, cy - r, cy + r, simd, sampler, opt);
+    check.expect(serial == simd, "generate_buddhabrot", checkSize(height, width) + ", " + std::to_string(opt.samples) + " samples");
+}
+
+#ifdef PP_WITH_OPENCV
+// ---- CA_1 Q1 / Q4: OpenCV kernels ---------------------------------------------------
+
+inline void fillRandom(KernelCheck &check, std::vector<uchar> &bytes)
+{
+    // Full range, or only values next to 0, 128 and 255 where saturation and sign bugs show
+    static const uchar edges[] = {0, 1, 2, 126, 127, 128, 129, 253, 254, 255};
+    bool full = check.uniform(0, 1) == 0;
+    for (uchar &b : bytes)
+        b = full ? static_cast<uchar>(check.uniform(0, 255)) : edges[check.uniform(0, sizeof(edges) - 1)];
+}
+
+// A rows x cols matrix over an exactly sized buffer, with `pad` bytes between rows
+inline cv::Mat stridedMat(std::vector<uchar> &storage, int rows, int cols, int channels, int pad)
+{
+    size_t step = (size_t)cols * channels + pad;
+    storage.resize(rows ? step * (rows - 1) + (size_t)cols * channels : 0);
+    return cv::Mat(rows, cols, CV_MAKETYPE(CV_8U, channels), storage.data(), step);
+}
+
+inline void checkAbsDiff(KernelCheck &check)
+{
+    int rows = check.uniform(1, 6), cols = std::max(1, check.length(70)), pad = check.uniform(0, 3);
+    std::vector<uchar> a, b;
+    cv::Mat src1 = stridedMat(a, rows, cols, 1, pad), src2 = stridedMat(b, rows, cols, 1, pad);
+    fillRandom(check, a);
+    fillRandom(check, b);
+
+    cv::Mat serial, simd;
+    absDiff_Serial(src1, src2, serial);
+    absDiff_SIMD(src1, src2, simd);
+    bool same = true;
+    for (int row = 0; row < rows && same; ++row)
+        same = firstMismatch(serial.ptr<uchar>(row), simd.ptr<uchar>(row), cols) < 0;
+    check.expect(same, "absDiff_SIMD", checkSize(rows, cols));
+}
+
+inline void checkBlendRows(KernelCheck &check, bool avx2)
+{
+    int nBytes = 3 * check.length(70);
+    float alpha[3] = {check.uniformf(0.0f, 1.0f), check.uniformf(0.0f, 1.0f), check.uniformf(0.0f, 1.0f)};
+    if (check.uniform(0, 1))
+        alpha[1] = alpha[2] = alpha[0];
+    BlendWeights w = makeBlendWeights(alpha);
+    if (!w.exact)
+        return;
+
+    std::vector<uchar> src1(nBytes), src2(nBytes), expected(nBytes);
+    fillRandom(check, src1);
+    fillRandom(check, src2);
+    for (int i = 0; i < nBytes; ++i)
+    {
+        int merged = src1[i] + static_cast<int>(src2[i] * alpha[i % 3]);
+        expected[i] = static_cast<uchar>(merged > 255 ? 255 : merged);
+    }
+
+    std::vector<uchar> out(nBytes);
+    blendRow_Scalar(src1.data(), src2.data(), out.data(), nBytes, 0, w);
+    check.expect(firstMismatch(expected.data(), out.data(), nBytes) < 0, "blendRow_Scalar", std::to_string(nBytes) + " bytes");
+    blendRow_SSE(src1.data(), src2.data(), out.data(), nBytes, w);
+    check.expect(firstMismatch(expected.data(), out.data(), nBytes) < 0, "blendRow_SSE", std::to_string(nBytes) + " bytes");
+    if (avx2)
+    {
+        blendRow_AVX2(src1.data(), src2.data(), out.data(), nBytes, w);
+        check.expect(firstMismatch(expected.data(), out.data(), nBytes) < 0, "blendRow_AVX2", std::to_string(nBytes) + " bytes");
+    }
+}
+
+inline void checkCompositeRows(KernelCheck &check, bool avx2)
+{
+    int pixels = check.length(70);
+    AlphaMode mode = check.uniform(0, 1) ? ALPHA_STRAIGHT : ALPHA_PREMULTIPLIED;
+    std::vector<uchar> src(4 * pixels), dst(3 * pixels);
+    fillRandom(check, src);
+    fillRandom(check, dst);
+    if (mode == ALPHA_PREMULTIPLIED)
+        for (int i = 0; i < pixels; ++i)
+            for (int c = 0; c < 3; ++c)
+                src[4 * i + c] = std::min(src[4 * i + c], src[4 * i + 3]);
+
+    std::vector<uchar> expected = dst, out = dst;
+    compositeOverRow_Serial(src.data(), expected.data(), pixels, mode);
+    compositeOverRow_SSE(src.data(), out.data(), pixels, mode);
+    check.expect(firstMismatch(expected.data(), out.data(), out.size()) < 0, "compositeOverRow_SSE", std::to_string(pixels) + " pixels");
+    if (avx2)
+    {
+        out = dst;
+        compositeOverRow_AVX2(src.data(), out.data(), pixels, mode);
+        check.expect(firstMismatch(expected.data(), out.data(), out.size()) < 0, "compositeOverRow_AVX2", std::to_string(pixels) + " pixels");
+    }
+}
+
+inline void checkMotionRows(KernelCheck &check, bool avx2)
+{
+    int cols = std::max(1, check.length(100));
+    int blocks = (cols + MOTION_BLOCK - 1) / MOTION_BLOCK;
+    std::vector<uchar> cur(cols), prev(cols), bgr(3 * cols);
+    fillRandom(check, cur);
+    fillRandom(check, prev);
+    fillRandom(check, bgr);
+
+    // Block SAD of one row
+    std::vector<int> expected(blocks, 0), sad(blocks, 0);
+    for (int col = 0; col < cols; ++col)
+        expected[col / MOTION_BLOCK] += std::abs(cur[col] - prev[col]);
+    blockSADRow_SSE(cur.data(), prev.data(), cols, sad.data());
+    check.expect(expected == sad, "blockSADRow_SSE", std::to_string(cols) + " columns");
+    if (avx2)
+    {
+        std::fill(sad.begin(), sad.end(), 0);
+        blockSADRow_AVX2(cur.data(), prev.data(), cols, sad.data());
+        check.expect(expected == sad, "blockSADRow_AVX2", std::to_string(cols) + " columns");
+    }
+
+    // Fused luma, difference and threshold count of one row
+    uchar threshold = static_cast<uchar>(check.uniform(0, 255));
+    std::vector<uchar> lumaRef(cols), diffRef(cols), luma(cols), diff(cols);
+    std::vector<int> countsRef(blocks, 0), counts(blocks, 0);
+    for (int col = 0; col < cols; ++col)
+    {
+        lumaRef[col] = lumaBGR(&bgr[3 * col]);
+        diffRef[col] = static_cast<uchar>(std::abs(lumaRef[col] - prev[col]));
+        countsRef[col >> 4] += diffRef[col] > threshold;
+    }
+    fusedMotionRow_SSE(bgr.data(), prev.data(), luma.data(), diff.data(), cols, threshold, counts.data());
+    check.expect(lumaRef == luma && diffRef == diff && countsRef == counts, "fusedMotionRow_SSE", std::to_string(cols) + " columns");
+}
+
+inline void checkPyramidRows(KernelCheck &check)
+{
+    int cols = std::max(1, check.length(100));
+    std::vector<uchar> rows[4], cur(cols), prev(cols);
+    for (std::vector<uchar> &row : rows)
+    {
+        row.resize(cols);
+        fillRandom(check, row);
+    }
+    fillRandom(check, cur);
+    fillRandom(check, prev);
+    std::string size = std::to_string(cols) + " columns";
+
+    std::vector<uchar> expected((cols + 1) / 2), out((cols + 1) / 2);
+    pyrDownRow_Serial(rows[0].data(), rows[1].data(), expected.data(), cols);
+    pyrDownRow_SSE(rows[0].data(), rows[1].data(), out.data(), cols);
+    check.expect(expected == out, "pyrDownRow_SSE", size);
+
+    const uchar *four[4] = {rows[0].data(), rows[1].data(), rows[2].data(), rows[3].data()};
+    expected.assign((cols + 3) / 4, 0);
+    out.assign((cols + 3) / 4, 0);
+    pyrDown4x4Row_Serial(four, expected.data(), cols);
+    pyrDown4x4Row_SSE(four, out.data(), cols);
+    check.expect(expected == out, "pyrDown4x4Row_SSE", size);
+
+    std::vector<int> sadRef((cols + 7) / 8, 0), sad((cols + 7) / 8, 0);
+    for (int col = 0; col < cols; ++col)
+        sadRef[col / 8] += std::abs(cur[col] - prev[col]);
+    tileSADRow_SSE(cur.data(), prev.data(), cols, sad.data());
+    check.expect(sadRef == sad, "tileSADRow_SSE", size);
+}
+
+inline void checkBackgroundModel(KernelCheck &check, bool avx2)
+{
+    BackgroundParams params;
+    params.mode = check.uniform(0, 1) ? BG_GAUSSIAN : BG_RUNNING_AVERAGE;
+    params.learningRate = check.uniformf(0.0f, 1.0f);
+    params.threshold = check.uniform(0, 255);
+    params.k = check.uniformf(0.5f, 3.9f);
+    params.minVariance = check.uniform(0, 1000);
+    int rows = check.uniform(1, 4), cols = std::max(1, check.length(70));
+
+    // Scalar, SSE and (when available) AVX2 models fed the same frames
+    BackgroundModel models[3] = {BackgroundModel(params), BackgroundModel(params), BackgroundModel(params)};
+    int variants = avx2 ? 3 : 2;
+    for (int frame = 0; frame < 4; ++frame)
+    {
+        std::vector<uchar> storage;
+        cv::Mat gray = stridedMat(storage, rows, cols, 1, check.uniform(0, 3));
+        fillRandom(check, storage);
+
+        cv::Mat masks[3], backgrounds[3];
+        for (int isa = 0; isa < variants; ++isa)
+        {
+            models[isa].apply(gray, masks[isa], isa);
+            models[isa].background(backgrounds[isa]);
+        }
+        for (int isa = 1; isa < variants; ++isa)
+        {
+            bool same = true;
+            for (int row = 0; row < rows && same; ++row)
+                same = firstMismatch(masks[0].ptr<uchar>(row), masks[isa].ptr<uchar>(row), cols) < 0 &&
+                       firstMismatch(backgrounds[0].ptr<uchar>(row), backgrounds[isa].ptr<uchar>(row), cols) < 0;
+            check.expect(same, isa == 1 ? "BackgroundModel SSE" : "BackgroundModel AVX2",
+                         checkSize(rows, cols) + (params.mode == BG_GAUSSIAN ? " gaussian" : " running average") + ", frame " + std::to_string(frame));
+        }
+    }
+}
+#endif
+
+// Runs every check `rounds` times from `seed`; prints a line per kernel and
+// returns the number of mismatches
+inline int runKernelChecks(unsigned seed, int rounds, bool verbose)
+{
+    KernelCheck check(seed, verbose);
+#ifdef PP_WITH_OPENCV
+    const bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+    for (int round = 0; round < rounds; ++round)
+    {
+        checkOutliers(check);
+        checkColumnar(check);
+        checkRle(check);
+        checkBitRle(check);
+        checkResample(check);
+        if (round % 4 == 0)
+        {
+            checkFractals(check);
+            checkBuddhabrot(check);
+        }
+#ifdef PP_WITH_OPENCV
+        checkAbsDiff(check);
+        checkBlendRows(check, avx2);
+        checkCompositeRows(check, avx2);
+        checkMotionRows(check, avx2);
+        checkPyramidRows(check);
+        if (round % 4 == 0)
+            checkBackgroundModel(check, avx2);
+#endif
+    }
+
+    for (const auto &entry : check.tallies)
+        std::cout << "  " << entry.first << ": " << entry.second.cases << " cases, " << entry.second.failures << " failures\n";
+    return check.failures();
+}
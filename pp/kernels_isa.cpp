@@ -0,0 +1,171 @@
+// One instruction-set variant of every kernel. CMake compiles this file once
+// per entry of PP_ISA_VARIANTS with PP_ISA=<name> and that ISA's -m flags, so
+// the header-only kernels (and their OpenMP outlined bodies) are code-generated
+// for each target. Each copy lives in namespace pp_isa_<name>, and CMake then
+// localizes every symbol of the object but ppKernelTable_<name>, so the std
+// templates it instantiates are not shared with the other variants either.
+
+#include "pp_kernels.hpp"
+
+// Everything the kernel headers include, pulled in first so it stays outside
+// the variant namespace (the include guards stop the nested includes)
+#include <omp.h>
+#include <immintrin.h>
+#include <smmintrin.h>
+#include <tmmintrin.h>
+#include <xmmintrin.h>
+#include <x86intrin.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../common/perf_counters.hpp"
+#include "../common/numa_affinity.hpp"
+#include "../CA_2/antialias.hpp"
+#ifdef PP_WITH_OPENCV
+#include <opencv2/opencv.hpp>
+#endif
+
+#ifndef PP_ISA
+#error "PP_ISA must name the variant being compiled"
+#endif
+
+#define PP_CONCAT_(a, b) a##b
+#define PP_CONCAT(a, b) PP_CONCAT_(a, b)
+#define PP_STRING_(a) #a
+#define PP_STRING(a) PP_STRING_(a)
+
+namespace PP_CONCAT(pp_isa_, PP_ISA)
+{
+
+#include "../CA_2/q1/mandelbrot.hpp"
+#include "../CA_2/q1/buddhabrot.hpp"
+#include "../CA_2/q2/julia.hpp"
+#include "../CA_2/q3/monte_carlo.hpp"
+#include "../CA_1/codes/Q2/outliers.hpp"
+#include "../CA_1/codes/Q2/columnar.hpp"
+#include "../CA_1/codes/Q3/rle.hpp"
+#include "../CA_1/codes/Q3/bit_rle.hpp"
+#include "../CA_1/codes/resample.hpp"
+#ifdef PP_WITH_OPENCV
+#include "../CA_1/codes/Q1/blend_engine.hpp"
+#include "../CA_1/codes/Q1/alpha_composite.hpp"
+#include "../CA_1/codes/Q4/abs_diff.hpp"
+#include "../CA_1/codes/Q4/motion_regions.hpp"
+#include "../CA_1/codes/Q4/fused_motion.hpp"
+#include "../CA_1/codes/Q4/background_model.hpp"
+#include "../CA_1/codes/Q4/pyramid_motion.hpp"
+#endif
+#include "kernel_checks.hpp"
+
+static void mandelbrotKernel(int width, int height, float xMin, float xMax, float yMin, float yMax, PixelBuffer &rgb, bool parallel, int chunk)
+{
+    if (parallel)
+        generate_mandelbrot_parallel(width, height, xMin, xMax, yMin, yMax, rgb, chunk);
+    else
+        generate_mandelbrot_serial(width, height, xMin, xMax, yMin, yMax, rgb);
+}
+
+static void juliaKernel(int width, int height, float xMin, float xMax, float yMin, float yMax, PixelBuffer &rgb, bool parallel, int chunk)
+{
+    if (parallel)
+        julia_set::generate_julia_set_parallel(width, height, xMin, xMax, yMin, yMax, rgb, chunk);
+    else
+        julia_set::generate_julia_set_serial(width, height, xMin, xMax, yMin, yMax, rgb);
+}
+
+static AAStats mandelbrotAAKernel(int width, int height, float xMin, float xMax, float yMin, float yMax, PixelBuffer &rgb, const AAOptions &opt)
+{
+    return generate_mandelbrot_antialiased(width, height, xMin, xMax, yMin, yMax, rgb, opt);
+}
+
+static AAStats juliaAAKernel(int width, int height, float xMin, float xMax, float yMin, float yMax, PixelBuffer &rgb, const AAOptions &opt)
+{
+    return julia_set::generate_julia_set_antialiased(width, height, xMin, xMax, yMin, yMax, rgb, opt);
+}
+
+static double monteCarloKernel(long samples, bool parallel)
+{
+    return parallel ? monte_carlo_parallel(samples) : monte_carlo_serial(samples);
+}
+
+static int outliersKernel(float *array, int size, float *mean, float *stddev, bool simd)
+{
+    if (simd)
+    {
+        meanAndSTD_Parallel(array, size, mean, stddev);
+        return countOutliers_Parallel(array, size, *mean, *stddev);
+    }
+    meanAndSTD_Serial(array, size, mean, stddev);
+    return countOutliers_Serial(array, size, *mean, *stddev);
+}
+
+static std::string rleKernel(const std::string &input, bool simd)
+{
+    return simd ? rle_compress_simd(input) : rle_compress_serial(input);
+}
+
+static int verifyKernels(unsigned seed, int rounds, bool verbose)
+{
+    return runKernelChecks(seed, rounds, verbose);
+}
+
+#ifdef PP_WITH_OPENCV
+static void blendKernel(const cv::Mat &image, const cv::Mat &logo, cv::Mat &dst, float alpha, int threads)
+{
+    // The engine's widest row kernel this variant may use
+#ifdef __AVX2__
+    BlendISA isa = std::min(detectBlendISA(), BLEND_AVX2);
+#else
+    BlendISA isa = std::min(detectBlendISA(), BLEND_SSE);
+#endif
+    const float alpha3[3] = {alpha, alpha, alpha};
+    mergePhotosWeighted_Engine(image, logo, dst, alpha3, threads, isa);
+}
+
+static PPMotionResult motionKernel(const cv::Mat &cur, const cv::Mat &prev, double pixelThreshold, cv::Mat &sad)
+{
+    MotionAnalysis analysis = analyzeMotion(cur, prev, pixelThreshold, sad);
+    PPMotionResult result;
+    result.movingBlocks = analysis.movingBlocks;
+    result.regions = static_cast<int>(analysis.regions.size());
+    result.score = analysis.score;
+    result.meanAbsDiff = analysis.meanAbsDiff;
+    return result;
+}
+#endif
+
+static const PPKernelTable table = {
+    PP_STRING(PP_ISA),
+    mandelbrotKernel,
+    juliaKernel,
+    monteCarloKernel,
+    mandelbrotAAKernel,
+    juliaAAKernel,
+    outliersKernel,
+    rleKernel,
+    verifyKernels,
+#ifdef PP_WITH_OPENCV
+    blendKernel,
+    motionKernel,
+#endif
+};
+
+} // namespace pp_isa_<PP_ISA>
+
+const PPKernelTable *PP_CONCAT(ppKernelTable_, PP_ISA)()
+{
+    return &PP_CONCAT(pp_isa_, PP_ISA)::table;
+}
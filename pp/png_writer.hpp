@@ -0,0 +1,119 @@
+#pragma once
+
+// Minimal in-memory PNG encoder for 8-bit RGB images (the tile server's
+// output format). With zlib (PP_WITH_ZLIB) the image data is deflated, each
+// row with the "Sub" filter; without it the rows go into stored (uncompressed)
+// deflate blocks, which every decoder still accepts.
+
+#include <stdint.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#ifdef PP_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+inline uint32_t pngCrc32(const unsigned char *data, size_t size, uint32_t crc = 0)
+{
+    static const std::vector<uint32_t> table = []
+    {
+        std::vector<uint32_t> t(256);
+        for (uint32_t n = 0; n < 256; n++)
+        {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++)
+                c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            t[n] = c;
+        }
+        return t;
+    }();
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++)
+        crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+inline void pngPut32(std::string &out, uint32_t v)
+{
+    out.push_back((char)(v >> 24));
+    out.push_back((char)(v >> 16));
+    out.push_back((char)(v >> 8));
+    out.push_back((char)v);
+}
+
+inline void pngChunk(std::string &out, const char *type, const std::string &data)
+{
+    pngPut32(out, (uint32_t)data.size());
+    size_t start = out.size();
+    out.append(type, 4);
+    out += data;
+    pngPut32(out, pngCrc32((const unsigned char *)out.data() + start, out.size() - start));
+}
+
+// zlib stream of the filtered scanlines
+inline std::string pngDeflate(const std::vector<unsigned char> &raw)
+{
+#ifdef PP_WITH_ZLIB
+    uLongf size = compressBound((uLong)raw.size());
+    std::string deflated(size, '\0');
+    if (compress2((Bytef *)&deflated[0], &size, raw.data(), (uLong)raw.size(), 6) == Z_OK)
+    {
+        deflated.resize(size);
+        return deflated;
+    }
+#endif
+    // zlib header (deflate, 32K window, no preset dictionary), stored blocks, Adler-32
+    std::string out("\x78\x01", 2);
+    size_t pos = 0;
+    do
+    {
+        size_t len = std::min<size_t>(raw.size() - pos, 65535);
+        out.push_back(pos + len == raw.size() ? 1 : 0);
+        out.push_back((char)(len & 0xff));
+        out.push_back((char)(len >> 8));
+        out.push_back((char)(~len & 0xff));
+        out.push_back((char)((~len >> 8) & 0xff));
+        out.append((const char *)raw.data() + pos, len);
+        pos += len;
+    } while (pos < raw.size());
+
+    uint32_t a = 1, b = 0;
+    for (unsigned char c : raw)
+    {
+        a = (a + c) % 65521;
+        b = (b + a) % 65521;
+    }
+    pngPut32(out, (b << 16) | a);
+    return out;
+}
+
+// `rgb` holds height rows of 3 * width bytes
+inline std::string encodePNG(int width, int height, const unsigned char *rgb)
+{
+    size_t stride = 3 * (size_t)width;
+    std::vector<unsigned char> raw((stride + 1) * height);
+    for (int y = 0; y < height; y++)
+    {
+        unsigned char *row = &raw[(stride + 1) * y];
+        const unsigned char *src = rgb + stride * y;
+#ifdef PP_WITH_ZLIB
+        // Sub filter: fractal bands are mostly flat horizontally
+        row[0] = 1;
+        for (size_t i = 0; i < stride; i++)
+            row[1 + i] = (unsigned char)(src[i] - (i >= 3 ? src[i - 3] : 0));
+#else
+        row[0] = 0;
+        std::copy(src, src + stride, row + 1);
+#endif
+    }
+
+    std::string out("\x89PNG\r\n\x1a\n", 8);
+    std::string header;
+    pngPut32(header, (uint32_t)width);
+    pngPut32(header, (uint32_t)height);
+    header += std::string("\x08\x02\x00\x00\x00", 5); // 8-bit RGB, deflate, no interlace
+    pngChunk(out, "IHDR", header);
+    pngChunk(out, "IDAT", pngDeflate(raw));
+    pngChunk(out, "IEND", std::string());
+    return out;
+}
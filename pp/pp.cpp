@@ -0,0 +1,483 @@
+#include <omp.h>
+#include <csignal>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "pp_kernels.hpp"
+#include "tile_server.hpp"
+#include "../bench/tuning.hpp"
+#ifdef PP_WITH_OPENCV
+#include "../CA_1/codes/image_resampler.hpp"
+#endif
+
+// One front end for every kernel in libppkernels. The kernels run from the
+// ISA variant picked at start-up (widest supported, or --isa / $PP_ISA).
+// Parallel render and pi runs use the variant, thread count and row chunk
+// from the tuning cache (bench/tuning.hpp), tuning them on first use.
+
+// Set when --isa or $PP_ISA chose the variant; the tuner then leaves it alone
+static bool isaForced = false;
+
+static void usage(const char *argv0)
+{
+    std::cerr << "Usage: " << argv0 << " [--isa sse42|avx2|avx512] [--list-isa] <command> [args]\n"
+              << "  render mandelbrot|julia [size] [--serial | --aa [samples]] [--out file.ppm]\n"
+              << "  rle <string> [--serial]\n"
+              << "  outliers [size] [--serial]\n"
+              << "  pi [samples] [--serial]\n"
+              << "  verify [rounds] [seed]\n"
+              << "  serve [port] [--cache-mb N] [--spill dir]\n"
+#ifdef PP_WITH_OPENCV
+              << "  blend <image> <logo> [alpha] [out.png]\n"
+              << "  motion <video> [pixelThreshold]\n"
+#endif
+        ;
+}
+
+static double secondsSince(std::chrono::high_resolution_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// Positional arguments and the flags of one command
+struct CommandArgs
+{
+    std::vector<std::string> positional;
+    bool serial = false;
+    int aaSamples = 0; // --aa: adaptive anti-aliasing with this many subsamples per edge pixel
+    std::string out;
+    int cacheMB = 64;     // serve: memory tile cache
+    std::string spillDir; // serve: where evicted tiles go
+};
+
+static CommandArgs parseCommandArgs(int argc, char **argv, int first)
+{
+    CommandArgs args;
+    for (int i = first; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--serial") == 0)
+            args.serial = true;
+        else if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+            args.out = argv[++i];
+        else if (std::strcmp(argv[i], "--cache-mb") == 0 && i + 1 < argc)
+            args.cacheMB = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--spill") == 0 && i + 1 < argc)
+            args.spillDir = argv[++i];
+        else if (std::strcmp(argv[i], "--aa") == 0)
+            args.aaSamples = i + 1 < argc && std::atoi(argv[i + 1]) > 0 ? std::atoi(argv[++i]) : AAOptions().samples;
+        else
+            args.positional.push_back(argv[i]);
+    }
+    return args;
+}
+
+static bool writePPM(const std::string &path, int width, int height, const PixelBuffer &rgb)
+{
+    FILE *fp = std::fopen(path.c_str(), "wb");
+    if (!fp)
+    {
+        std::cerr << "Error opening file " << path << " for writing.\n";
+        return false;
+    }
+    std::fprintf(fp, "P6\n%d %d\n255\n", width, height);
+    std::fwrite(rgb.data(), 1, rgb.size(), fp);
+    std::fclose(fp);
+    return true;
+}
+
+static const PPKernelTable &kernelsFor(const PPKernelTable &fallback, const std::string &isa)
+{
+    for (const PPKernelTable *table : ppSupportedKernels())
+        if (isa == table->isa)
+            return *table;
+    return fallback;
+}
+
+static TuneSpace tuneSpaceFor(const PPKernelTable &k, int rows)
+{
+    TuneSpace space;
+    if (isaForced)
+        space.isas = {k.isa};
+    else
+    {
+        std::vector<const PPKernelTable *> tables = ppSupportedKernels();
+        for (auto it = tables.rbegin(); it != tables.rend(); ++it)
+            space.isas.push_back((*it)->isa);
+    }
+    space.threads = tuneThreadCandidates();
+    if (rows > 0)
+        space.chunks = tuneChunkCandidates(rows, space.threads.front());
+    return space;
+}
+
+// Cache key of a pp kernel; a forced ISA gets its own entry
+static std::string tuneKey(const PPKernelTable &k, const std::string &kernel)
+{
+    return "pp." + kernel + (isaForced ? std::string(".") + k.isa : "");
+}
+
+static void printTuned(const TuneConfig &tuned)
+{
+    std::cerr << "[pp] tuned: " << tuned.isa << ", " << tuned.threads << " threads"
+              << (tuned.chunk ? ", chunk " + std::to_string(tuned.chunk) : "") << "\n";
+}
+
+static int runRender(const PPKernelTable &k, const CommandArgs &args)
+{
+    if (args.positional.empty() || (args.positional[0] != "mandelbrot" && args.positional[0] != "julia"))
+    {
+        std::cerr << "render: expected mandelbrot or julia\n";
+        return 1;
+    }
+    const bool mandelbrot = args.positional[0] == "mandelbrot";
+    int side = args.positional.size() > 1 ? std::atoi(args.positional[1].c_str()) : 1000;
+    if (side <= 0)
+    {
+        std::cerr << "render: size must be positive\n";
+        return 1;
+    }
+    // The fractal kernels index the RGB buffer with int
+    const size_t bytes = (size_t)3 * side * side;
+    if (bytes > (size_t)INT_MAX)
+    {
+        std::cerr << "render: " << side << "x" << side << " is too large (at most " << (size_t)INT_MAX / 3 << " pixels)\n";
+        return 1;
+    }
+
+    PixelBuffer rgb(bytes);
+    firstTouchRows(rgb, (size_t)3 * side, side);
+
+    if (args.aaSamples > 0)
+    {
+        AAOptions opt;
+        opt.samples = args.aaSamples;
+        auto start = std::chrono::high_resolution_clock::now();
+        AAStats aa = mandelbrot ? k.mandelbrotAA(side, side, -2.0f, 1.0f, -1.5f, 1.5f, rgb, opt)
+                                : k.juliaAA(side, side, -2.0f, 2.0f, -2.0f, 2.0f, rgb, opt);
+        double seconds = secondsSince(start);
+        std::cout << args.positional[0] << " " << side << "x" << side << " anti-aliased: " << seconds << " s, "
+                  << 100 * aa.edgeFraction() << "% edge pixels, " << aa.samples << " samples ("
+                  << 100 * aa.costVersusFullSSAA(opt.samples) << "% of full " << opt.samples << "x SSAA)\n";
+        std::string out = args.out.empty() ? args.positional[0] + "_aa.ppm" : args.out;
+        return writePPM(out, side, side, rgb) ? 0 : 1;
+    }
+
+    auto render = [&](const PPKernelTable &kernels, bool parallel, int chunk)
+    {
+        if (mandelbrot)
+            kernels.mandelbrot(side, side, -2.0f, 1.0f, -1.5f, 1.5f, rgb, parallel, chunk);
+        else
+            kernels.julia(side, side, -2.0f, 2.0f, -2.0f, 2.0f, rgb, parallel, chunk);
+    };
+
+    TuneConfig tuned;
+    tuned.chunk = 1;
+    const PPKernelTable *kernels = &k;
+    if (!args.serial)
+    {
+        TuningCache cache;
+        tuned = autotune(cache, tuneKey(k, args.positional[0]), (double)side * side, tuneSpaceFor(k, side), [&](const TuneConfig &c)
+                         {
+            omp_set_num_threads(c.threads);
+            render(kernelsFor(k, c.isa), true, c.chunk); });
+        kernels = &kernelsFor(k, tuned.isa);
+        omp_set_num_threads(tuned.threads);
+        printTuned(tuned);
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    render(*kernels, !args.serial, tuned.chunk);
+    double seconds = secondsSince(start);
+
+    std::cout << args.positional[0] << " " << side << "x" << side << (args.serial ? " serial" : " parallel")
+              << ": " << seconds << " s, " << (double)side * side / seconds / 1e6 << " Mpixel/s\n";
+
+    std::string out = args.out.empty() ? args.positional[0] + ".ppm" : args.out;
+    return writePPM(out, side, side, rgb) ? 0 : 1;
+}
+
+static int runRle(const PPKernelTable &k, const CommandArgs &args)
+{
+    if (args.positional.empty())
+    {
+        std::cerr << "rle: expected an input string\n";
+        return 1;
+    }
+    const std::string &input = args.positional[0];
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::string encoded = k.rle(input, !args.serial);
+    double seconds = secondsSince(start);
+
+    std::cout << encoded << "\n"
+              << (args.serial ? "serial" : "simd") << ": " << input.size() << " -> " << encoded.size()
+              << " bytes in " << seconds << " s\n";
+    return 0;
+}
+
+static int runOutliers(const PPKernelTable &k, const CommandArgs &args)
+{
+    int size = args.positional.empty() ? (1 << 20) : std::atoi(args.positional[0].c_str());
+    if (size <= 0)
+    {
+        std::cerr << "outliers: size must be positive\n";
+        return 1;
+    }
+    std::vector<float> data(size);
+    std::mt19937 gen(42);
+    std::normal_distribution<float> dist(0.0f, 1.0f);
+    for (float &v : data)
+        v = dist(gen);
+
+    float mean = 0, stddev = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    int count = k.outliers(data.data(), size, &mean, &stddev, !args.serial);
+    double seconds = secondsSince(start);
+
+    std::cout << (args.serial ? "serial" : "simd") << ": " << size << " values, mean " << mean << ", stddev "
+              << stddev << ", " << count << " outliers in " << seconds << " s\n";
+    return 0;
+}
+
+static int runPi(const PPKernelTable &k, const CommandArgs &args)
+{
+    long samples = args.positional.empty() ? 10000000L : std::atol(args.positional[0].c_str());
+    if (samples <= 0)
+    {
+        std::cerr << "pi: samples must be positive\n";
+        return 1;
+    }
+
+    const PPKernelTable *kernels = &k;
+    if (!args.serial)
+    {
+        TuningCache cache;
+        TuneConfig tuned = autotune(cache, tuneKey(k, "pi"), (double)samples, tuneSpaceFor(k, 0), [&](const TuneConfig &c)
+                                    {
+            omp_set_num_threads(c.threads);
+            benchDoNotOptimize(kernelsFor(k, c.isa).monteCarloPi(samples, true)); });
+        kernels = &kernelsFor(k, tuned.isa);
+        omp_set_num_threads(tuned.threads);
+        printTuned(tuned);
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    double pi = kernels->monteCarloPi(samples, !args.serial);
+    double seconds = secondsSince(start);
+
+    std::cout << (args.serial ? "serial" : "parallel") << ": pi ~ " << pi << " from " << samples << " samples in "
+              << seconds << " s\n";
+    return 0;
+}
+
+// Fuzzed SIMD-vs-serial checks of every variant this CPU can run (only the
+// forced one with --isa / $PP_ISA); non-zero exit status on any mismatch
+static int runVerify(const PPKernelTable &k, const CommandArgs &args)
+{
+    int rounds = args.positional.empty() ? 200 : std::atoi(args.positional[0].c_str());
+    unsigned seed = args.positional.size() > 1 ? std::strtoul(args.positional[1].c_str(), nullptr, 10) : std::random_device()();
+    if (rounds <= 0)
+    {
+        std::cerr << "verify: rounds must be positive\n";
+        return 1;
+    }
+
+    std::vector<const PPKernelTable *> tables = isaForced ? std::vector<const PPKernelTable *>{&k} : ppSupportedKernels();
+    int failures = 0;
+    for (const PPKernelTable *table : tables)
+    {
+        std::cout << table->isa << " (seed " << seed << ", " << rounds << " rounds):\n";
+        failures += table->verify(seed, rounds, false);
+    }
+    std::cout << (failures ? "FAILED: " + std::to_string(failures) + " mismatches" : std::string("all kernels match their serial references")) << "\n";
+    return failures ? 1 : 0;
+}
+
+static TileServer *activeServer = nullptr;
+
+static void stopServer(int)
+{
+    if (activeServer)
+        activeServer->stop();
+}
+
+// Tile server until Ctrl-C; the metrics are printed on the way out
+static int runServe(const PPKernelTable &k, const CommandArgs &args)
+{
+    TileServerOptions opt;
+    opt.port = args.positional.empty() ? 8080 : std::atoi(args.positional[0].c_str());
+    opt.cacheBytes = (size_t)std::max(1, args.cacheMB) << 20;
+    opt.spillDir = args.spillDir;
+    if (opt.port <= 0 || opt.port > 65535)
+    {
+        std::cerr << "serve: port must be 1-65535\n";
+        return 1;
+    }
+
+    // Tuned on the deepest-iterating tile, the whole set at zoom 0
+    TuningCache cache;
+    PixelBuffer rgb(3 * TILE_SIZE * TILE_SIZE);
+    TuneConfig tuned = autotune(cache, tuneKey(k, "tile"), (double)TILE_SIZE * TILE_SIZE, tuneSpaceFor(k, TILE_SIZE), [&](const TuneConfig &c)
+                                {
+        omp_set_num_threads(c.threads);
+        kernelsFor(k, c.isa).mandelbrot(TILE_SIZE, TILE_SIZE, -2.0f, 1.0f, -1.5f, 1.5f, rgb, true, c.chunk); });
+    printTuned(tuned);
+    opt.renderThreads = tuned.threads;
+    opt.chunk = tuned.chunk;
+
+    TileServer server(kernelsFor(k, tuned.isa), opt);
+    activeServer = &server;
+    std::signal(SIGINT, stopServer);
+    std::signal(SIGTERM, stopServer);
+    bool ok = server.run();
+    activeServer = nullptr;
+    if (ok)
+        std::cout << server.metrics();
+    return ok ? 0 : 1;
+}
+
+#ifdef PP_WITH_OPENCV
+static int runBlend(const PPKernelTable &k, const CommandArgs &args)
+{
+    if (args.positional.size() < 2)
+    {
+        std::cerr << "blend: expected <image> <logo>\n";
+        return 1;
+    }
+    cv::Mat image = cv::imread(args.positional[0], cv::IMREAD_COLOR);
+    cv::Mat logo = cv::imread(args.positional[1], cv::IMREAD_COLOR);
+    if (image.empty() || logo.empty())
+    {
+        std::cerr << "Error loading images!" << std::endl;
+        return 1;
+    }
+    float alpha = args.positional.size() > 2 ? std::atof(args.positional[2].c_str()) : 0.5f;
+    std::string out = args.positional.size() > 3 ? args.positional[3] : "blend.png";
+
+    cv::Mat logoScaled, merged;
+    ImageResampler(RESAMPLE_LANCZOS3).apply(logo, logoScaled, image.size());
+
+    auto start = std::chrono::high_resolution_clock::now();
+    k.blend(image, logoScaled, merged, alpha, 0);
+    double seconds = secondsSince(start);
+
+    std::cout << "blend " << image.cols << "x" << image.rows << ": " << seconds << " s\n";
+    return cv::imwrite(out, merged) ? 0 : 1;
+}
+
+static int runMotion(const PPKernelTable &k, const CommandArgs &args)
+{
+    if (args.positional.empty())
+    {
+        std::cerr << "motion: expected a video path\n";
+        return 1;
+    }
+    double pixelThreshold = args.positional.size() > 1 ? std::atof(args.positional[1].c_str()) : 25.0;
+
+    cv::VideoCapture cap(args.positional[0]);
+    if (!cap.isOpened())
+    {
+        std::cerr << "Error opening video file" << std::endl;
+        return 1;
+    }
+
+    cv::Mat frame, gray, prevGray, sad;
+    long frames = 0, movingFrames = 0;
+    double kernelSeconds = 0;
+    while (cap.read(frame) && !frame.empty())
+    {
+        cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
+        if (!prevGray.empty())
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            PPMotionResult motion = k.motion(gray, prevGray, pixelThreshold, sad);
+            kernelSeconds += secondsSince(start);
+            if (motion.movingBlocks > 0)
+                ++movingFrames;
+        }
+        std::swap(gray, prevGray);
+        ++frames;
+    }
+
+    std::cout << "motion: " << frames << " frames, " << movingFrames << " with motion, " << kernelSeconds
+              << " s in the kernel\n";
+    return 0;
+}
+#endif
+
+int main(int argc, char **argv)
+{
+    int i = 1;
+    for (; i < argc && argv[i][0] == '-'; ++i)
+    {
+        std::string flag = argv[i];
+        if (flag == "--isa" && i + 1 < argc)
+        {
+            isaForced = true;
+            if (!ppSelectISA(argv[++i]))
+            {
+                std::cerr << "ISA " << argv[i] << " is not built into libppkernels or not supported by this CPU\n";
+                return 1;
+            }
+        }
+        else if (flag == "--list-isa")
+        {
+            const PPKernelTable *active = ppKernelsOrNull();
+            for (const PPKernelTable *table : ppSupportedKernels())
+                std::cout << table->isa << (table == active ? " (selected)" : "") << "\n";
+            return 0;
+        }
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (i >= argc)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    const char *envISA = std::getenv("PP_ISA");
+    if (envISA && *envISA)
+        isaForced = true;
+
+    const PPKernelTable &k = ppKernels();
+    std::string command = argv[i];
+    CommandArgs args = parseCommandArgs(argc, argv, i + 1);
+    std::cerr << "[pp] " << command << " using the " << k.isa << " kernels"
+              << (isaForced || (command != "render" && command != "pi" && command != "serve") ? "" : " (parallel runs may pick another variant from the tuning cache)") << "\n";
+
+    if (command == "render")
+        return runRender(k, args);
+    if (command == "rle")
+        return runRle(k, args);
+    if (command == "outliers")
+        return runOutliers(k, args);
+    if (command == "pi")
+        return runPi(k, args);
+    if (command == "verify")
+        return runVerify(k, args);
+    if (command == "serve")
+        return runServe(k, args);
+#ifdef PP_WITH_OPENCV
+    if (command == "blend")
+        return runBlend(k, args);
+    if (command == "motion")
+        return runMotion(k, args);
+#else
+    if (command == "blend" || command == "motion")
+    {
+        std::cerr << command << ": this build has no OpenCV\n";
+        return 1;
+    }
+#endif
+    usage(argv[0]);
+    return 1;
+}
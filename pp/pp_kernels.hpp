@@ -0,0 +1,74 @@
+#pragma once
+
+// Public interface of libppkernels: every kernel of the course projects,
+// compiled once per instruction set (kernels_isa.cpp) and selected at run time.
+//
+//   const PPKernelTable &k = ppKernels();   // best variant for this CPU
+//   k.mandelbrot(1000, 1000, -2, 1, -1.5, 1.5, rgb, true);
+//
+// Only global types cross this interface; each per-ISA copy of the kernels,
+// with the std code it instantiates, is private to its variant object.
+
+#include <string>
+#include <vector>
+#include "../common/numa_affinity.hpp"
+#include "../CA_2/antialias.hpp"
+#ifdef PP_WITH_OPENCV
+#include <opencv2/opencv.hpp>
+#endif
+
+struct PPMotionResult
+{
+    int movingBlocks = 0;
+    int regions = 0;
+    double score = 0;       // fraction of 16x16 blocks that moved
+    double meanAbsDiff = 0; // over the whole frame
+};
+
+struct PPKernelTable
+{
+    const char *isa; // "sse42", "avx2" or "avx512"
+
+    // CA_2: fractals into a 3 * width * height RGB buffer (parallel runs hand out
+    // `chunk` rows at a time), and Monte Carlo pi
+    void (*mandelbrot)(int width, int height, float xMin, float xMax, float yMin, float yMax, PixelBuffer &rgb, bool parallel, int chunk);
+    void (*julia)(int width, int height, float xMin, float xMax, float yMin, float yMax, PixelBuffer &rgb, bool parallel, int chunk);
+    double (*monteCarloPi)(long samples, bool parallel);
+
+    // CA_2: adaptive anti-aliased fractals (1 spp, supersampled edges)
+    AAStats (*mandelbrotAA)(int width, int height, float xMin, float xMax, float yMin, float yMax, PixelBuffer &rgb, const AAOptions &opt);
+    AAStats (*juliaAA)(int width, int height, float xMin, float xMax, float yMin, float yMax, PixelBuffer &rgb, const AAOptions &opt);
+
+    // CA_1 Q2: z-score outliers, also returns mean and standard deviation
+    int (*outliers)(float *array, int size, float *mean, float *stddev, bool simd);
+
+    // CA_1 Q3: run-length encoding
+    std::string (*rle)(const std::string &input, bool simd);
+
+    // Fuzzed comparison of every SIMD / parallel kernel of this variant with its
+    // serial reference (kernel_checks.hpp); prints a line per kernel and returns
+    // the number of mismatches
+    int (*verify)(unsigned seed, int rounds, bool verbose);
+
+#ifdef PP_WITH_OPENCV
+    // CA_1 Q1: dst = saturate(image + (int)(logo * alpha)), rows split over `threads` (0 = OpenCV's count)
+    void (*blend)(const cv::Mat &image, const cv::Mat &logo, cv::Mat &dst, float alpha, int threads);
+
+    // CA_1 Q4: block SAD between two gray frames and connected motion regions
+    PPMotionResult (*motion)(const cv::Mat &cur, const cv::Mat &prev, double pixelThreshold, cv::Mat &sad);
+#endif
+};
+
+// Variant for this CPU: the widest supported ISA, or the one named by $PP_ISA
+// (or ppSelectISA) when the CPU supports it. Returns null on CPUs without SSE4.2.
+const PPKernelTable *ppKernelsOrNull();
+
+// As above; exits with a message when no variant can run on this CPU
+const PPKernelTable &ppKernels();
+
+// Every variant built into the library that this CPU can run, narrowest first
+std::vector<const PPKernelTable *> ppSupportedKernels();
+
+// Force a variant by name; false when it is not built or not supported here.
+// Must be called before the first ppKernels().
+bool ppSelectISA(const std::string &isa);
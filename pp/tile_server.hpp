@@ -0,0 +1,629 @@
+#pragma once
+
+// Local HTTP tile server over libppkernels (`pp serve`), for browsing the
+// fractals interactively instead of re-running a program per view.
+//
+//   GET /{mandelbrot|julia}/{z}/{x}/{y}.png   256x256 tile; zoom z splits the
+//                                             default view into 2^z x 2^z tiles
+//   GET /viewport/{set}/{z}/{x0}/{y0}/{x1}/{y1}  tiles the client shows now
+//   GET /metrics                              cache and latency counters (text)
+//   GET /                                     small pan / zoom viewer
+//
+// - Encoded tiles live in a memory-bounded LRU cache. Evicted tiles are
+//   written to the spill directory, if there is one, and read back on a miss.
+// - Concurrent requests for a tile that is being rendered wait for that one
+//   render instead of starting their own.
+// - One renderer thread owns the OpenMP team, so a tile renders with every
+//   core. It takes tiles inside the current viewport first, nearest to its
+//   centre first, then the rest in arrival order.
+//
+// The server listens on 127.0.0.1 only.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <omp.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "pp_kernels.hpp"
+#include "png_writer.hpp"
+
+const int TILE_SIZE = 256;
+const int TILE_MAX_ZOOM = 24; // float coordinates run out of precision around here
+
+struct TileKey
+{
+    std::string set; // "mandelbrot" or "julia"
+    int z = 0, x = 0, y = 0;
+
+    std::string str() const { return set + "/" + std::to_string(z) + "/" + std::to_string(x) + "/" + std::to_string(y); }
+};
+
+// Splits "/a/b/c" into {"a", "b", "c"}
+inline std::vector<std::string> tilePathParts(const std::string &path)
+{
+    std::vector<std::string> parts;
+    std::stringstream ss(path);
+    std::string part;
+    while (std::getline(ss, part, '/'))
+        if (!part.empty())
+            parts.push_back(part);
+    return parts;
+}
+
+inline bool parseTileInt(const std::string &s, int &value)
+{
+    if (s.empty() || s.size() > 9 || s.find_first_not_of("0123456789") != std::string::npos)
+        return false;
+    value = std::atoi(s.c_str());
+    return true;
+}
+
+inline bool validTile(const TileKey &key)
+{
+    return (key.set == "mandelbrot" || key.set == "julia") && key.z >= 0 && key.z <= TILE_MAX_ZOOM && key.x >= 0 &&
+           key.y >= 0 && key.x < (1 << key.z) && key.y < (1 << key.z);
+}
+
+// "/mandelbrot/3/2/5.png"
+inline bool parseTilePath(const std::string &path, TileKey &key)
+{
+    std::vector<std::string> parts = tilePathParts(path);
+    if (parts.size() != 4 || parts[3].size() < 5 || parts[3].compare(parts[3].size() - 4, 4, ".png") != 0)
+        return false;
+    key.set = parts[0];
+    return parseTileInt(parts[1], key.z) && parseTileInt(parts[2], key.x) &&
+           parseTileInt(parts[3].substr(0, parts[3].size() - 4), key.y) && validTile(key);
+}
+
+// Zoom 0 is the view `pp render` uses for the set; rows grow with y, as in the kernels.
+// The Mandelbrot kernel maps pixels onto [min, max), the Julia one onto
+// [min, max] with both ends sampled (julia_coord), so Julia tiles end one
+// pixel short of the next tile's first column and row.
+inline void tileBounds(const TileKey &key, float &xMin, float &xMax, float &yMin, float &yMax)
+{
+    bool mandelbrot = key.set == "mandelbrot";
+    double x0 = -2.0, y0 = mandelbrot ? -1.5 : -2.0;
+    double extent = mandelbrot ? 3.0 : 4.0;
+    double span = extent / (double)(1 << key.z);
+    double end = mandelbrot ? span : span - span / TILE_SIZE;
+    xMin = (float)(x0 + key.x * span);
+    xMax = (float)(x0 + key.x * span + end);
+    yMin = (float)(y0 + key.y * span);
+    yMax = (float)(y0 + key.y * span + end);
+}
+
+// Mean, max and quantiles over the last `window` samples
+class LatencyStats
+{
+public:
+    explicit LatencyStats(size_t window = 1024) : window(window) {}
+
+    void add(double seconds)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (recent.size() < window)
+            recent.push_back(seconds);
+        else
+            recent[count % window] = seconds;
+        ++count;
+        total += seconds;
+        maximum = std::max(maximum, seconds);
+    }
+
+    // Prometheus-style lines for metric `name`
+    void report(std::ostream &out, const std::string &name) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<double> sorted(recent);
+        std::sort(sorted.begin(), sorted.end());
+        for (double q : {0.5, 0.9, 0.99})
+            out << name << "{quantile=\"" << q << "\"} " << (sorted.empty() ? 0 : sorted[(size_t)(q * (sorted.size() - 1))]) << "\n";
+        out << name << "_count " << count << "\n"
+            << name << "_mean " << (count ? total / count : 0) << "\n"
+            << name << "_max " << maximum << "\n";
+    }
+
+private:
+    size_t window;
+    std::vector<double> recent;
+    long count = 0;
+    double total = 0, maximum = 0;
+    mutable std::mutex mutex;
+};
+
+// LRU of encoded tiles, bounded by their total size in bytes. With a spill
+// directory, evicted tiles are written there (tiles never change, so a file
+// that exists is never rewritten) and loadSpilled() reads them back.
+class TileCache
+{
+public:
+    TileCache(size_t maxBytes, const std::string &spillDir) : maxBytes(maxBytes), spillDir(spillDir)
+    {
+        if (!spillDir.empty())
+            ::mkdir(spillDir.c_str(), 0755);
+    }
+
+    bool get(const std::string &key, std::string &png)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(key);
+        if (it == index.end())
+            return false;
+        lru.splice(lru.begin(), lru, it->second);
+        png = it->second->second;
+        return true;
+    }
+
+    void put(const std::string &key, const std::string &png)
+    {
+        std::vector<std::pair<std::string, std::string>> evicted;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (index.count(key))
+                return;
+            lru.emplace_front(key, png);
+            index[key] = lru.begin();
+            bytes += png.size();
+            while (bytes > maxBytes && lru.size() > 1)
+            {
+                bytes -= lru.back().second.size();
+                index.erase(lru.back().first);
+                evicted.push_back(std::move(lru.back()));
+                lru.pop_back();
+                ++evictions;
+            }
+        }
+        // File I/O outside the lock
+        for (const auto &e : evicted)
+            spill(e.first, e.second);
+    }
+
+    bool loadSpilled(const std::string &key, std::string &png) const
+    {
+        if (spillDir.empty())
+            return false;
+        std::ifstream in(spillPath(key), std::ios::binary);
+        if (!in)
+            return false;
+        png.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        return !png.empty();
+    }
+
+    void report(std::ostream &out) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        out << "tile_cache_bytes " << bytes << "\n"
+            << "tile_cache_max_bytes " << maxBytes << "\n"
+            << "tile_cache_entries " << lru.size() << "\n"
+            << "tile_cache_evictions " << evictions << "\n"
+            << "tile_cache_spilled " << spilled << "\n";
+    }
+
+private:
+    std::string spillPath(const std::string &key) const
+    {
+        std::string name = key;
+        std::replace(name.begin(), name.end(), '/', '_');
+        return spillDir + "/" + name + ".png";
+    }
+
+    void spill(const std::string &key, const std::string &png)
+    {
+        if (spillDir.empty())
+            return;
+        std::string path = spillPath(key);
+        struct stat st;
+        if (::stat(path.c_str(), &st) == 0)
+            return;
+        // Written under a temporary name, so loadSpilled() never reads half a tile
+        std::string tmp = path + ".tmp." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+        std::ofstream out(tmp, std::ios::binary);
+        out.write(png.data(), (std::streamsize)png.size());
+        out.close();
+        if (!out || std::rename(tmp.c_str(), path.c_str()) != 0)
+        {
+            std::cerr << "Error writing file " << path << "\n";
+            std::remove(tmp.c_str());
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        ++spilled;
+    }
+
+    size_t maxBytes;
+    std::string spillDir;
+    std::list<std::pair<std::string, std::string>> lru; // most recently used first
+    std::unordered_map<std::string, std::list<std::pair<std::string, std::string>>::iterator> index;
+    size_t bytes = 0;
+    long evictions = 0, spilled = 0;
+    mutable std::mutex mutex;
+};
+
+struct TileServerOptions
+{
+    int port = 8080;
+    size_t cacheBytes = 64 << 20;
+    std::string spillDir;       // empty: no disk spill
+    int connectionThreads = 8;  // concurrent HTTP connections
+    int renderThreads = 0;      // OpenMP threads per tile; 0 = default
+    int chunk = 1;              // schedule(dynamic, chunk) rows
+};
+
+class TileServer
+{
+public:
+    TileServer(const PPKernelTable &kernels, const TileServerOptions &opt) : kernels(kernels), opt(opt), cache(opt.cacheBytes, opt.spillDir) {}
+
+    // Serves until stop(); false if the port cannot be opened
+    bool run()
+    {
+        listenFd = ::socket(AF_INET, SOCK_STREAM, 0);
+        int yes = 1;
+        ::setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons((uint16_t)opt.port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (listenFd < 0 || ::bind(listenFd, (sockaddr *)&addr, sizeof(addr)) != 0 || ::listen(listenFd, 64) != 0)
+        {
+            std::cerr << "Error listening on 127.0.0.1:" << opt.port << "\n";
+            if (listenFd >= 0)
+                ::close(listenFd);
+            return false;
+        }
+        std::cerr << "[pp] serving tiles on http://127.0.0.1:" << opt.port << "/\n";
+
+        std::thread renderer(&TileServer::renderLoop, this);
+        std::vector<std::thread> workers;
+        for (int i = 0; i < std::max(1, opt.connectionThreads); i++)
+            workers.emplace_back(&TileServer::connectionLoop, this);
+
+        while (!stopping)
+        {
+            int fd = ::accept(listenFd, nullptr, nullptr);
+            if (fd < 0)
+                continue;
+            std::lock_guard<std::mutex> lock(connectionMutex);
+            connections.push_back(fd);
+            connectionReady.notify_one();
+        }
+        ::close(listenFd);
+
+        // Finish the open connections, then the tiles they still wait for
+        {
+            std::lock_guard<std::mutex> lock(connectionMutex);
+            connectionsClosed = true;
+            connectionReady.notify_all();
+        }
+        for (std::thread &w : workers)
+            w.join();
+        {
+            std::lock_guard<std::mutex> lock(jobMutex);
+            renderStop = true;
+            jobReady.notify_all();
+        }
+        renderer.join();
+        return true;
+    }
+
+    // Async-signal-safe: accept() returns once the socket is shut down
+    void stop()
+    {
+        stopping = true;
+        ::shutdown(listenFd, SHUT_RDWR);
+    }
+
+    std::string metrics() const
+    {
+        std::ostringstream out;
+        long total = requests, hits = memoryHits + diskHits;
+        out << "tile_requests " << total << "\n"
+            << "tile_memory_hits " << memoryHits << "\n"
+            << "tile_disk_hits " << diskHits << "\n"
+            << "tile_coalesced " << coalesced << "\n"
+            << "tile_renders " << renders << "\n"
+            << "tile_hit_rate " << (total ? (double)hits / total : 0) << "\n";
+        {
+            std::lock_guard<std::mutex> lock(jobMutex);
+            out << "tile_queue_depth " << jobs.size() << "\n";
+        }
+        cache.report(out);
+        renderLatency.report(out, "tile_render_seconds");
+        requestLatency.report(out, "tile_request_seconds");
+        return out.str();
+    }
+
+private:
+    struct Job
+    {
+        TileKey key;
+        long sequence;
+        std::promise<std::string> png;
+    };
+
+    struct Viewport
+    {
+        bool valid = false;
+        std::string set;
+        int z = 0, x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+    };
+
+    // Lower renders first: (viewport tier, distance from its centre, arrival)
+    bool before(const Job &a, const Job &b) const
+    {
+        auto rank = [this](const Job &j, int &tier, double &distance)
+        {
+            tier = 0;
+            distance = 0;
+            if (!viewport.valid)
+                return;
+            if (j.key.set != viewport.set || j.key.z != viewport.z)
+            {
+                tier = 2;
+                return;
+            }
+            bool inside = j.key.x >= viewport.x0 && j.key.x <= viewport.x1 && j.key.y >= viewport.y0 && j.key.y <= viewport.y1;
+            tier = inside ? 0 : 1;
+            distance = std::hypot(j.key.x - 0.5 * (viewport.x0 + viewport.x1), j.key.y - 0.5 * (viewport.y0 + viewport.y1));
+        };
+        int ta, tb;
+        double da, db;
+        rank(a, ta, da);
+        rank(b, tb, db);
+        if (ta != tb)
+            return ta < tb;
+        if (da != db)
+            return da < db;
+        return a.sequence < b.sequence;
+    }
+
+    void renderLoop()
+    {
+        if (opt.renderThreads > 0)
+            omp_set_num_threads(opt.renderThreads);
+        PixelBuffer rgb(3 * TILE_SIZE * TILE_SIZE);
+        firstTouchRows(rgb, 3 * TILE_SIZE, TILE_SIZE);
+
+        while (true)
+        {
+            std::unique_ptr<Job> job;
+            {
+                std::unique_lock<std::mutex> lock(jobMutex);
+                jobReady.wait(lock, [this]
+                              { return !jobs.empty() || renderStop; });
+                if (jobs.empty())
+                    return;
+                auto best = jobs.begin();
+                for (auto it = jobs.begin(); it != jobs.end(); ++it)
+                    if (before(**it, **best))
+                        best = it;
+                job = std::move(*best);
+                jobs.erase(best);
+            }
+
+            auto start = std::chrono::high_resolution_clock::now();
+            float xMin, xMax, yMin, yMax;
+            tileBounds(job->key, xMin, xMax, yMin, yMax);
+            if (job->key.set == "mandelbrot")
+                kernels.mandelbrot(TILE_SIZE, TILE_SIZE, xMin, xMax, yMin, yMax, rgb, true, opt.chunk);
+            else
+                kernels.julia(TILE_SIZE, TILE_SIZE, xMin, xMax, yMin, yMax, rgb, true, opt.chunk);
+            std::string png = encodePNG(TILE_SIZE, TILE_SIZE, rgb.data());
+            renderLatency.add(std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count());
+            ++renders;
+
+            // Cached before it stops being in flight, so no request sees neither
+            std::string key = job->key.str();
+            cache.put(key, png);
+            {
+                std::lock_guard<std::mutex> lock(jobMutex);
+                inFlight.erase(key);
+            }
+            job->png.set_value(std::move(png));
+        }
+    }
+
+    std::string tile(const TileKey &key)
+    {
+        std::string k = key.str(), png;
+        ++requests;
+        if (cache.get(k, png))
+        {
+            ++memoryHits;
+            return png;
+        }
+        if (cache.loadSpilled(k, png))
+        {
+            ++diskHits;
+            cache.put(k, png);
+            return png;
+        }
+
+        std::shared_future<std::string> pending;
+        {
+            std::lock_guard<std::mutex> lock(jobMutex);
+            auto it = inFlight.find(k);
+            if (it != inFlight.end())
+            {
+                ++coalesced;
+                pending = it->second;
+            }
+            else if (cache.get(k, png)) // rendered since the first look
+            {
+                ++memoryHits;
+                return png;
+            }
+            else
+            {
+                std::unique_ptr<Job> job(new Job);
+                job->key = key;
+                job->sequence = nextSequence++;
+                pending = job->png.get_future().share();
+                inFlight[k] = pending;
+                jobs.push_back(std::move(job));
+                jobReady.notify_one();
+            }
+        }
+        return pending.get();
+    }
+
+    void connectionLoop()
+    {
+        while (true)
+        {
+            int fd;
+            {
+                std::unique_lock<std::mutex> lock(connectionMutex);
+                connectionReady.wait(lock, [this]
+                                     { return !connections.empty() || connectionsClosed; });
+                if (connections.empty())
+                    return;
+                fd = connections.front();
+                connections.pop_front();
+            }
+            handleConnection(fd);
+            ::close(fd);
+        }
+    }
+
+    void handleConnection(int fd)
+    {
+        timeval timeout = {5, 0}; // a stalled client does not hold a worker for long
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        std::string request;
+        char buf[2048];
+        while (request.find("\r\n\r\n") == std::string::npos && request.size() < 8192)
+        {
+            ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+            if (n <= 0)
+                return;
+            request.append(buf, n);
+        }
+        std::istringstream line(request.substr(0, request.find("\r\n")));
+        std::string method, target;
+        line >> method >> target;
+        target = target.substr(0, target.find('?'));
+
+        if (method != "GET")
+            return respond(fd, "405 Method Not Allowed", "text/plain", "GET only\n");
+        if (target == "/")
+            return respond(fd, "200 OK", "text/html", viewerPage());
+        if (target == "/metrics")
+            return respond(fd, "200 OK", "text/plain", metrics());
+
+        std::vector<std::string> parts = tilePathParts(target);
+        if (parts.size() == 7 && parts[0] == "viewport")
+        {
+            Viewport v;
+            v.set = parts[1];
+            TileKey corner{v.set, 0, 0, 0};
+            if (!parseTileInt(parts[2], v.z) || !parseTileInt(parts[3], v.x0) || !parseTileInt(parts[4], v.y0) ||
+                !parseTileInt(parts[5], v.x1) || !parseTileInt(parts[6], v.y1) || !(corner.z = v.z, validTile(corner)))
+                return respond(fd, "400 Bad Request", "text/plain", "bad viewport\n");
+            v.valid = true;
+            {
+                std::lock_guard<std::mutex> lock(jobMutex);
+                viewport = v;
+            }
+            return respond(fd, "204 No Content", "text/plain", "");
+        }
+
+        TileKey key;
+        if (!parseTilePath(target, key))
+            return respond(fd, "404 Not Found", "text/plain", "expected /{mandelbrot|julia}/{z}/{x}/{y}.png\n");
+        auto start = std::chrono::high_resolution_clock::now();
+        std::string png = tile(key);
+        requestLatency.add(std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count());
+        respond(fd, "200 OK", "image/png", png, "Cache-Control: max-age=86400\r\n");
+    }
+
+    static void respond(int fd, const std::string &status, const std::string &type, const std::string &body, const std::string &headers = "")
+    {
+        std::string response = "HTTP/1.1 " + status + "\r\nContent-Type: " + type + "\r\nContent-Length: " +
+                               std::to_string(body.size()) + "\r\n" + headers + "Connection: close\r\n\r\n" + body;
+        for (size_t sent = 0; sent < response.size();)
+        {
+            ssize_t n = ::send(fd, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0)
+                return;
+            sent += n;
+        }
+    }
+
+    // Drag to pan, wheel to zoom, m / j to switch sets; reports its viewport to the server
+    static std::string viewerPage()
+    {
+        return R"(<!DOCTYPE html>
+<html><head><title>pp tiles</title><style>
+body{margin:0;overflow:hidden;background:#000;font:13px sans-serif;color:#ccc}
+#map{position:absolute;inset:0;cursor:grab}#map img{position:absolute;width:256px;height:256px;image-rendering:pixelated}
+#info{position:absolute;left:8px;top:8px;background:#000a;padding:4px 8px}
+</style></head><body><div id="map"></div><div id="info"></div><script>
+const T=256,map=document.getElementById('map'),info=document.getElementById('info');
+let set='mandelbrot',z=1,cx=1,cy=1,drag=null;
+function draw(){const n=1<<z,w=innerWidth,h=innerHeight;
+ const x0=Math.max(0,Math.floor(cx-w/2/T)),x1=Math.min(n-1,Math.floor(cx+w/2/T)),
+       y0=Math.max(0,Math.floor(cy-h/2/T)),y1=Math.min(n-1,Math.floor(cy+h/2/T));
+ fetch(`/viewport/${set}/${z}/${x0}/${y0}/${x1}/${y1}`);
+ map.replaceChildren();
+ for(let y=y0;y<=y1;y++)for(let x=x0;x<=x1;x++){const i=new Image();
+  i.src=`/${set}/${z}/${x}/${y}.png`;i.style.left=(w/2+(x-cx)*T)+'px';i.style.top=(h/2+(y-cy)*T)+'px';map.appendChild(i);}
+ info.textContent=`${set}  zoom ${z}  (m / j: switch set)  `;
+ fetch('/metrics').then(r=>r.text()).then(t=>{const m=/tile_hit_rate (\S+)/.exec(t);if(m)info.textContent+=`hit rate ${(+m[1]*100).toFixed(1)}%`;});}
+map.onmousedown=e=>drag=[e.clientX,e.clientY,cx,cy];onmouseup=()=>drag=null;
+onmousemove=e=>{if(!drag)return;cx=drag[2]-(e.clientX-drag[0])/T;cy=drag[3]-(e.clientY-drag[1])/T;draw();};
+map.onwheel=e=>{e.preventDefault();const nz=Math.max(0,Math.min(24,z+(e.deltaY<0?1:-1)));if(nz==z)return;
+ const mx=cx+(e.clientX-innerWidth/2)/T,my=cy+(e.clientY-innerHeight/2)/T,s=Math.pow(2,nz-z);
+ cx=mx*s-(e.clientX-innerWidth/2)/T;cy=my*s-(e.clientY-innerHeight/2)/T;z=nz;draw();};
+onkeydown=e=>{if(e.key=='m'||e.key=='j'){set=e.key=='m'?'mandelbrot':'julia';draw();}};
+onresize=draw;draw();
+</script></body></html>
+)";
+    }
+
+    const PPKernelTable &kernels;
+    TileServerOptions opt;
+    TileCache cache;
+    LatencyStats renderLatency, requestLatency;
+    std::atomic<long> requests{0}, memoryHits{0}, diskHits{0}, coalesced{0}, renders{0};
+
+    int listenFd = -1;
+    std::atomic<bool> stopping{false};
+
+    std::deque<int> connections;
+    bool connectionsClosed = false;
+    std::mutex connectionMutex;
+    std::condition_variable connectionReady;
+
+    // Render queue, tiles in flight and the viewport, under jobMutex
+    std::vector<std::unique_ptr<Job>> jobs;
+    std::unordered_map<std::string, std::shared_future<std::string>> inFlight;
+    Viewport viewport;
+    long nextSequence = 0;
+    bool renderStop = false;
+    mutable std::mutex jobMutex;
+    std::condition_variable jobReady;
+};